@@ -80,14 +80,44 @@ public:
    * @param wetL Left wet signal to apply envelope to (modified in place)
    * @param wetR Right wet signal to apply envelope to (modified in place)
    */
-  void processBlock(float inputL, float inputR, float& wetL, float& wetR) {
+  template <typename SampleType>
+  void processBlock(SampleType inputL, SampleType inputR, SampleType& wetL,
+                    SampleType& wetR) {
     // Use peak of stereo input for trigger detection
-    float inputLevel = std::max(std::abs(inputL), std::abs(inputR));
-    float env = process(inputLevel);
+    float inputLevel =
+        static_cast<float>(std::max(std::abs(inputL), std::abs(inputR)));
+    const auto env = static_cast<SampleType>(process(inputLevel));
     wetL *= env;
     wetR *= env;
   }
 
+  /**
+   * @brief Apply envelope to one N-channel frame
+   * @param input Per-channel input (peak across channels triggers)
+   * @param wet Per-channel wet signal (modified in place)
+   */
+  template <typename SampleType>
+  void processFrame(const SampleType* input, SampleType* wet,
+                    int numChannels) {
+    SampleType peak = 0;
+    for (int ch = 0; ch < numChannels; ++ch)
+      peak = std::max(peak, std::abs(input[ch]));
+    processPeak(static_cast<float>(peak), wet, numChannels);
+  }
+
+  /**
+   * @brief Apply envelope to one N-channel frame whose input peak is known
+   *        (e.g. from a shared InputAnalysis)
+   * @param peak Peak of the input across channels
+   * @param wet Per-channel wet signal (modified in place)
+   */
+  template <typename SampleType>
+  void processPeak(float peak, SampleType* wet, int numChannels) {
+    const auto env = static_cast<SampleType>(process(peak));
+    for (int ch = 0; ch < numChannels; ++ch)
+      wet[ch] *= env;
+  }
+
   float getEnvelope() const { return envelope_; }
   float getAttackTimeMs() const { return attackTimeMs_; }
   float getReleaseTimeMs() const { return releaseTimeMs_; }
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <chowdsp_wdf/chowdsp_wdf.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace uds {
+
+namespace wdft = chowdsp::wdft;
+
+/**
+ * @brief Clock maths for a bucket-brigade delay chip
+ *
+ * A BBD of kStages buckets delays by kStages / (2 * clock), so the clock
+ * (and with it the usable bandwidth) falls as the delay time grows. The
+ * anti-aliasing and reconstruction filters of real units are set well
+ * below the clock's Nyquist; kBandwidthRatio places them there.
+ */
+struct BBDClock {
+  static constexpr double kStages = 4096.0; // MN3005-class chip
+  static constexpr double kBandwidthRatio = 1.0 / 3.0;
+  static constexpr double kMinCutoffHz = 1000.0;
+  static constexpr double kMaxCutoffHz = 15000.0;
+
+  static double clockHz(double delayMs) {
+    return kStages / (2.0 * std::max(delayMs, 1.0) * 0.001);
+  }
+
+  /** @brief Filter corner for a given delay time (clamped) */
+  static double cutoffHz(double delayMs) {
+    return std::clamp(clockHz(delayMs) * kBandwidthRatio, kMinCutoffHz,
+                      kMaxCutoffHz);
+  }
+};
+
+/**
+ * @brief Two-pole RC ladder: the BBD anti-aliasing / reconstruction filter
+ *
+ * Vin -R1-+-R2-+
+ *         C1   C2    (output across C2)
+ *
+ * The tree is built from chowdsp_wdf templates, so the whole filter
+ * resolves at compile time with no virtual dispatch. The second section
+ * uses a 10x larger resistor and 10x smaller capacitor so it barely loads
+ * the first; both resistors are retuned when the clock moves.
+ */
+template <typename SampleType> class BBDFilterWDF {
+public:
+  static constexpr SampleType kC1 = SampleType(10.0e-9);
+  static constexpr SampleType kC2 = SampleType(1.0e-9);
+
+  BBDFilterWDF() = default;
+  BBDFilterWDF(const BBDFilterWDF&) = delete; // Adaptors hold references
+  BBDFilterWDF& operator=(const BBDFilterWDF&) = delete;
+
+  void prepare(double sampleRate) {
+    c1_.prepare(static_cast<SampleType>(sampleRate));
+    c2_.prepare(static_cast<SampleType>(sampleRate));
+  }
+
+  void reset() {
+    c1_.reset();
+    c2_.reset();
+  }
+
+  /** @brief Corner frequency of each RC section */
+  void setCutoff(SampleType cutoffHz) {
+    const SampleType w = SampleType(2.0 * 3.14159265358979323846) * cutoffHz;
+    r1_.setResistanceValue(SampleType(1) / (w * kC1));
+    r2_.setResistanceValue(SampleType(1) / (w * kC2));
+  }
+
+  SampleType process(SampleType x) noexcept {
+    vin_.setVoltage(x);
+    vin_.incident(inverter_.reflected());
+    inverter_.incident(vin_.reflected());
+    return wdft::voltage<SampleType>(c2_);
+  }
+
+private:
+  wdft::ResistorT<SampleType> r2_{SampleType(10.0e3)};
+  wdft::CapacitorT<SampleType> c2_{kC2};
+  wdft::WDFSeriesT<SampleType, decltype(r2_), decltype(c2_)> s2_{r2_, c2_};
+
+  wdft::CapacitorT<SampleType> c1_{kC1};
+  wdft::WDFParallelT<SampleType, decltype(c1_), decltype(s2_)> p1_{c1_, s2_};
+
+  wdft::ResistorT<SampleType> r1_{SampleType(1.0e3)};
+  wdft::WDFSeriesT<SampleType, decltype(r1_), decltype(p1_)> s1_{r1_, p1_};
+
+  wdft::PolarityInverterT<SampleType, decltype(s1_)> inverter_{s1_};
+  wdft::IdealVoltageSourceT<SampleType, decltype(inverter_)> vin_{inverter_};
+};
+
+/**
+ * @brief Compander level detector (NE570-style rectifier into an RC)
+ *
+ * The full-wave rectified signal charges the averaging capacitor through
+ * the chip's internal 10k, giving the ~10 ms time constant whose lag
+ * behind transients is the compander's "breathing".
+ */
+template <typename SampleType> class CompanderDetectorWDF {
+public:
+  CompanderDetectorWDF() = default;
+  CompanderDetectorWDF(const CompanderDetectorWDF&) = delete;
+  CompanderDetectorWDF& operator=(const CompanderDetectorWDF&) = delete;
+
+  void prepare(double sampleRate) {
+    c_.prepare(static_cast<SampleType>(sampleRate));
+  }
+
+  void reset() { c_.reset(); }
+
+  /** @brief Average rectified level of x */
+  SampleType process(SampleType x) noexcept {
+    vin_.setVoltage(std::abs(x));
+    vin_.incident(inverter_.reflected());
+    inverter_.incident(vin_.reflected());
+    return wdft::voltage<SampleType>(c_);
+  }
+
+private:
+  wdft::ResistorT<SampleType> r_{SampleType(10.0e3)};
+  wdft::CapacitorT<SampleType> c_{SampleType(1.0e-6)};
+  wdft::WDFSeriesT<SampleType, decltype(r_), decltype(c_)> s_{r_, c_};
+  wdft::PolarityInverterT<SampleType, decltype(s_)> inverter_{s_};
+  wdft::IdealVoltageSourceT<SampleType, decltype(inverter_)> vin_{inverter_};
+};
+
+/**
+ * @brief One channel of a BBD round trip
+ *
+ * compressor -> anti-aliasing filter -> bucket saturation ->
+ * reconstruction filter -> expander. The compressor divides by the square
+ * root of its input level and the expander multiplies by its own input
+ * level, so in steady state the pair cancels (2:1 then 1:2) while the
+ * detector lag and the filters between them colour transients.
+ */
+template <typename SampleType> class BBDChannel {
+public:
+  static constexpr SampleType kReferenceLevel = SampleType(0.25);
+  static constexpr SampleType kDetectorFloor = SampleType(0.0025); // +20 dB
+  static constexpr SampleType kBucketHeadroom = SampleType(0.5);
+
+  void prepare(double sampleRate) {
+    antiAliasing_.prepare(sampleRate);
+    reconstruction_.prepare(sampleRate);
+    compressorLevel_.prepare(sampleRate);
+    expanderLevel_.prepare(sampleRate);
+  }
+
+  void reset() {
+    antiAliasing_.reset();
+    reconstruction_.reset();
+    compressorLevel_.reset();
+    expanderLevel_.reset();
+  }
+
+  void setCutoff(SampleType cutoffHz) {
+    antiAliasing_.setCutoff(cutoffHz);
+    reconstruction_.setCutoff(cutoffHz);
+  }
+
+  SampleType process(SampleType x) noexcept {
+    const SampleType level =
+        std::max(compressorLevel_.process(x), kDetectorFloor);
+    const SampleType compressed = x * std::sqrt(kReferenceLevel / level);
+
+    const SampleType bucket = saturate(antiAliasing_.process(compressed));
+
+    const SampleType restored = reconstruction_.process(bucket);
+    return restored * (expanderLevel_.process(restored) / kReferenceLevel);
+  }
+
+private:
+  /**
+   * @brief Buckets clip softly at the chip's headroom
+   *
+   * Pade approximant of tanh, exact at +-3 where it meets the rails; a
+   * fraction of std::tanh's cost in the per-sample path.
+   */
+  static SampleType saturate(SampleType x) noexcept {
+    const SampleType c = std::clamp(x / kBucketHeadroom, SampleType(-3),
+                                    SampleType(3));
+    const SampleType c2 = c * c;
+    return kBucketHeadroom * c * (SampleType(27) + c2) /
+           (SampleType(27) + SampleType(9) * c2);
+  }
+
+  BBDFilterWDF<SampleType> antiAliasing_;
+  BBDFilterWDF<SampleType> reconstruction_;
+  CompanderDetectorWDF<SampleType> compressorLevel_;
+  CompanderDetectorWDF<SampleType> expanderLevel_;
+};
+
+} // namespace uds
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+namespace uds {
+
+/**
+ * @brief Maximum channel count handled by the delay matrix
+ *
+ * 7.1.4 needs 12; the headroom covers 9.1.6-style beds. Per-sample scratch
+ * frames are sized by this constant so the audio thread never allocates.
+ */
+constexpr int kMaxChannels = 16;
+
+/**
+ * @brief Bitmask selecting every channel (default per-band routing)
+ */
+constexpr uint32_t kAllChannels = 0xFFFFFFFFu;
+
+/**
+ * @brief Which side of the listener a channel sits on
+ *
+ * Pan controls are stereo controls: Left-side channels follow the left
+ * equal-power gain, Right-side channels the right gain, and Centre channels
+ * (C, LFE, top centre, mono) take the mean of the two.
+ */
+enum class ChannelSide : int8_t { Left = -1, Centre = 0, Right = 1 };
+
+/**
+ * @brief Fallback side when the host layout is unknown
+ *
+ * Mono is centred; otherwise channels alternate L/R, which matches stereo and
+ * discrete pair-wise layouts.
+ */
+inline ChannelSide defaultChannelSide(int channel, int numChannels) {
+  if (numChannels <= 1)
+    return ChannelSide::Centre;
+  return (channel % 2 == 0) ? ChannelSide::Left : ChannelSide::Right;
+}
+
+/**
+ * @brief Equal-power pan gain for a channel on the given side
+ * @param pan -1 (left) to +1 (right)
+ */
+inline float panGainForSide(ChannelSide side, float pan) {
+  const float angle = (pan + 1.0f) * 0.25f * 3.14159f;
+  switch (side) {
+  case ChannelSide::Left:
+    return std::cos(angle);
+  case ChannelSide::Right:
+    return std::sin(angle);
+  case ChannelSide::Centre:
+  default:
+    return 0.5f * (std::cos(angle) + std::sin(angle));
+  }
+}
+
+} // namespace uds
@@ -0,0 +1,225 @@
+#pragma once
+
+#include "Interpolation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+namespace uds {
+
+/**
+ * @brief Quality steps the CpuGovernor walks through (cheapest last)
+ *
+ * Each level includes every saving of the levels above it.
+ */
+enum class QualityLevel {
+  Full,                  // Everything as configured
+  CappedInterpolation,   // Lagrange/Allpass/Sinc bands read with Hermite
+  LinearInterpolation,   // Every band reads with Linear
+  ControlRateModulation, // LFOs computed at a reduced control rate
+  SleepQuietBands        // Idle bands with silent input skip processing
+};
+
+/**
+ * @brief Why the governor is at its current level (for the UI)
+ */
+enum class QualityReason {
+  Nominal,    // Full quality, load within budget
+  Overload,   // Stepped down: processBlock load above the step-down threshold
+  Recovering, // Load is low again; waiting out the hold time to step up
+  Disabled    // Adaptive quality switched off
+};
+
+/**
+ * @brief Adaptive CPU budget governor
+ *
+ * Measures the wall-clock time of each processBlock (steady clock) against
+ * the block's real-time budget (numSamples / sampleRate). When the smoothed
+ * load crosses the step-down threshold it lowers quality one level at a
+ * time, waiting kSettleSeconds between steps so each step's effect is
+ * measured before the next. Quality is restored one level at a time only
+ * after the load has stayed below the (lower) step-up threshold for
+ * kRecoverSeconds; the gap between the thresholds plus the hold time is
+ * the hysteresis that stops it oscillating.
+ *
+ * All timing is in seconds of audio, so behaviour does not depend on the
+ * host block size. update() runs on the audio thread; the level, reason
+ * and load getters are safe to poll from the UI.
+ */
+class CpuGovernor {
+public:
+  static constexpr int kNumLevels = 5;
+
+  // LFO control-rate stride at ControlRateModulation and below
+  static constexpr int kModulationControlStride = 16;
+
+  static constexpr double kSmoothingSeconds = 0.1;
+  static constexpr double kSettleSeconds = 0.25;
+  static constexpr double kRecoverSeconds = 2.0;
+
+  /**
+   * @brief Times one processBlock and feeds the result to the governor
+   */
+  class ScopedMeasurement {
+  public:
+    ScopedMeasurement(CpuGovernor& governor, int numSamples)
+        : governor_(governor), numSamples_(numSamples),
+          start_(std::chrono::steady_clock::now()) {}
+
+    ~ScopedMeasurement() {
+      const std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start_;
+      governor_.update(elapsed.count(), numSamples_);
+    }
+
+    ScopedMeasurement(const ScopedMeasurement&) = delete;
+    ScopedMeasurement& operator=(const ScopedMeasurement&) = delete;
+
+  private:
+    CpuGovernor& governor_;
+    int numSamples_;
+    std::chrono::steady_clock::time_point start_;
+  };
+
+  void prepare(double sampleRate) {
+    sampleRate_ = sampleRate > 0.0 ? sampleRate : 44100.0;
+    reset();
+  }
+
+  void reset() {
+    smoothedLoad_ = 0.0;
+    secondsSinceChange_ = 0.0;
+    secondsBelowStepUp_ = 0.0;
+    level_.store(static_cast<int>(QualityLevel::Full));
+    reason_.store(static_cast<int>(enabled_ ? QualityReason::Nominal
+                                            : QualityReason::Disabled));
+    load_.store(0.0f);
+  }
+
+  /**
+   * @brief Switch adaptation on/off (off = always Full quality)
+   */
+  void setEnabled(bool enabled) {
+    if (enabled == enabled_)
+      return;
+    enabled_ = enabled;
+    reset();
+  }
+
+  bool isEnabled() const { return enabled_; }
+
+  /**
+   * @brief Load thresholds as fractions of the block budget
+   * @param stepDownLoad Lower quality above this load (e.g. 0.5 = half the
+   *        block's real-time duration spent in processBlock)
+   * @param stepUpLoad Restore quality below this load (< stepDownLoad)
+   */
+  void setThresholds(float stepDownLoad, float stepUpLoad) {
+    stepDownLoad_ = std::max(stepDownLoad, 0.01f);
+    stepUpLoad_ = std::clamp(stepUpLoad, 0.0f, stepDownLoad_);
+  }
+
+  /**
+   * @brief Feed one measured block
+   * @param elapsedSeconds Wall-clock time spent processing the block
+   */
+  void update(double elapsedSeconds, int numSamples) {
+    if (numSamples <= 0)
+      return;
+
+    const double blockSeconds = numSamples / sampleRate_;
+    const double load = elapsedSeconds / blockSeconds;
+    const double alpha = 1.0 - std::exp(-blockSeconds / kSmoothingSeconds);
+    smoothedLoad_ += alpha * (load - smoothedLoad_);
+    load_.store(static_cast<float>(smoothedLoad_));
+
+    if (!enabled_)
+      return;
+
+    secondsSinceChange_ += blockSeconds;
+    int level = level_.load();
+
+    if (smoothedLoad_ > stepDownLoad_) {
+      secondsBelowStepUp_ = 0.0;
+      if (level < kNumLevels - 1 && secondsSinceChange_ >= kSettleSeconds) {
+        level_.store(++level);
+        secondsSinceChange_ = 0.0;
+      }
+      reason_.store(static_cast<int>(QualityReason::Overload));
+      return;
+    }
+
+    if (level == static_cast<int>(QualityLevel::Full)) {
+      reason_.store(static_cast<int>(QualityReason::Nominal));
+      return;
+    }
+
+    if (smoothedLoad_ < stepUpLoad_) {
+      secondsBelowStepUp_ += blockSeconds;
+      if (secondsBelowStepUp_ >= kRecoverSeconds) {
+        level_.store(--level);
+        secondsSinceChange_ = 0.0;
+        secondsBelowStepUp_ = 0.0;
+      }
+      reason_.store(static_cast<int>(
+          level == static_cast<int>(QualityLevel::Full)
+              ? QualityReason::Nominal
+              : QualityReason::Recovering));
+    } else {
+      // Between the thresholds: hold the current level
+      secondsBelowStepUp_ = 0.0;
+      reason_.store(static_cast<int>(QualityReason::Overload));
+    }
+  }
+
+  QualityLevel getLevel() const {
+    return static_cast<QualityLevel>(level_.load());
+  }
+  QualityReason getReason() const {
+    return static_cast<QualityReason>(reason_.load());
+  }
+
+  /**
+   * @brief Smoothed processBlock time as a fraction of the block budget
+   */
+  float getLoad() const { return load_.load(); }
+
+  // ==================== Quality decisions ====================
+
+  InterpolationType limitInterpolation(InterpolationType requested) const {
+    const auto level = getLevel();
+    if (level >= QualityLevel::LinearInterpolation)
+      return std::min(requested, InterpolationType::Linear);
+    if (level >= QualityLevel::CappedInterpolation)
+      return std::min(requested, InterpolationType::Hermite);
+    return requested;
+  }
+
+  int getModulationControlStride() const {
+    return getLevel() >= QualityLevel::ControlRateModulation
+               ? kModulationControlStride
+               : 1;
+  }
+
+  bool shouldSleepQuietBands() const {
+    return getLevel() >= QualityLevel::SleepQuietBands;
+  }
+
+private:
+  double sampleRate_ = 44100.0;
+  bool enabled_ = true;
+  float stepDownLoad_ = 0.5f;
+  float stepUpLoad_ = 0.25f;
+
+  double smoothedLoad_ = 0.0;
+  double secondsSinceChange_ = 0.0;
+  double secondsBelowStepUp_ = 0.0;
+
+  std::atomic<int> level_{static_cast<int>(QualityLevel::Full)};
+  std::atomic<int> reason_{static_cast<int>(QualityReason::Nominal)};
+  std::atomic<float> load_{0.0f};
+};
+
+} // namespace uds
@@ -1,6 +1,14 @@
 #pragma once
 
+#include "BBDModel.h"
+#include "ChannelLayout.h"
+#include "PitchShifter.h"
+
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 namespace uds {
@@ -10,19 +18,29 @@ namespace uds {
  */
 enum class DelayAlgorithmType {
   Digital, // Clean, precise, transparent
-  Analog,  // Subtle saturation, filter drift
+  Analog,  // Bucket brigade: clock-tracking filters, compander
   Tape,    // Wow/flutter, head saturation
-  LoFi     // Bitcrushing, noise
+  LoFi,    // Bitcrushing, noise
+  Shimmer  // Pitch-shifted feedback (each repeat transposed)
 };
 
+constexpr int kNumDelayAlgorithms = 5;
+
 /**
  * @brief Base interface for delay algorithms
  *
  * Each algorithm processes the feedback path differently to create
  * unique delay character. The core delay line is handled by DelayBandNode;
  * algorithms only process the signal within the feedback loop.
+ *
+ * Templated on sample type to match the owning DelayBandNode (float or
+ * double processing path).
+ *
+ * State is kept per channel as contiguous lanes (one array element per
+ * channel), so channels never share filter/hysteresis history and each
+ * step of an algorithm is one loop across the frame.
  */
-class DelayAlgorithm {
+template <typename SampleType> class DelayAlgorithm {
 public:
   virtual ~DelayAlgorithm() = default;
 
@@ -38,14 +56,54 @@ public:
   virtual void reset() = 0;
 
   /**
-   * @brief Process a single sample through the algorithm
+   * @brief Process one frame of the feedback path in place
+   *
+   * Channel ch uses state lane ch only.
+   *
+   * @param frame One sample per channel
+   * @param numChannels Channels in the frame (<= kMaxChannels)
+   */
+  virtual void processFrame(SampleType* frame, int numChannels) = 0;
+
+  /**
+   * @brief Follow the band's delay time (message rate, not per sample)
+   *
+   * Algorithms whose character depends on the delay time (the BBD clock)
+   * override this; the rest ignore it.
+   */
+  virtual void setDelayTime(double /*delayMs*/) {}
+
+  /**
+   * @brief Transposition per pass in semitones (pitch algorithms only)
+   */
+  virtual void setPitchSemitones(double /*semitones*/) {}
+
+  /**
+   * @brief Delay the algorithm adds to the feedback loop, in samples
+   *
+   * DelayBandNode reads the feedback this much earlier so the loop period
+   * still equals the band's delay time.
+   */
+  virtual double getLatencySamples() const { return 0.0; }
+
+  /**
+   * @brief True if the algorithm has nonlinearities that alias
    *
-   * This is called on samples in the feedback path to add character.
+   * DelayBandNode runs such algorithms at twice the sample rate in the
+   * offline high-quality mode.
+   */
+  virtual bool benefitsFromOversampling() const { return false; }
+
+  /**
+   * @brief Process a single sample through the algorithm (lane 0)
    *
    * @param sample Input sample
    * @return Processed sample with algorithm character applied
    */
-  virtual float processSample(float sample) = 0;
+  SampleType processSample(SampleType sample) {
+    processFrame(&sample, 1);
+    return sample;
+  }
 
   /**
    * @brief Get the algorithm type
@@ -64,7 +122,8 @@ public:
  * This is the "purist" delay with no processing in the feedback path.
  * Maximum clarity and precision.
  */
-class DigitalDelay : public DelayAlgorithm {
+template <typename SampleType>
+class DigitalDelay : public DelayAlgorithm<SampleType> {
 public:
   void prepare(double /*sampleRate*/) override {
     // No state needed for digital
@@ -74,9 +133,8 @@ public:
     // Nothing to reset
   }
 
-  float processSample(float sample) override {
+  void processFrame(SampleType* /*frame*/, int /*numChannels*/) override {
     // Pass through unchanged - digital is clean
-    return sample;
   }
 
   DelayAlgorithmType getType() const override {
@@ -87,37 +145,42 @@ public:
 };
 
 /**
- * @brief Analog delay - subtle saturation and filter drift
+ * @brief Analog delay - bucket-brigade (BBD) model
  *
- * Emulates BBD (bucket brigade) style delays with:
- * - Soft saturation on feedback
- * - Subtle high-frequency rolloff
- * - Slight noise floor
+ * Each feedback pass runs a BBD round trip (see BBDChannel): NE570-style
+ * compander around the chip, two-pole RC anti-aliasing and reconstruction
+ * filters, and soft bucket saturation. The filters are chowdsp_wdf trees
+ * whose corner follows the BBD clock, so longer delays get darker repeats,
+ * as on the hardware. Budget: within Tape's per-band cost (see
+ * DSPBenchmarks.cpp, "Band cost: Analog vs Tape").
  */
-class AnalogDelay : public DelayAlgorithm {
+template <typename SampleType>
+class AnalogDelay : public DelayAlgorithm<SampleType> {
 public:
   void prepare(double sampleRate) override {
     sampleRate_ = sampleRate;
-
-    // Simple one-pole lowpass for HF rolloff
-    // fc ~= 8kHz, gives warm analog character
-    float fc = 8000.0f;
-    float wc = 2.0f * 3.14159f * fc / static_cast<float>(sampleRate);
-    lpfCoeff_ = wc / (1.0f + wc);
-
+    for (auto& lane : lanes_)
+      lane.prepare(sampleRate);
+    applyCutoff();
     reset();
   }
 
-  void reset() override { lpfState_ = 0.0f; }
-
-  float processSample(float sample) override {
-    // Soft saturation (tanh-style)
-    float saturated = std::tanh(sample * 1.2f) * 0.9f;
+  void reset() override {
+    for (auto& lane : lanes_)
+      lane.reset();
+  }
 
-    // One-pole lowpass filter (HF rolloff)
-    lpfState_ += lpfCoeff_ * (saturated - lpfState_);
+  void setDelayTime(double delayMs) override {
+    const double cutoff = BBDClock::cutoffHz(delayMs);
+    if (cutoff == cutoffHz_)
+      return;
+    cutoffHz_ = cutoff;
+    applyCutoff();
+  }
 
-    return lpfState_;
+  void processFrame(SampleType* frame, int numChannels) override {
+    for (int ch = 0; ch < numChannels; ++ch)
+      frame[ch] = lanes_[static_cast<size_t>(ch)].process(frame[ch]);
   }
 
   DelayAlgorithmType getType() const override {
@@ -126,10 +189,19 @@ public:
 
   const char* getName() const override { return "Analog"; }
 
+  bool benefitsFromOversampling() const override { return true; }
+
+  double getCutoffHz() const { return cutoffHz_; }
+
 private:
+  void applyCutoff() {
+    for (auto& lane : lanes_)
+      lane.setCutoff(static_cast<SampleType>(cutoffHz_));
+  }
+
   double sampleRate_ = 44100.0;
-  float lpfCoeff_ = 0.5f;
-  float lpfState_ = 0.0f;
+  double cutoffHz_ = BBDClock::cutoffHz(250.0);
+  std::array<BBDChannel<SampleType>, kMaxChannels> lanes_;
 };
 
 /**
@@ -142,70 +214,78 @@ private:
  *
  * Algorithm based on Jatin Chowdhury's published research (public domain math)
  */
-class TapeDelay : public DelayAlgorithm {
+template <typename SampleType>
+class TapeDelay : public DelayAlgorithm<SampleType> {
 public:
   void prepare(double sampleRate) override {
     sampleRate_ = sampleRate;
-    T_ = 1.0f / static_cast<float>(sampleRate);
 
     // Jiles-Atherton parameters (tuned for tape character)
-    Ms_ = 0.5f;     // Saturation magnetization
-    a_ = 350.0f;    // Shape parameter (affects sharpness)
-    c_ = 1.7f;      // Domain wall coupling
-    k_ = 40.0f;     // Coercivity (affects hysteresis loop width)
-    alpha_ = 0.01f; // Inter-domain coupling
+    Ms_ = SampleType(0.5);     // Saturation magnetization
+    a_ = SampleType(350);      // Shape parameter (affects sharpness)
+    c_ = SampleType(1.7);      // Domain wall coupling
+    k_ = SampleType(40);       // Coercivity (affects hysteresis loop width)
+    alpha_ = SampleType(0.01); // Inter-domain coupling
 
     // Lowpass for tape head HF loss (6kHz cutoff)
-    float fc = 6000.0f;
-    float wc = 2.0f * 3.14159f * fc / static_cast<float>(sampleRate);
-    lpfCoeff_ = wc / (1.0f + wc);
+    SampleType fc = 6000;
+    SampleType wc = SampleType(2) * SampleType(3.14159) * fc /
+                    static_cast<SampleType>(sampleRate);
+    lpfCoeff_ = wc / (SampleType(1) + wc);
 
     reset();
   }
 
   void reset() override {
-    M_prev_ = 0.0f;
-    H_prev_ = 0.0f;
-    lpfState_ = 0.0f;
+    M_prev_.fill(SampleType(0));
+    H_prev_.fill(SampleType(0));
+    lpfState_.fill(SampleType(0));
   }
 
-  float processSample(float sample) override {
-    // Scale input to magnetic field strength H
-    float H = sample * 1000.0f; // Input gain for hysteresis
-
-    // Langevin function: L(x) = coth(x) - 1/x
-    float Q = (H + alpha_ * M_prev_) / a_;
-    float L;
-    if (std::abs(Q) < 0.001f) {
-      L = Q / 3.0f; // Taylor expansion for small x
-    } else {
-      L = 1.0f / std::tanh(Q) - 1.0f / Q;
+  void processFrame(SampleType* frame, int numChannels) override {
+    for (int ch = 0; ch < numChannels; ++ch) {
+      const auto lane = static_cast<size_t>(ch);
+      const SampleType M_prev = M_prev_[lane];
+
+      // Scale input to magnetic field strength H
+      const SampleType H = frame[ch] * SampleType(1000); // Input gain
+
+      // Langevin function: L(x) = coth(x) - 1/x
+      const SampleType Q = (H + alpha_ * M_prev) / a_;
+      SampleType L;
+      if (std::abs(Q) < SampleType(0.001)) {
+        L = Q / SampleType(3); // Taylor expansion for small x
+      } else {
+        L = SampleType(1) / std::tanh(Q) - SampleType(1) / Q;
+      }
+
+      // Anhysteretic magnetization
+      const SampleType M_an = Ms_ * L;
+
+      // Calculate delta M (simplified real-time solver)
+      const SampleType dH = H - H_prev_[lane];
+      const SampleType delta =
+          (dH > SampleType(0)) ? SampleType(1) : SampleType(-1);
+
+      // Irreversible magnetization component
+      const SampleType dM_irr =
+          (M_an - M_prev) / (k_ * delta * (SampleType(1) - c_) +
+                             c_ * (M_an - M_prev) / a_ + SampleType(1e-6));
+
+      // Update magnetization with bounded rate. The step follows dH alone,
+      // so the loop shape is the same at any (over)sampling rate
+      SampleType M = M_prev + dM_irr * std::abs(dH) * kSolverStep;
+      M = std::clamp(M, -Ms_, Ms_);
+
+      // Store states for next sample
+      M_prev_[lane] = M;
+      H_prev_[lane] = H;
+
+      // Normalize output and apply lowpass (tape head HF loss)
+      const SampleType output = M / Ms_ * SampleType(0.85);
+      lpfState_[lane] += lpfCoeff_ * (output - lpfState_[lane]);
+      frame[ch] = lpfState_[lane];
     }
-
-    // Anhysteretic magnetization
-    float M_an = Ms_ * L;
-
-    // Calculate delta M (simplified real-time solver)
-    float dH = H - H_prev_;
-    float delta = (dH > 0.0f) ? 1.0f : -1.0f;
-
-    // Irreversible magnetization component
-    float dM_irr = (M_an - M_prev_) / (k_ * delta * (1.0f - c_) +
-                                       c_ * (M_an - M_prev_) / a_ + 1e-6f);
-
-    // Update magnetization with bounded rate
-    float M = M_prev_ + dM_irr * std::abs(dH) * T_ * 1000.0f;
-    M = std::clamp(M, -Ms_, Ms_);
-
-    // Store states for next sample
-    M_prev_ = M;
-    H_prev_ = H;
-
-    // Normalize output and apply lowpass (tape head HF loss)
-    float output = M / Ms_ * 0.85f;
-    lpfState_ += lpfCoeff_ * (output - lpfState_);
-
-    return lpfState_;
   }
 
   DelayAlgorithmType getType() const override {
@@ -214,22 +294,26 @@ public:
 
   const char* getName() const override { return "Tape"; }
 
+  bool benefitsFromOversampling() const override { return true; }
+
 private:
   double sampleRate_ = 44100.0;
-  float T_ = 1.0f / 44100.0f; // Sample period
+  // Solver step per unit of dH (the 1 ms / 48 kHz-sample scale it was tuned
+  // at)
+  static constexpr SampleType kSolverStep = SampleType(1000.0 / 48000.0);
 
   // Jiles-Atherton parameters
-  float Ms_ = 0.5f;     // Saturation magnetization
-  float a_ = 350.0f;    // Shape parameter
-  float c_ = 1.7f;      // Domain wall coupling
-  float k_ = 40.0f;     // Coercivity
-  float alpha_ = 0.01f; // Inter-domain coupling
-
-  // State
-  float M_prev_ = 0.0f; // Previous magnetization
-  float H_prev_ = 0.0f; // Previous field
-  float lpfState_ = 0.0f;
-  float lpfCoeff_ = 0.5f;
+  SampleType Ms_ = SampleType(0.5);     // Saturation magnetization
+  SampleType a_ = SampleType(350);      // Shape parameter
+  SampleType c_ = SampleType(1.7);      // Domain wall coupling
+  SampleType k_ = SampleType(40);       // Coercivity
+  SampleType alpha_ = SampleType(0.01); // Inter-domain coupling
+
+  // State, one lane per channel
+  std::array<SampleType, kMaxChannels> M_prev_{}; // Previous magnetization
+  std::array<SampleType, kMaxChannels> H_prev_{}; // Previous field
+  std::array<SampleType, kMaxChannels> lpfState_{};
+  SampleType lpfCoeff_ = SampleType(0.5);
 };
 
 /**
@@ -240,7 +324,8 @@ private:
  * - Sample rate reduction
  * - Added noise floor
  */
-class LoFiDelay : public DelayAlgorithm {
+template <typename SampleType>
+class LoFiDelay : public DelayAlgorithm<SampleType> {
 public:
   void prepare(double sampleRate) override {
     sampleRate_ = sampleRate;
@@ -248,25 +333,27 @@ public:
   }
 
   void reset() override {
-    holdSample_ = 0.0f;
+    holdSample_.fill(SampleType(0));
     holdCounter_ = 0;
   }
 
-  float processSample(float sample) override {
-    // Sample rate reduction (hold every N samples)
+  void processFrame(SampleType* frame, int numChannels) override {
+    // Sample rate reduction (hold every N frames, all channels together)
     const int decimation = 4; // Effective ~11kHz at 44.1kHz
     if (++holdCounter_ >= decimation) {
       holdCounter_ = 0;
 
       // Bit depth reduction (simulate 12-bit)
-      const float levels = 4096.0f;
-      holdSample_ = std::round(sample * levels) / levels;
+      const SampleType levels = 4096;
+      for (int ch = 0; ch < numChannels; ++ch)
+        holdSample_[static_cast<size_t>(ch)] =
+            std::round(frame[ch] * levels) / levels;
     }
 
-    // Add subtle noise floor
-    float noise = (static_cast<float>(rand()) / RAND_MAX - 0.5f) * 0.002f;
-
-    return holdSample_ + noise;
+    // Add subtle noise floor (independent per channel)
+    for (int ch = 0; ch < numChannels; ++ch)
+      frame[ch] = holdSample_[static_cast<size_t>(ch)] +
+                  nextNoise() * SampleType(0.002);
   }
 
   DelayAlgorithmType getType() const override {
@@ -276,27 +363,86 @@ public:
   const char* getName() const override { return "Lo-Fi"; }
 
 private:
+  /**
+   * @brief Uniform noise in [-0.5, 0.5) (LCG; allocation- and lock-free,
+   *        unlike rand())
+   */
+  SampleType nextNoise() {
+    noiseState_ = noiseState_ * 1664525u + 1013904223u;
+    return static_cast<SampleType>(noiseState_ >> 8) *
+               SampleType(1.0 / 16777216.0) -
+           SampleType(0.5);
+  }
+
   double sampleRate_ = 44100.0;
-  float holdSample_ = 0.0f;
+  std::array<SampleType, kMaxChannels> holdSample_{};
   int holdCounter_ = 0;
+  uint32_t noiseState_ = 22222u;
+};
+
+/**
+ * @brief Shimmer delay - pitch shift inside the feedback loop
+ *
+ * Every pass through the loop is transposed (an octave up by default), so
+ * repeats climb. Uses the fixed-cost PitchShifter: the ring is allocated in
+ * prepare() and per-frame work never varies. Its half-grain latency is
+ * reported to the band, which compensates for it in the loop.
+ */
+template <typename SampleType>
+class ShimmerDelay : public DelayAlgorithm<SampleType> {
+public:
+  void prepare(double sampleRate) override {
+    sampleRate_ = sampleRate;
+    shifter_.prepare(sampleRate);
+    shifter_.setRatio(ratio_);
+  }
+
+  void reset() override { shifter_.reset(); }
+
+  void setPitchSemitones(double semitones) override {
+    ratio_ = std::pow(2.0, semitones / 12.0);
+    shifter_.setRatio(ratio_);
+  }
+
+  double getLatencySamples() const override {
+    return shifter_.getLatencySamples();
+  }
+
+  void processFrame(SampleType* frame, int numChannels) override {
+    shifter_.processFrame(frame, numChannels);
+  }
+
+  DelayAlgorithmType getType() const override {
+    return DelayAlgorithmType::Shimmer;
+  }
+
+  const char* getName() const override { return "Shimmer"; }
+
+private:
+  double sampleRate_ = 44100.0;
+  double ratio_ = 2.0;
+  PitchShifter<SampleType> shifter_;
 };
 
 /**
  * @brief Factory for creating delay algorithms
  */
-inline std::unique_ptr<DelayAlgorithm>
+template <typename SampleType>
+std::unique_ptr<DelayAlgorithm<SampleType>>
 createDelayAlgorithm(DelayAlgorithmType type) {
   switch (type) {
   case DelayAlgorithmType::Digital:
-    return std::make_unique<DigitalDelay>();
+    return std::make_unique<DigitalDelay<SampleType>>();
   case DelayAlgorithmType::Analog:
-    return std::make_unique<AnalogDelay>();
+    return std::make_unique<AnalogDelay<SampleType>>();
   case DelayAlgorithmType::Tape:
-    return std::make_unique<TapeDelay>();
+    return std::make_unique<TapeDelay<SampleType>>();
   case DelayAlgorithmType::LoFi:
-    return std::make_unique<LoFiDelay>();
+    return std::make_unique<LoFiDelay<SampleType>>();
+  case DelayAlgorithmType::Shimmer:
+    return std::make_unique<ShimmerDelay<SampleType>>();
   default:
-    return std::make_unique<DigitalDelay>();
+    return std::make_unique<DigitalDelay<SampleType>>();
   }
 }
 
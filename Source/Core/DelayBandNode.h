@@ -1,16 +1,27 @@
 #pragma once
 
 #include "AttackEnvelope.h"
+#include "ChannelLayout.h"
 #include "DelayAlgorithm.h"
+#include "DelayMemory.h"
 #include "FilterSection.h"
 #include "GenerativeModulator.h"
+#include "Interpolation.h"
+#include "Oversampling.h"
 
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <juce_dsp/juce_dsp.h>
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
 
 
 namespace uds {
@@ -35,6 +46,25 @@ struct DelayBandParams {
   bool pingPong = false;
   bool enabled = true;
   DelayAlgorithmType algorithm = DelayAlgorithmType::Digital;
+  InterpolationType interpolation = InterpolationType::Hermite;
+  float pitchSemitones = 12.0f; // Shimmer transposition per repeat
+
+  // Bus channels this band delays (bit n = channel n). Channels outside the
+  // mask pass through dry.
+  uint32_t channelMask = kAllChannels;
+};
+
+/**
+ * @brief Extra read head on a band's delay line (multi-tap presets)
+ *
+ * Taps only read: the band's own time sets the single feedback loop, and
+ * each tap adds its own level/pan/polarity and modulation on top.
+ */
+struct DelayTapParams {
+  float delayTimeMs = 250.0f;
+  float level = 1.0f;
+  float pan = 0.0f;
+  bool phaseInvert = false;
 };
 
 /**
@@ -42,67 +72,161 @@ struct DelayBandParams {
  * modulation
  *
  * Features:
- * - Algorithm selection (Digital, Analog, Tape, Lo-Fi)
+ * - Algorithm selection (Digital, Analog, Tape, Lo-Fi, Shimmer)
  * - Hi-cut and Lo-cut filters in feedback path
  * - LFO modulation of delay time (chorus/flutter effects)
  * - Phase inversion option
+ * - Selectable read interpolation (integer ... windowed sinc)
+ * - N-channel (up to kMaxChannels) with per-band channel routing
+ * - Optional extra read heads (multi-tap node): one write head, up to
+ *   kMaxTaps fractional taps sharing the line, feedback loop and filters
+ *
+ * Templated on sample type: the double instantiation keeps the delay line,
+ * feedback path and filter state in 64-bit for hosts with 64-bit engines.
+ *
+ * The delay line is stored frame-interleaved (all channels of one sample are
+ * contiguous). Read positions, interpolation weights and modulation are
+ * computed once per sample and shared by every channel, and the per-channel
+ * interpolation, filtering and mixing run as straight loops over the frame
+ * that the compiler vectorises. An 8-channel band therefore costs far less
+ * than four stereo bands.
  */
-class DelayBandNode {
+template <typename SampleType> class DelayBandNode {
 public:
+  static constexpr int kMaxTaps = 12;
+  // Bands after the line owner in a fused chain (see processFused())
+  static constexpr int kMaxFusedMembers = 2;
+
+  /**
+   * @brief Optional stages of the per-sample loop (see processLine())
+   *
+   * Each combination is a separate specialization of the loop, picked
+   * from a table once per block, so a band only runs the stages it uses.
+   */
+  enum Stage : uint32_t {
+    kModulation = 1u << 0, // Local/master LFO moves the read heads
+    kAlgorithm = 1u << 1,  // Non-Digital algorithm in the feedback path
+    kFilter = 1u << 2,     // Hi-cut and/or lo-cut in the feedback path
+    kPingPong = 1u << 3,
+    kTaps = 1u << 4,
+    kAttack = 1u << 5
+  };
+  static constexpr uint32_t kAllStages = (1u << 6) - 1;
+
+  /**
+   * @brief One read of a fused chain: delay and per-channel gain
+   */
+  struct FusedRead {
+    SampleType delaySamples = SampleType(0);
+    std::array<SampleType, kMaxChannels> gains{};
+  };
+
   DelayBandNode() {
+    // One instance per algorithm, prepared together, so switching on the
+    // audio thread never allocates. Nonlinear algorithms get a second
+    // instance for 2x oversampled (offline quality) processing.
+    for (int a = 0; a < kNumDelayAlgorithms; ++a) {
+      const auto type = static_cast<DelayAlgorithmType>(a);
+      algorithms_[static_cast<size_t>(a)] =
+          createDelayAlgorithm<SampleType>(type);
+      if (algorithms_[static_cast<size_t>(a)]->benefitsFromOversampling())
+        oversampledAlgorithms_[static_cast<size_t>(a)] =
+            createDelayAlgorithm<SampleType>(type);
+    }
+
     // Default to digital algorithm
-    algorithm_ = createDelayAlgorithm(DelayAlgorithmType::Digital);
+    algorithm_ = algorithms_[0].get();
   }
 
-  void prepare(double sampleRate, size_t /*maxBlockSize*/) {
-    sampleRate_ = sampleRate;
+  /**
+   * @brief Prepare for playback (incremental)
+   *
+   * Re-preparing with the same sample rate and channel count is a no-op:
+   * the delay line, its contents and all filter/algorithm state are kept.
+   * Otherwise the existing allocation is reused whenever it is large
+   * enough (only the written span is cleared), so only a sample-rate (or
+   * channel) increase allocates.
+   */
+  void prepare(double sampleRate, size_t /*maxBlockSize*/,
+               int numChannels = 2) {
+    const int channels = std::clamp(numChannels, 1, kMaxChannels);
+    if (prepared_ && sampleRate == sampleRate_ && channels == numChannels_)
+      return;
 
-    // Max delay = 10 seconds + 500ms modulation headroom
-    const int maxDelaySamples = static_cast<int>(10.5 * sampleRate) + 1;
+    // Clear in the old layout: everything past the written span is zero
+    acquireLine();
+    clearWrittenRegion();
+    releaseLine();
+    sampleRate_ = sampleRate;
+    numChannels_ = channels;
 
-    // Simple circular buffer
-    bufferL_.resize(static_cast<size_t>(maxDelaySamples), 0.0f);
-    bufferR_.resize(static_cast<size_t>(maxDelaySamples), 0.0f);
-    writePos_ = 0;
+    // Default sides until the host layout is known
+    for (int ch = 0; ch < kMaxChannels; ++ch)
+      channelSides_[static_cast<size_t>(ch)] =
+          defaultChannelSide(ch, numChannels_);
+    updateChannelGains();
 
-    // Prepare algorithm
-    if (algorithm_) {
-      algorithm_->prepare(sampleRate);
+    // Oversampled instances only run at the host rate (offline quality)
+    for (auto& algorithm : oversampledAlgorithms_) {
+      if (algorithm)
+        algorithm->prepare(2.0 * sampleRate);
     }
+    oversampler_.prepare();
 
-    // Prepare filter section
-    filterSection_.prepare(sampleRate);
-
-    // Prepare attack envelope for volume swell
-    attackEnvelope_.prepare(sampleRate);
+    // Build the shared sinc table here rather than on the audio thread
+    SincTable::get();
 
+    // Line, algorithms, filters and envelope at the internal rate; state
+    // from the old rate is meaningless at the new one
+    prepareInternalRate();
     prepared_ = true;
   }
 
+  /**
+   * @brief Clear the line and all state
+   *
+   * Only the frames written since the last clear are zeroed, so the cost
+   * follows how much of the line was used rather than its 10.5s capacity.
+   * Clearing takes the line lock (waiting for a setLineResident() on
+   * another thread); a band with nothing written (see hasWrittenFrames())
+   * leaves the line alone and never waits, which is how the matrix resets
+   * bands on the audio thread.
+   */
   void reset() {
-    std::fill(bufferL_.begin(), bufferL_.end(), 0.0f);
-    std::fill(bufferR_.begin(), bufferR_.end(), 0.0f);
-    writePos_ = 0;
-    feedbackL_ = 0.0f;
-    feedbackR_ = 0.0f;
+    if (writtenFrames_ > 0) {
+      acquireLine();
+      clearWrittenRegion();
+      releaseLine();
+    }
+    silentFrames_ = maxDelaySamples_;
 
     if (algorithm_) {
       algorithm_->reset();
     }
+    oversampler_.reset();
+    resetResamplers();
 
     filterSection_.reset();
     attackEnvelope_.reset();
+    resetInterpolationState();
   }
 
   void setParams(const DelayBandParams& params) {
-    // Check if algorithm type changed
-    if (params.algorithm != params_.algorithm) {
-      algorithm_ = createDelayAlgorithm(params.algorithm);
-      if (algorithm_ && prepared_) {
-        algorithm_->prepare(sampleRate_);
+    const bool algorithmChanged = params.algorithm != params_.algorithm;
+
+    // Clock-dependent algorithms (BBD) follow the base time, not the LFO
+    if (!algorithmChanged) {
+      if (params.delayTimeMs != params_.delayTimeMs)
+        algorithm_->setDelayTime(params.delayTimeMs);
+      if (params.pitchSemitones != params_.pitchSemitones) {
+        algorithm_->setPitchSemitones(params.pitchSemitones);
+        updateLoopLatency();
       }
     }
 
+    if (params.interpolation != params_.interpolation)
+      resetInterpolationState();
+
     // Update filter frequencies
     filterSection_.setHiCutFrequency(params.hiCutHz);
     filterSection_.setLoCutFrequency(params.loCutHz);
@@ -116,8 +240,257 @@ public:
     attackEnvelope_.setAttackTimeMs(params.attackTimeMs);
 
     params_ = params;
+    if (algorithmChanged)
+      selectAlgorithm();
+    updateChannelGains();
+  }
+
+  /**
+   * @brief Run nonlinear algorithms at twice the sample rate (offline
+   *        quality)
+   *
+   * The oversampled instances are prepared with the band. Switching
+   * resets the algorithm state; the extra filter latency is compensated in
+   * the loop like any other algorithm latency. A band running at a reduced
+   * rate goes back to the host rate, which re-prepares it (see
+   * setRateReduction()).
+   */
+  void setOversampling(bool shouldOversample) {
+    if (shouldOversample == oversample_)
+      return;
+    oversample_ = shouldOversample;
+    if (prepared_ && chooseRateFactor() != rateFactor_)
+      prepareInternalRate();
+    else
+      selectAlgorithm();
+  }
+
+  bool isOversampling() const { return oversample_; }
+
+  static constexpr double kMinInternalRate = 44100.0;
+  static constexpr int kMaxRateReduction = 8;
+
+  /**
+   * @brief Let the band run at a reduced internal rate (default on)
+   *
+   * From 88.2 kHz up, the line, algorithm, filters and swell run at the
+   * host rate / 2, 4 or 8, never below kMinInternalRate, so the audible
+   * band is kept. Halfband stages decimate the input and interpolate the
+   * wet signal back up; echo times stay exact (see processReduced()).
+   * Oversampled (offline) bands run at the host rate. A change
+   * re-prepares the band and clears its line, so make it off the audio
+   * thread, like setOversampling().
+   */
+  void setRateReduction(bool allowed) {
+    if (allowed == rateReduction_)
+      return;
+    rateReduction_ = allowed;
+    if (prepared_ && chooseRateFactor() != rateFactor_)
+      prepareInternalRate();
+  }
+
+  /** @brief Host samples per internal sample (1 = full rate) */
+  int getRateFactor() const { return rateFactor_; }
+
+  /**
+   * @brief Assign listener sides to bus channels (drives the pan law)
+   */
+  void setChannelSides(const ChannelSide* sides, int numChannels) {
+    const int n = std::min(numChannels, kMaxChannels);
+    for (int ch = 0; ch < n; ++ch)
+      channelSides_[static_cast<size_t>(ch)] = sides[ch];
+    updateChannelGains();
+  }
+
+  int getNumChannels() const { return numChannels_; }
+
+  /**
+   * @brief Bytes held by the delay line (capacity, not just the used span)
+   */
+  size_t getAllocatedBytes() const { return getMemoryStatus().bytes; }
+
+  /**
+   * @brief Pre-fault/lock/huge-page policy for the line (applies from the
+   *        next allocation, so set it before prepare())
+   */
+  void setMemoryOptions(const DelayMemoryOptions& options) {
+    memoryOptions_ = options;
+  }
+
+  /**
+   * @brief Status of the line, read under the line lock (not for the audio
+   *        thread)
+   */
+  DelayMemoryStatus getMemoryStatus() const {
+    acquireLine();
+    const DelayMemoryStatus status = delayLine_.getStatus();
+    releaseLine();
+    return status;
+  }
+
+  /**
+   * @brief Set the extra read heads (0 = plain single-head band)
+   *
+   * Allocation-free; safe to call every block from the audio thread.
+   */
+  void setTaps(const DelayTapParams* taps, int numTaps) {
+    numTaps_ = std::clamp(numTaps, 0, kMaxTaps);
+    for (int t = 0; t < numTaps_; ++t)
+      taps_[static_cast<size_t>(t)] = taps[t];
+    updateTapGains();
+  }
+
+  int getNumTaps() const { return numTaps_; }
+
+  /**
+   * @brief True when every frame any read head can reach is silent
+   *
+   * With silent input such a band outputs only its (silent) input, so the
+   * matrix may skip it under CPU pressure without losing a pending echo.
+   */
+  bool isIdle() const {
+    float longestMs = params_.delayTimeMs;
+    for (int t = 0; t < numTaps_; ++t)
+      longestMs =
+          std::max(longestMs, taps_[static_cast<size_t>(t)].delayTimeMs);
+    // Read heads reach up to 50ms (local + master modulation) further back
+    const int reach = static_cast<int>((longestMs + 50.0f) * 0.001 *
+                                       internalRate_) +
+                      Interpolator::kMaxOlder + 1;
+    return silentFrames_ >=
+           std::min(std::max(reach, fusedReachFrames_), maxDelaySamples_);
+  }
+
+  /**
+   * @brief Output is input + wet gain * input(t - delay) on every channel
+   *
+   * Enabled Digital band with no feedback, modulation, swell, read heads or
+   * Allpass reads: the algorithm and filters only ever see silence, so a
+   * chain of such bands can run as one line (see processFused()), at the
+   * host rate. The owner checks the master LFO.
+   */
+  bool isPureDelay() const {
+    return params_.enabled && prepared_ &&
+           lineResident_.load(std::memory_order_relaxed) &&
+           rateFactor_ == 1 &&
+           params_.algorithm == DelayAlgorithmType::Digital &&
+           params_.feedback == 0.0f && params_.lfoDepth == 0.0f &&
+           params_.attackTimeMs <= 0.0f && numTaps_ == 0 &&
+           params_.interpolation != InterpolationType::Allpass;
+  }
+
+  /**
+   * @brief Output equals input: disabled, or muted with no read heads
+   */
+  bool isWire() const {
+    return !params_.enabled || (params_.level == 0.0f && numTaps_ == 0);
+  }
+
+  /**
+   * @brief A wire that still runs its line: enabled, muted, no read heads
+   *
+   * Input and feedback keep building up in the line and play once the
+   * level comes back up.
+   */
+  bool isMuted() const {
+    return params_.enabled && params_.level == 0.0f && numTaps_ == 0;
+  }
+
+  /**
+   * @brief Unmodulated read delay in samples, as process() reads it
+   *        (rounded for the None tier)
+   */
+  SampleType getReadDelaySamples() const {
+    SampleType d = static_cast<SampleType>(params_.delayTimeMs) /
+                   SampleType(1000) * static_cast<SampleType>(internalRate_);
+    d = std::clamp(d, kMinReadDelay, static_cast<SampleType>(maxReadDelay()));
+    if (params_.interpolation == InterpolationType::None)
+      d = std::floor(d + SampleType(0.5));
+    return d;
+  }
+
+  int getMaxReadDelaySamples() const { return maxReadDelay(); }
+
+  /** @brief Level x pan x polarity for a channel (0 if unrouted) */
+  SampleType getWetGain(int channel) const {
+    return wetGains_[static_cast<size_t>(channel)];
+  }
+
+  /**
+   * @brief Run the line for a fused chain of pure-delay bands
+   *
+   * Writes the input and sets each channel to input + the sum of the
+   * reads (at most kMaxTaps). Read kernels are built once per call, as
+   * the delays do not move. Feedback, algorithm and filters are skipped,
+   * which is exact for bands where isPureDelay() holds.
+   *
+   * members[k] (may be null) is the chain's band k + 1. Each still records
+   * its own input, the partial sum over the reads of the bands before it
+   * (reads are ordered by subset, see DelayMatrix), so it picks up with a
+   * full line when the chain breaks.
+   */
+  void processFused(juce::AudioBuffer<SampleType>& buffer,
+                    const FusedRead* reads, int numReads,
+                    DelayBandNode* const* members = nullptr,
+                    int numMembers = 0) {
+    if (!prepared_)
+      return;
+    if (lineLock_.exchange(true, std::memory_order_acquire))
+      return;
+
+    // A member whose line is busy (shared arena) skips this block
+    std::array<DelayBandNode*, kMaxFusedMembers> recording{};
+    numMembers = std::clamp(numMembers, 0, kMaxFusedMembers);
+    for (int k = 0; k < numMembers; ++k) {
+      auto* member = members[k];
+      if (member == nullptr || member == this ||
+          member->numChannels_ != numChannels_ ||
+          member->lineLock_.exchange(true, std::memory_order_acquire))
+        continue;
+      if (member->delayLine_.empty())
+        member->lineLock_.store(false, std::memory_order_release);
+      else
+        recording[static_cast<size_t>(k)] = member;
+    }
+
+    if (!delayLine_.empty())
+      processFusedLine(buffer, reads, std::clamp(numReads, 0, kMaxTaps),
+                       recording.data(), numMembers);
+
+    for (auto* member : recording)
+      if (member != nullptr)
+        member->lineLock_.store(false, std::memory_order_release);
+    lineLock_.store(false, std::memory_order_release);
   }
 
+  /**
+   * @brief Zero up to maxSamples of the written span, newest frames first
+   *
+   * Spreads a line clear over several calls (hard bypass). Once nothing is
+   * left, reset() only resets the small per-sample state.
+   *
+   * @return The part of maxSamples that was not needed
+   */
+  size_t clearWrittenStep(size_t maxSamples) {
+    if (writtenFrames_ == 0 || numChannels_ <= 0)
+      return maxSamples;
+    // Never wait for the message thread (shared arena); retry next call
+    if (lineLock_.exchange(true, std::memory_order_acquire))
+      return 0;
+    const auto channels = static_cast<size_t>(numChannels_);
+    const auto written = static_cast<size_t>(writtenFrames_);
+    const size_t frames = std::min(written, maxSamples / channels);
+    const size_t end = std::min(written * channels, delayLine_.size());
+    const size_t start = std::min((written - frames) * channels, end);
+    std::fill(delayLine_.data() + start, delayLine_.data() + end,
+              SampleType(0));
+    writtenFrames_ = static_cast<int>(written - frames);
+    lineLock_.store(false, std::memory_order_release);
+    return maxSamples - frames * channels;
+  }
+
+  bool hasWrittenFrames() const { return writtenFrames_ > 0; }
+
   /**
    * @brief Get current algorithm type
    */
@@ -130,164 +503,834 @@ public:
     return algorithm_ ? algorithm_->getName() : "Unknown";
   }
 
-  void process(juce::AudioBuffer<float>& buffer, float wetMix,
+  /**
+   * @brief Stages the last processed block ran (see Stage)
+   */
+  uint32_t getActiveStages() const { return activeStages_; }
+
+  /**
+   * @brief Also run these stages when the params do not need them
+   *
+   * For tests and benchmarks comparing the specialized loops with fuller
+   * ones. An unneeded stage is neutral (the output does not change),
+   * except kAttack, whose envelope starts closed.
+   */
+  void setForcedStages(uint32_t stages) { forcedStages_ = stages & kAllStages; }
+
+  /**
+   * @param modSignal Local LFO, or null when the band is not modulated
+   * @param masterModSignal Master LFO, or null when it is off
+   * @param tapModSignals Optional per-tap modulation buffers (one per tap
+   *        set with setTaps(), entries may be null)
+   * @param inputPeak Per-sample peak of the buffer across channels (see
+   *        InputAnalysis), or null to measure it here. Only the attack
+   *        envelope reads it, and only while every channel is routed.
+   */
+  void process(juce::AudioBuffer<SampleType>& buffer, SampleType wetMix,
                const float* modSignal = nullptr,
-               const float* masterModSignal = nullptr) {
-    if (!params_.enabled || !prepared_ || bufferL_.empty())
+               const float* masterModSignal = nullptr,
+               const float* const* tapModSignals = nullptr,
+               const float* inputPeak = nullptr) {
+    if (!params_.enabled || !prepared_)
       return;
 
+    // The message thread may be attaching or detaching the line (shared
+    // arena). Never wait for it: the block just passes through.
+    if (lineLock_.exchange(true, std::memory_order_acquire))
+      return;
+    if (!delayLine_.empty())
+      processLine(buffer, wetMix, modSignal, masterModSignal, tapModSignals,
+                  inputPeak);
+    lineLock_.store(false, std::memory_order_release);
+  }
+
+  /**
+   * @brief Attach or detach the line's memory (message thread only)
+   *
+   * With a shared DelayArena, bands that are disabled, unrouted or asleep
+   * hand their block back; a detached band passes audio through until it is
+   * attached again. Contents are dropped on detach.
+   */
+  void setLineResident(bool resident) {
+    lineWanted_ = resident;
+    if (!prepared_ || resident == isLineResident())
+      return;
+
+    acquireLine();
+    if (resident) {
+      delayLine_.allocate(static_cast<size_t>(maxDelaySamples_) *
+                              static_cast<size_t>(numChannels_),
+                          memoryOptions_);
+    } else {
+      clearWrittenRegion();
+      delayLine_.release();
+      silentFrames_ = maxDelaySamples_;
+      resetInterpolationState();
+    }
+    lineResident_.store(!delayLine_.empty(), std::memory_order_relaxed);
+    releaseLine();
+  }
+
+  bool isLineResident() const {
+    return lineResident_.load(std::memory_order_relaxed);
+  }
+
+private:
+  using Interpolator = FractionalDelay<SampleType>;
+
+  /**
+   * @brief Pick the loop specialized for this block's stages and run it
+   */
+  void processLine(juce::AudioBuffer<SampleType>& buffer, SampleType wetMix,
+                   const float* modSignal, const float* masterModSignal,
+                   const float* const* tapModSignals,
+                   const float* inputPeak) {
     const int numSamples = buffer.getNumSamples();
-    const int numChannels = buffer.getNumChannels();
+    const int numChannels = std::min(buffer.getNumChannels(), numChannels_);
+    if (numChannels <= 0)
+      return;
+    fusedReachFrames_ = 0;
 
-    float* leftChannel = buffer.getWritePointer(0);
-    float* rightChannel =
-        numChannels > 1 ? buffer.getWritePointer(1) : leftChannel;
+    std::array<SampleType*, kMaxChannels> channels{};
+    for (int ch = 0; ch < numChannels; ++ch)
+      channels[static_cast<size_t>(ch)] = buffer.getWritePointer(ch);
 
-    const int bufferSize = static_cast<int>(bufferL_.size());
+    uint32_t stages = forcedStages_;
+    if (modSignal != nullptr || masterModSignal != nullptr)
+      stages |= kModulation;
+    if (params_.algorithm != DelayAlgorithmType::Digital)
+      stages |= kAlgorithm; // Digital's processFrame() is a no-op
+    if (filterSection_.isActive())
+      stages |= kFilter;
+    if (params_.pingPong)
+      stages |= kPingPong;
+    if (numTaps_ > 0)
+      stages |= kTaps;
+    if (params_.attackTimeMs > 0.0f)
+      stages |= kAttack;
+    activeStages_ = stages;
 
-    for (int i = 0; i < numSamples; ++i) {
-      // Get LFO-modulated delay time
-      float modulatedTimeMs = params_.delayTimeMs;
+    static constexpr auto loops =
+        makeLoopTable(std::make_index_sequence<kAllStages + 1>{});
+    if (rateFactor_ > 1)
+      processReduced(loops[stages], channels.data(), numSamples, numChannels,
+                     wetMix, modSignal, masterModSignal, tapModSignals);
+    else
+      (this->*loops[stages])(channels.data(), numSamples, numChannels,
+                             wetMix, modSignal, masterModSignal,
+                             tapModSignals,
+                             allChannelsRouted_ ? inputPeak : nullptr);
+  }
+
+  using Loop = void (DelayBandNode::*)(SampleType* const*, int, int,
+                                       SampleType, const float*,
+                                       const float*, const float* const*,
+                                       const float*);
+
+  template <size_t... Stages>
+  static constexpr std::array<Loop, sizeof...(Stages)>
+  makeLoopTable(std::index_sequence<Stages...>) {
+    return {{&DelayBandNode::processLoop<static_cast<uint32_t>(Stages)>...}};
+  }
+
+  /**
+   * @brief The per-sample loop with only the given stages compiled in
+   */
+  template <uint32_t Stages>
+  void processLoop(SampleType* const* channels, int numSamples,
+                   int numChannels, SampleType wetMix, const float* modSignal,
+                   const float* masterModSignal,
+                   const float* const* tapModSignals,
+                   const float* inputPeak) {
+    const int bufferSize = maxDelaySamples_;
+    const auto feedback = static_cast<SampleType>(params_.feedback);
 
-      // Calculate total modulation (Local + Master)
-      float totalMod = 0.0f;
+    // Per-sample scratch frames (one lane per channel)
+    std::array<SampleType, kMaxChannels> dry{}, input{}, delayed{}, early{},
+        fb{}, wet{};
+    typename Interpolator::Kernel kernel, loopKernel;
+    // Only algorithms have latency (Shimmer, or any oversampled one). At a
+    // reduced rate the output head reads ahead by the resampling latency.
+    const SampleType loopLead =
+        (Stages & kAlgorithm) != 0 ? loopLatency_ : SampleType(0);
+    const bool splitLoop = loopLead != outputLead_;
+    auto makeKernels = [&](SampleType delaySamples) {
+      Interpolator::makeKernel(
+          params_.interpolation,
+          std::max(delaySamples - outputLead_, kMinReadDelay), kernel);
+      if (splitLoop)
+        Interpolator::makeKernel(
+            params_.interpolation,
+            std::max(delaySamples - loopLead, kMinReadDelay), loopKernel);
+    };
 
-      if (modSignal) {
-        totalMod += modSignal[i];
+    // Unmodulated read heads do not move: build their kernels once
+    if constexpr ((Stages & kModulation) == 0)
+      makeKernels(readDelaySamples(params_.delayTimeMs));
+
+    for (int i = 0; i < numSamples; ++i) {
+      if constexpr ((Stages & kModulation) != 0) {
+        // Local + master modulation, scaled by 25ms for audible
+        // chorus/vibrato
+        float modulatedTimeMs = params_.delayTimeMs;
+        float totalMod = 0.0f;
+        if (modSignal)
+          totalMod += modSignal[i];
+        if (masterModSignal)
+          totalMod += masterModSignal[i];
+        if (totalMod != 0.0f) {
+          modulatedTimeMs += (totalMod * 25.0f); // ±25ms modulation range
+          modulatedTimeMs = std::max(1.0f, modulatedTimeMs); // Positive
+        }
+
+        // One kernel per sample; every channel of the frame shares the
+        // weights
+        makeKernels(readDelaySamples(modulatedTimeMs));
       }
+      Interpolator::readFrame(delayLine_.data(), bufferSize, numChannels_,
+                              numChannels, writePos_, kernel, delayed.data());
+      Interpolator::applyAllpass(kernel, delayed.data(), allpassState_.data(),
+                                 numChannels);
 
-      if (masterModSignal) {
-        totalMod += masterModSignal[i];
+      // An algorithm with latency (Shimmer) gets the feedback that much
+      // earlier, so the loop period stays at the delay time
+      const SampleType* loopSource = delayed.data();
+      if (splitLoop) {
+        Interpolator::readFrame(delayLine_.data(), bufferSize, numChannels_,
+                                numChannels, writePos_, loopKernel,
+                                early.data());
+        Interpolator::applyAllpass(loopKernel, early.data(),
+                                   loopAllpassState_.data(), numChannels);
+        loopSource = early.data();
       }
 
-      // Apply modulation (scale by 25ms for audible chorus/vibrato effect)
-      if (totalMod != 0.0f) {
-        modulatedTimeMs += (totalMod * 25.0f); // ±25ms modulation range
-        modulatedTimeMs = std::max(1.0f, modulatedTimeMs); // Ensure positive
+      for (int ch = 0; ch < numChannels; ++ch) {
+        // Get input (unrouted channels feed silence into the line)
+        dry[ch] = channels[ch][i];
+        input[ch] = dry[ch] * inputGains_[static_cast<size_t>(ch)];
+        fb[ch] = loopSource[ch] * feedback;
       }
 
-      // Calculate delay in samples (with interpolation for smooth modulation)
-      float delaySamplesF =
-          (modulatedTimeMs / 1000.0f) * static_cast<float>(sampleRate_);
-      int delaySamples = static_cast<int>(delaySamplesF);
-      float frac = delaySamplesF - static_cast<float>(delaySamples);
-
-      // Calculate read positions for cubic Hermite interpolation (4 points)
-      int readPos0 = writePos_ - delaySamples + 1; // One sample ahead
-      int readPos1 = writePos_ - delaySamples;
-      int readPos2 = readPos1 - 1;
-      int readPos3 = readPos1 - 2;
-
-      // Wrap positions
-      if (readPos0 < 0)
-        readPos0 += bufferSize;
-      if (readPos1 < 0)
-        readPos1 += bufferSize;
-      if (readPos2 < 0)
-        readPos2 += bufferSize;
-      if (readPos3 < 0)
-        readPos3 += bufferSize;
-      if (readPos0 >= bufferSize)
-        readPos0 -= bufferSize;
-
-      // Get 4 sample points for cubic interpolation
-      float y0L = bufferL_[static_cast<size_t>(readPos0)];
-      float y1L = bufferL_[static_cast<size_t>(readPos1)];
-      float y2L = bufferL_[static_cast<size_t>(readPos2)];
-      float y3L = bufferL_[static_cast<size_t>(readPos3)];
-
-      float y0R = bufferR_[static_cast<size_t>(readPos0)];
-      float y1R = bufferR_[static_cast<size_t>(readPos1)];
-      float y2R = bufferR_[static_cast<size_t>(readPos2)];
-      float y3R = bufferR_[static_cast<size_t>(readPos3)];
-
-      // Cubic Hermite interpolation coefficients
-      float c0L = y1L;
-      float c1L = 0.5f * (y2L - y0L);
-      float c2L = y0L - 2.5f * y1L + 2.0f * y2L - 0.5f * y3L;
-      float c3L = 0.5f * (y3L - y0L) + 1.5f * (y1L - y2L);
-
-      float c0R = y1R;
-      float c1R = 0.5f * (y2R - y0R);
-      float c2R = y0R - 2.5f * y1R + 2.0f * y2R - 0.5f * y3R;
-      float c3R = 0.5f * (y3R - y0R) + 1.5f * (y1R - y2R);
-
-      // Evaluate cubic polynomial: y = c0 + c1*t + c2*t^2 + c3*t^3
-      float delayedL = ((c3L * frac + c2L) * frac + c1L) * frac + c0L;
-      float delayedR = ((c3R * frac + c2R) * frac + c1R) * frac + c0R;
-
-      // Get input
-      float inputL = leftChannel[i];
-      float inputR = rightChannel[i];
-
-      // Apply algorithm to feedback signal (this is what creates the character)
-      float feedbackL = delayedL * params_.feedback;
-      float feedbackR = delayedR * params_.feedback;
-
-      if (algorithm_) {
-        feedbackL = algorithm_->processSample(feedbackL);
-        feedbackR = algorithm_->processSample(feedbackR);
+      // Apply algorithm to feedback signal (this is what creates the
+      // character); one call per frame, independent state per channel.
+      // Unrouted channels keep their (silent) feedback untouched.
+      if constexpr ((Stages & kAlgorithm) != 0) {
+        if (allChannelsRouted_) {
+          runAlgorithm(fb.data(), numChannels);
+        } else {
+          auto processed = fb;
+          runAlgorithm(processed.data(), numChannels);
+          for (int ch = 0; ch < numChannels; ++ch) {
+            if (inputGains_[static_cast<size_t>(ch)] != SampleType(0))
+              fb[ch] = processed[ch];
+          }
+        }
       }
 
       // Apply filters to feedback path
-      filterSection_.processSample(feedbackL, feedbackR);
+      if constexpr ((Stages & kFilter) != 0)
+        filterSection_.processFrame(fb.data(), numChannels);
+
+      const int tapWritePos = writePos_;
 
       // Write to buffer (input + processed feedback)
-      // For ping-pong: cross-feed feedback to create L/R bounce
-      if (params_.pingPong) {
-        // Ping-pong: L feedback goes to R buffer, R feedback goes to L buffer
-        bufferL_[static_cast<size_t>(writePos_)] = inputL + feedbackR;
-        bufferR_[static_cast<size_t>(writePos_)] = inputR + feedbackL;
+      // For ping-pong: feedback rotates to the next routed channel (L<->R in
+      // stereo)
+      SampleType* writeFrame = frameAt(writePos_);
+      if constexpr ((Stages & kPingPong) != 0) {
+        for (int ch = 0; ch < numChannels; ++ch) {
+          const int src = pingPongSource_[static_cast<size_t>(ch)];
+          writeFrame[ch] = input[ch] + fb[src < numChannels ? src : ch];
+        }
       } else {
-        bufferL_[static_cast<size_t>(writePos_)] = inputL + feedbackL;
-        bufferR_[static_cast<size_t>(writePos_)] = inputR + feedbackR;
+        for (int ch = 0; ch < numChannels; ++ch)
+          writeFrame[ch] = input[ch] + fb[ch];
       }
 
+      // Track how long the line has held only silence (see isIdle())
+      SampleType written = SampleType(0);
+      for (int ch = 0; ch < numChannels; ++ch)
+        written = std::max(written, std::abs(writeFrame[ch]));
+      silentFrames_ = written > kIdleThreshold
+                          ? 0
+                          : std::min(silentFrames_ + 1, maxDelaySamples_);
+
       // Advance write position
+      writtenFrames_ = std::max(writtenFrames_, writePos_ + 1);
       writePos_ = (writePos_ + 1) % bufferSize;
 
-      // Apply level and pan
-      float panL = std::cos((params_.pan + 1.0f) * 0.25f * 3.14159f);
-      float panR = std::sin((params_.pan + 1.0f) * 0.25f * 3.14159f);
-
-      float wetL = delayedL * params_.level * panL;
-      float wetR = delayedR * params_.level * panR;
+      // Apply level, pan and phase (per-channel gains precomputed)
+      for (int ch = 0; ch < numChannels; ++ch)
+        wet[ch] = delayed[ch] * wetGains_[static_cast<size_t>(ch)];
 
-      // Apply phase inversion if enabled
-      if (params_.phaseInvert) {
-        wetL = -wetL;
-        wetR = -wetR;
+      // Extra read heads (read before this sample's write, like the main
+      // head, so a tap at the band's own time lines up exactly)
+      if constexpr ((Stages & kTaps) != 0) {
+        const float masterMod = masterModSignal ? masterModSignal[i] : 0.0f;
+        accumulateTaps(wet.data(), numChannels, tapWritePos, i, masterMod,
+                       tapModSignals);
       }
 
       // Apply attack envelope for volume swell effect
       // Uses input level to trigger, applies gain to wet signal
-      if (params_.attackTimeMs > 0.0f) {
-        attackEnvelope_.processBlock(inputL, inputR, wetL, wetR);
+      if constexpr ((Stages & kAttack) != 0) {
+        if (inputPeak)
+          attackEnvelope_.processPeak(inputPeak[i], wet.data(), numChannels);
+        else
+          attackEnvelope_.processFrame(input.data(), wet.data(), numChannels);
       }
 
       // Output: dry + wet
-      leftChannel[i] = inputL + wetL * wetMix;
-      if (numChannels > 1)
-        rightChannel[i] = inputR + wetR * wetMix;
+      for (int ch = 0; ch < numChannels; ++ch)
+        channels[ch][i] = dry[ch] + wet[ch] * wetMix;
     }
   }
 
-private:
+  /**
+   * @brief Run the loop at the internal rate, kReducedChunk host samples
+   *        at a time
+   *
+   * The input goes down through the halfband stages and the loop runs on
+   * the internal-rate frames; control signals are held from the host
+   * sample that completes each frame. The wet part (output - input) goes
+   * back up into a FIFO that starts fifoDelay_ (at least rateFactor_ - 1)
+   * frames full, so every host sample has a wet frame. The round trip is
+   * then a whole number of internal samples, outputLead_, and the output
+   * heads read that much ahead of the loop head.
+   */
+  void processReduced(Loop loop, SampleType* const* channels, int numSamples,
+                      int numChannels, SampleType wetMix,
+                      const float* modSignal, const float* masterModSignal,
+                      const float* const* tapModSignals) {
+    const int factor = rateFactor_;
+    std::array<const SampleType*, kMaxChannels> in{};
+    std::array<SampleType*, kMaxChannels> out{}, low{};
+    for (int ch = 0; ch < numChannels; ++ch)
+      low[static_cast<size_t>(ch)] = lowFrames_.getWritePointer(ch);
+
+    for (int start = 0; start < numSamples; start += kReducedChunk) {
+      const int length = std::min(kReducedChunk, numSamples - start);
+
+      // Host rate -> internal rate
+      int count = length;
+      for (int ch = 0; ch < numChannels; ++ch)
+        in[static_cast<size_t>(ch)] = channels[ch] + start;
+      for (int s = 0; s < numRateStages_; ++s) {
+        const bool last = s == numRateStages_ - 1;
+        for (int ch = 0; ch < numChannels; ++ch)
+          out[static_cast<size_t>(ch)] =
+              last ? low[static_cast<size_t>(ch)]
+                   : rateScratch_[static_cast<size_t>(s & 1)]
+                         .getWritePointer(ch);
+        count = decimators_[static_cast<size_t>(s)].process(
+            in.data(), out.data(), count, numChannels);
+        for (int ch = 0; ch < numChannels; ++ch)
+          in[static_cast<size_t>(ch)] = out[static_cast<size_t>(ch)];
+      }
+      for (int ch = 0; ch < numChannels; ++ch)
+        lowInput_.copyFrom(ch, 0, lowFrames_, ch, 0, count);
+
+      // Control signals, held from the host sample completing each frame
+      const int first = start + factor - 1 - hostPhase_;
+      hostPhase_ = (hostPhase_ + length) % factor;
+      auto hold = [&](const float* signal, float* dest) -> const float* {
+        if (signal == nullptr)
+          return nullptr;
+        for (int j = 0; j < count; ++j)
+          dest[j] = signal[first + j * factor];
+        return dest;
+      };
+      const float* mod = hold(modSignal, lowMods_[kMaxTaps].data());
+      const float* master =
+          hold(masterModSignal, lowMods_[kMaxTaps + 1].data());
+      std::array<const float*, kMaxTaps> tapMods{};
+      for (int t = 0; tapModSignals && t < numTaps_; ++t)
+        tapMods[static_cast<size_t>(t)] =
+            hold(tapModSignals[t], lowMods_[static_cast<size_t>(t)].data());
+
+      (this->*loop)(low.data(), count, numChannels, SampleType(1), mod,
+                    master, tapMods.data(), nullptr);
+      for (int ch = 0; ch < numChannels; ++ch) {
+        SampleType* wet = low[static_cast<size_t>(ch)];
+        const SampleType* dry = lowInput_.getReadPointer(ch);
+        for (int j = 0; j < count; ++j)
+          wet[j] -= dry[j];
+      }
+
+      // Wet part: internal rate -> host rate, onto the FIFO
+      for (int ch = 0; ch < numChannels; ++ch)
+        in[static_cast<size_t>(ch)] = low[static_cast<size_t>(ch)];
+      for (int s = numRateStages_ - 1; s >= 0; --s) {
+        for (int ch = 0; ch < numChannels; ++ch)
+          out[static_cast<size_t>(ch)] =
+              s == 0 ? wetFifo_.getWritePointer(ch, fifoFrames_)
+                     : rateScratch_[static_cast<size_t>(s & 1)]
+                           .getWritePointer(ch);
+        interpolators_[static_cast<size_t>(s)].process(
+            in.data(), out.data(), count, numChannels);
+        count *= 2;
+        for (int ch = 0; ch < numChannels; ++ch)
+          in[static_cast<size_t>(ch)] = out[static_cast<size_t>(ch)];
+      }
+
+      // Output: dry + wet, then keep what this chunk did not use
+      const int queued = fifoFrames_ + count;
+      for (int ch = 0; ch < numChannels; ++ch) {
+        SampleType* wet = wetFifo_.getWritePointer(ch);
+        SampleType* io = channels[ch] + start;
+        for (int i = 0; i < length; ++i)
+          io[i] += wet[i] * wetMix;
+        std::copy(wet + length, wet + queued, wet);
+      }
+      fifoFrames_ = queued - length;
+    }
+  }
+
+  /**
+   * @brief Read delay in samples for a (modulated) time, clamped to the
+   *        line
+   */
+  SampleType readDelaySamples(float timeMs) const {
+    const SampleType d = static_cast<SampleType>(timeMs) / SampleType(1000) *
+                         static_cast<SampleType>(internalRate_);
+    return std::clamp(d, kMinReadDelay,
+                      static_cast<SampleType>(maxReadDelay()));
+  }
+
+  void processFusedLine(juce::AudioBuffer<SampleType>& buffer,
+                        const FusedRead* reads, int numReads,
+                        DelayBandNode* const* members, int numMembers) {
+    const int numSamples = buffer.getNumSamples();
+    const int numChannels = std::min(buffer.getNumChannels(), numChannels_);
+    if (numChannels <= 0)
+      return;
+
+    std::array<SampleType*, kMaxChannels> channels{};
+    for (int ch = 0; ch < numChannels; ++ch)
+      channels[static_cast<size_t>(ch)] = buffer.getWritePointer(ch);
+
+    std::array<typename Interpolator::Kernel, kMaxTaps> kernels;
+    const auto maxDelay = static_cast<SampleType>(maxReadDelay());
+    SampleType longest = kMinReadDelay;
+    for (int r = 0; r < numReads; ++r) {
+      const SampleType d =
+          std::clamp(reads[r].delaySamples, kMinReadDelay, maxDelay);
+      longest = std::max(longest, d);
+      Interpolator::makeKernel(params_.interpolation, d,
+                               kernels[static_cast<size_t>(r)]);
+    }
+    fusedReachFrames_ =
+        static_cast<int>(longest) + Interpolator::kMaxOlder + 1;
+
+    std::array<SampleType, kMaxChannels> in{}, out{}, tap{};
+    for (int i = 0; i < numSamples; ++i) {
+      for (int ch = 0; ch < numChannels; ++ch)
+        in[ch] = out[ch] = channels[static_cast<size_t>(ch)][i];
+
+      // Reads first, like the main head, then the write. Member k's input
+      // is complete once the reads of the bands before it, subsets
+      // 1 .. 2^(k+1) - 1, are summed.
+      int member = 0;
+      for (int r = 0; r < numReads; ++r) {
+        for (; member < numMembers && r == (2 << member) - 1; ++member)
+          if (members[member] != nullptr)
+            members[member]->writeFusedFrame(out.data(), numChannels);
+        Interpolator::readFrame(delayLine_.data(), maxDelaySamples_,
+                                numChannels_, numChannels, writePos_,
+                                kernels[static_cast<size_t>(r)], tap.data());
+        const SampleType* gains = reads[r].gains.data();
+        for (int ch = 0; ch < numChannels; ++ch)
+          out[ch] += gains[ch] * tap[ch];
+      }
+      for (; member < numMembers; ++member)
+        if (members[member] != nullptr)
+          members[member]->writeFusedFrame(out.data(), numChannels);
+
+      writeFusedFrame(in.data(), numChannels);
+      for (int ch = 0; ch < numChannels; ++ch)
+        channels[static_cast<size_t>(ch)][i] = out[ch];
+    }
+  }
+
+  /**
+   * @brief Write one input frame at the write head of a fused chain's
+   *        line (the head's, or a member's that keeps recording)
+   */
+  void writeFusedFrame(const SampleType* frame, int numChannels) {
+    SampleType* writeFrame = frameAt(writePos_);
+    SampleType written = SampleType(0);
+    for (int ch = 0; ch < numChannels; ++ch) {
+      writeFrame[ch] = frame[ch];
+      written = std::max(written, std::abs(frame[ch]));
+    }
+    silentFrames_ = written > kIdleThreshold
+                        ? 0
+                        : std::min(silentFrames_ + 1, maxDelaySamples_);
+    writtenFrames_ = std::max(writtenFrames_, writePos_ + 1);
+    writePos_ = (writePos_ + 1) % maxDelaySamples_;
+  }
+
+  /**
+   * @brief Point algorithm_ at the instance for the current type and
+   *        quality, and bring it up to date with the params
+   */
+  void selectAlgorithm() {
+    int index = static_cast<int>(params_.algorithm);
+    if (index < 0 || index >= kNumDelayAlgorithms)
+      index = 0;
+    const auto idx = static_cast<size_t>(index);
+    oversampling_ = oversample_ && oversampledAlgorithms_[idx] != nullptr;
+    algorithm_ = oversampling_ ? oversampledAlgorithms_[idx].get()
+                               : algorithms_[idx].get();
+
+    algorithm_->reset();
+    algorithm_->setDelayTime(params_.delayTimeMs);
+    algorithm_->setPitchSemitones(params_.pitchSemitones);
+    oversampler_.reset();
+    resetInterpolationState();
+    updateLoopLatency();
+  }
+
+  /**
+   * @brief Host samples per internal sample for the current rate and
+   *        settings (see setRateReduction())
+   */
+  int chooseRateFactor() const {
+    int factor = 1;
+    if (rateReduction_ && !oversample_)
+      while (factor < kMaxRateReduction &&
+             sampleRate_ / (2 * factor) >= kMinInternalRate)
+        factor *= 2;
+    return factor;
+  }
+
+  /**
+   * @brief Size the line and prepare everything that runs at the internal
+   *        rate, then reset (allocates; never on the audio thread)
+   */
+  void prepareInternalRate() {
+    acquireLine();
+    clearWrittenRegion();
+    rateFactor_ = chooseRateFactor();
+    numRateStages_ = 0;
+    while ((1 << numRateStages_) < rateFactor_)
+      ++numRateStages_;
+    internalRate_ = sampleRate_ / rateFactor_;
+    // The FIFO tops the round trip up to whole internal samples, so the
+    // output heads read at the loop head's fraction
+    const int resampling = kResamplingDelay * (rateFactor_ - 1);
+    const int lead = (resampling + 2 * rateFactor_ - 2) / rateFactor_;
+    outputLead_ = static_cast<SampleType>(lead);
+    fifoDelay_ = lead * rateFactor_ - resampling;
+
+    // Max delay = 10 seconds + 500ms modulation headroom
+    maxDelaySamples_ = static_cast<int>(10.5 * internalRate_) + 1;
+
+    // Frame-interleaved circular buffer; grow only, never shrink. New
+    // memory is zeroed and pre-faulted here, off the audio thread. A band
+    // detached from a shared arena stays detached.
+    if (lineWanted_)
+      delayLine_.allocate(static_cast<size_t>(maxDelaySamples_) *
+                              static_cast<size_t>(numChannels_),
+                          memoryOptions_);
+    else
+      delayLine_.release();
+    lineResident_.store(!delayLine_.empty(), std::memory_order_relaxed);
+    releaseLine();
+
+    // Prepare every algorithm (buffers such as Shimmer's ring are
+    // allocated here, not when the algorithm is switched)
+    for (auto& algorithm : algorithms_)
+      algorithm->prepare(internalRate_);
+    selectAlgorithm();
+    filterSection_.prepare(internalRate_);
+    attackEnvelope_.prepare(internalRate_);
+
+    // Resampling stages (stage s runs between host rate / 2^s and half
+    // that) and the per-chunk buffers
+    for (int s = 0; s < numRateStages_; ++s) {
+      decimators_[static_cast<size_t>(s)].prepare(numChannels_,
+                                                  kReducedChunk >> s);
+      interpolators_[static_cast<size_t>(s)].prepare(
+          numChannels_, kReducedChunk >> (s + 1));
+    }
+    const bool reduced = rateFactor_ > 1;
+    for (auto& scratch : rateScratch_)
+      scratch.setSize(numChannels_, reduced ? kReducedChunk : 0);
+    lowFrames_.setSize(numChannels_, reduced ? kReducedChunk / 2 : 0);
+    lowInput_.setSize(numChannels_, reduced ? kReducedChunk / 2 : 0);
+    wetFifo_.setSize(numChannels_,
+                     reduced ? kReducedChunk + 2 * kMaxRateReduction : 0);
+    reset();
+  }
+
+  void resetResamplers() {
+    for (int s = 0; s < numRateStages_; ++s) {
+      decimators_[static_cast<size_t>(s)].reset();
+      interpolators_[static_cast<size_t>(s)].reset();
+    }
+    wetFifo_.clear();
+    fifoFrames_ = fifoDelay_;
+    hostPhase_ = 0;
+  }
+
+  void updateLoopLatency() {
+    // Oversampled algorithms report latency in 2x samples
+    loopLatency_ = static_cast<SampleType>(
+        oversampling_ ? 0.5 * algorithm_->getLatencySamples() +
+                            Oversampler2x<SampleType>::kLatency
+                      : algorithm_->getLatencySamples());
+  }
+
+  /**
+   * @brief Feedback frame through the algorithm (2x when oversampling)
+   */
+  void runAlgorithm(SampleType* frame, int numChannels) {
+    if (!oversampling_) {
+      algorithm_->processFrame(frame, numChannels);
+      return;
+    }
+    std::array<SampleType, kMaxChannels> first{}, second{};
+    oversampler_.upsample(frame, first.data(), second.data(), numChannels);
+    algorithm_->processFrame(first.data(), numChannels);
+    algorithm_->processFrame(second.data(), numChannels);
+    oversampler_.downsample(first.data(), second.data(), frame, numChannels);
+  }
+
+  // Read delays stay clear of the write head and the oldest frame so every
+  // kernel's points are valid
+  static constexpr SampleType kMinReadDelay =
+      static_cast<SampleType>(Interpolator::kMaxNewest + 1);
+
+  int maxReadDelay() const {
+    return maxDelaySamples_ - Interpolator::kMaxOlder - 2;
+  }
+
+  SampleType* frameAt(int pos) {
+    return delayLine_.data() +
+           static_cast<size_t>(pos) * static_cast<size_t>(numChannels_);
+  }
+
+  /**
+   * @brief Sum every tap into the wet frame
+   *
+   * Kernels are built for all taps first (one straight loop across taps),
+   * then each tap's frames are blended across channels with its per-channel
+   * gain.
+   */
+  void accumulateTaps(SampleType* wet, int numChannels, int writePos,
+                      int sampleIndex, float masterMod,
+                      const float* const* tapModSignals) {
+    const auto samplesPerMs = static_cast<SampleType>(internalRate_ / 1000.0);
+    const auto maxDelay = static_cast<SampleType>(maxReadDelay());
+
+    std::array<typename Interpolator::Kernel, kMaxTaps> kernels;
+
+    for (int t = 0; t < numTaps_; ++t) {
+      const auto idx = static_cast<size_t>(t);
+      float timeMs = taps_[idx].delayTimeMs;
+      float mod = masterMod;
+      if (tapModSignals && tapModSignals[t])
+        mod += tapModSignals[t][sampleIndex];
+      if (mod != 0.0f)
+        timeMs = std::max(1.0f, timeMs + mod * 25.0f);
+
+      const SampleType d = std::clamp(
+          static_cast<SampleType>(timeMs) * samplesPerMs - outputLead_,
+          kMinReadDelay, maxDelay);
+      Interpolator::makeKernel(params_.interpolation, d, kernels[idx]);
+    }
+
+    std::array<SampleType, kMaxChannels> tap{};
+    for (int t = 0; t < numTaps_; ++t) {
+      const auto idx = static_cast<size_t>(t);
+      Interpolator::readFrame(delayLine_.data(), maxDelaySamples_,
+                              numChannels_, numChannels, writePos,
+                              kernels[idx], tap.data());
+      Interpolator::applyAllpass(kernels[idx], tap.data(),
+                                 tapAllpassState_[idx].data(), numChannels);
+
+      const SampleType* gains = tapGains_[idx].data();
+      for (int ch = 0; ch < numChannels; ++ch)
+        wet[ch] += gains[ch] * tap[ch];
+    }
+  }
+
+  /**
+   * @brief Take the line lock, waiting for the other thread (never call on
+   *        the audio thread)
+   */
+  void acquireLine() const {
+    while (lineLock_.exchange(true, std::memory_order_acquire))
+      std::this_thread::yield();
+  }
+
+  void releaseLine() const {
+    lineLock_.store(false, std::memory_order_release);
+  }
+
+  /**
+   * @brief Zero the frames written since the last clear and rewind
+   *
+   * Writes start at frame 0 after a clear and advance one frame at a time,
+   * so [0, writtenFrames_) is the only span that can be non-zero.
+   */
+  void clearWrittenRegion() {
+    const auto end = static_cast<size_t>(writtenFrames_) *
+                     static_cast<size_t>(numChannels_);
+    std::fill(delayLine_.data(),
+              delayLine_.data() + std::min(end, delayLine_.size()),
+              SampleType(0));
+    writtenFrames_ = 0;
+    writePos_ = 0;
+  }
+
+  void resetInterpolationState() {
+    allpassState_.fill(SampleType(0));
+    loopAllpassState_.fill(SampleType(0));
+    for (auto& state : tapAllpassState_)
+      state.fill(SampleType(0));
+  }
+
+  void updateTapGains() {
+    for (int t = 0; t < numTaps_; ++t) {
+      const auto& tap = taps_[static_cast<size_t>(t)];
+      const float polarity = tap.phaseInvert ? -1.0f : 1.0f;
+      auto& gains = tapGains_[static_cast<size_t>(t)];
+      for (int ch = 0; ch < kMaxChannels; ++ch) {
+        const auto idx = static_cast<size_t>(ch);
+        gains[idx] = inputGains_[idx] != SampleType(0)
+                         ? static_cast<SampleType>(
+                               tap.level * polarity *
+                               panGainForSide(channelSides_[idx], tap.pan))
+                         : SampleType(0);
+      }
+    }
+  }
+
+  /**
+   * @brief Rebuild per-channel gains and ping-pong routing from params
+   *
+   * Unrouted channels get zero input and wet gain, so the per-sample loops
+   * stay branch-free across the frame.
+   */
+  void updateChannelGains() {
+    const float polarity = params_.phaseInvert ? -1.0f : 1.0f;
+
+    std::array<int, kMaxChannels> routed{};
+    int numRouted = 0;
+    for (int ch = 0; ch < kMaxChannels; ++ch) {
+      const auto idx = static_cast<size_t>(ch);
+      const bool isRouted =
+          ch < numChannels_ && ((params_.channelMask >> ch) & 1u) != 0;
+      inputGains_[idx] = isRouted ? SampleType(1) : SampleType(0);
+      wetGains_[idx] =
+          isRouted ? static_cast<SampleType>(
+                         params_.level * polarity *
+                         panGainForSide(channelSides_[idx], params_.pan))
+                   : SampleType(0);
+      pingPongSource_[idx] = ch;
+      if (isRouted)
+        routed[static_cast<size_t>(numRouted++)] = ch;
+    }
+    allChannelsRouted_ = numRouted == numChannels_;
+
+    // Each routed channel receives the feedback of the previous routed one
+    // (identity without ping-pong, so a forced kPingPong stage is neutral)
+    for (int k = 0; params_.pingPong && k < numRouted; ++k) {
+      const int prev = routed[static_cast<size_t>((k + numRouted - 1) %
+                                                  numRouted)];
+      pingPongSource_[static_cast<size_t>(routed[static_cast<size_t>(k)])] =
+          prev;
+    }
+
+    updateTapGains();
+  }
+
   DelayBandParams params_;
-  std::unique_ptr<DelayAlgorithm> algorithm_;
+  std::array<std::unique_ptr<DelayAlgorithm<SampleType>>, kNumDelayAlgorithms>
+      algorithms_;
+  std::array<std::unique_ptr<DelayAlgorithm<SampleType>>, kNumDelayAlgorithms>
+      oversampledAlgorithms_; // Prepared at 2x; null for linear algorithms
+  DelayAlgorithm<SampleType>* algorithm_ = nullptr; // One of the above
+  SampleType loopLatency_ = SampleType(0); // Algorithm (+ oversampler) delay
+
+  // Offline quality: requested, and in effect for the current algorithm
+  Oversampler2x<SampleType> oversampler_;
+  bool oversample_ = false;
+  bool oversampling_ = false;
   double sampleRate_ = 44100.0;
   bool prepared_ = false;
 
-  // Simple circular buffer
-  std::vector<float> bufferL_;
-  std::vector<float> bufferR_;
+  // Reduced internal rate (see setRateReduction()): the factor, its
+  // halfband stages (host side first), the output heads' lead over the
+  // loop head in internal samples, and the per-chunk buffers
+  static constexpr int kMaxRateStages = 3; // 2^3 = kMaxRateReduction
+  static constexpr int kReducedChunk = 64; // Host samples per pass
+  // Resampling delay per (factor - 1) host samples: each stage's
+  // decimator and interpolator delay, in samples at that stage's higher
+  // rate (which add up to factor - 1 host samples)
+  static constexpr int kResamplingDelay =
+      HalfbandDecimator<SampleType>::kDelay +
+      HalfbandInterpolator<SampleType>::kDelay;
+  bool rateReduction_ = true;
+  int rateFactor_ = 1;
+  int numRateStages_ = 0;
+  double internalRate_ = 44100.0;
+  SampleType outputLead_ = SampleType(0);
+  std::array<HalfbandDecimator<SampleType>, kMaxRateStages> decimators_;
+  std::array<HalfbandInterpolator<SampleType>, kMaxRateStages>
+      interpolators_;
+  std::array<juce::AudioBuffer<SampleType>, 2> rateScratch_;
+  juce::AudioBuffer<SampleType> lowFrames_, lowInput_, wetFifo_;
+  std::array<std::array<float, kReducedChunk / 2>, kMaxTaps + 2> lowMods_{};
+  int fifoDelay_ = 0; // Frames the FIFO starts with
+  int fifoFrames_ = 0;
+  int hostPhase_ = 0;
+
+  // Frame-interleaved circular buffer (maxDelaySamples_ x numChannels_ in
+  // use; may be larger after a rate decrease, the excess stays zero)
+  DelayMemory<SampleType> delayLine_;
+  DelayMemoryOptions memoryOptions_;
+  mutable std::atomic<bool> lineLock_{false}; // Held while the line is touched
+  std::atomic<bool> lineResident_{false}; // !delayLine_.empty(), any thread
+  bool lineWanted_ = true;
+  int maxDelaySamples_ = 0;
+  int numChannels_ = 2;
   int writePos_ = 0;
 
-  float feedbackL_ = 0.0f;
-  float feedbackR_ = 0.0f;
+  // Frames written since the last clear (high-water mark of writePos_)
+  int writtenFrames_ = 0;
+
+  // Consecutive silent frames written to the line (capped at its length)
+  static constexpr SampleType kIdleThreshold = SampleType(3.0e-5); // -90dB
+  int silentFrames_ = 0;
+  int fusedReachFrames_ = 0; // Longest fused read (see processFused())
+
+  // Previous Allpass-tier outputs (main head, loop head and taps)
+  std::array<SampleType, kMaxChannels> allpassState_{};
+  std::array<SampleType, kMaxChannels> loopAllpassState_{};
+  std::array<std::array<SampleType, kMaxChannels>, kMaxTaps>
+      tapAllpassState_{};
+
+  // Per-channel routing and pan/level gains
+  std::array<ChannelSide, kMaxChannels> channelSides_{};
+  std::array<SampleType, kMaxChannels> inputGains_{};
+  std::array<SampleType, kMaxChannels> wetGains_{};
+  std::array<int, kMaxChannels> pingPongSource_{};
+  bool allChannelsRouted_ = true;
+
+  // Loop stages (see Stage): forced on, and run by the last block
+  uint32_t forcedStages_ = 0;
+  uint32_t activeStages_ = 0;
+
+  // Extra read heads (multi-tap)
+  std::array<DelayTapParams, kMaxTaps> taps_{};
+  std::array<std::array<SampleType, kMaxChannels>, kMaxTaps> tapGains_{};
+  int numTaps_ = 0;
 
   // Filter section for feedback path
-  FilterSection filterSection_;
+  FilterSection<SampleType> filterSection_;
 
   // Attack envelope for volume swell effects
   AttackEnvelope attackEnvelope_;
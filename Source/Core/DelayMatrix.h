@@ -2,15 +2,24 @@
 
 #include "../UI/NodeVisual.h"
 #include "DelayBandNode.h"
+#include "FanInMix.h"
+#include "InputAnalysis.h"
 #include "ModulationEngine.h"
 #include "RoutingGraph.h"
+#include "RoutingPlan.h"
 #include "SafetyLimiter.h"
+#include "TailLength.h"
+#include "WorkerPool.h"
 
 #include <juce_audio_basics/juce_audio_basics.h>
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cstdint>
 #include <memory>
-#include <unordered_map>
+#include <new>
+#include <system_error>
 #include <vector>
 
 namespace uds {
@@ -20,52 +29,288 @@ namespace uds {
  *
  * Processes bands in topological order based on RoutingGraph connections.
  * Supports series, parallel, and complex feedback routing.
+ *
+ * Templated on sample type; the processor instantiates a float and a double
+ * matrix and only prepares the one matching the host's processing precision.
+ *
+ * Channel count follows the host bus (mono, stereo, quad, 5.1, 7.1.4 ... up
+ * to kMaxChannels). Each band can be routed to a subset of those channels
+ * via DelayBandParams::channelMask.
+ *
+ * Multi-tap nodes: a band given a tap parent (setBandTapParent) stops owning
+ * a delay line and instead becomes a read head on its parent's line, keeping
+ * its own time/level/pan/polarity/modulation. The parent's time, feedback,
+ * filters and algorithm drive the single shared feedback loop.
  */
-class DelayMatrix {
+template <typename SampleType> class DelayMatrix {
 public:
   static constexpr int NUM_BANDS = 8;  // Current active bands
   static constexpr int MAX_BANDS = 12; // Maximum allocatable bands
 
   DelayMatrix() = default;
 
-  void prepare(double sampleRate, size_t maxBlockSize) {
+  /**
+   * @brief Prepare for playback (incremental)
+   *
+   * Bands and buffers are created once and reused: re-preparing with an
+   * unchanged configuration keeps every allocation and all delay state,
+   * and buffers only reallocate when they need to grow.
+   */
+  void prepare(double sampleRate, size_t maxBlockSize, int numChannels = 2) {
+    const int channels = std::clamp(numChannels, 1, kMaxChannels);
+    const bool formatChanged = !prepared_ || sampleRate != sampleRate_ ||
+                               channels != numChannels_;
+
     sampleRate_ = sampleRate;
     maxBlockSize_ = maxBlockSize;
+    numChannels_ = channels;
 
-    // Create bands (allocate MAX_BANDS for future expansion)
-    bands_.clear();
-    for (int i = 0; i < MAX_BANDS; ++i) {
-      bands_.push_back(std::make_unique<DelayBandNode>());
-      bands_.back()->prepare(sampleRate, maxBlockSize);
+    if (formatChanged) {
+      for (int ch = 0; ch < kMaxChannels; ++ch)
+        channelSides_[static_cast<size_t>(ch)] =
+            defaultChannelSide(ch, numChannels_);
+    }
+
+    // Create bands once (allocate MAX_BANDS for future expansion); each band
+    // keeps its line when the format is unchanged
+    if (bands_.size() != static_cast<size_t>(MAX_BANDS)) {
+      bands_.clear();
+      for (int i = 0; i < MAX_BANDS; ++i) {
+        bands_.push_back(std::make_unique<DelayBandNode<SampleType>>());
+        bands_.back()->setMemoryOptions(memoryOptions_);
+      }
     }
+    for (auto& band : bands_)
+      band->prepare(sampleRate, maxBlockSize, numChannels_);
 
-    // Prepare safety limiter
-    limiter_.prepare(sampleRate);
+    if (formatChanged) {
+      // Prepare safety limiter
+      limiter_.prepare(sampleRate);
+    }
 
     // Prepare modulation engine
     modulationEngine_.prepare(sampleRate, maxBlockSize);
 
-    // Allocate node buffers (Input=0, Bands=1-8, Output=9)
-    for (int i = 0; i < kNumNodes; ++i) {
-      nodeBuffers_[i].setSize(2, static_cast<int>(maxBlockSize));
+    // Feedback rings per node (Input=0, Bands=1-12, Output=13)
+    if (formatChanged) {
+      for (auto& state : planStates_) {
+        for (auto& ring : state.rings) {
+          ring.setSize(numChannels_, kFeedbackRingSize, false, false, true);
+          ring.clear();
+        }
+        state.ringPos.fill(0);
+      }
     }
+    for (auto& band : bands_)
+      band->setOversampling(offlineQuality_);
+    allocateTiles();
 
     prepared_ = true;
   }
 
+  /**
+   * @brief Offline-render quality (call with processing suspended)
+   *
+   * On: nonlinear band algorithms run 2x oversampled and independent bands
+   * of each routing level run in parallel on a worker pool. Threads and
+   * per-band scratch buffers are created here, never on the audio thread;
+   * the worker pool is not real-time safe, so leave this off for live
+   * playback. Never throws: if the threads or buffers cannot be created,
+   * the pool stays stopped and offline blocks run serially in live-sized
+   * tiles.
+   */
+  void setOfflineQuality(bool enabled) {
+    offlineQuality_ = enabled;
+    try {
+      for (auto& band : bands_)
+        band->setOversampling(enabled);
+
+      if (enabled) {
+        const int cores =
+            static_cast<int>(std::thread::hardware_concurrency());
+        if (workerPool_.getNumWorkers() == 0)
+          workerPool_.start(std::clamp(cores - 1, 0, kMaxWorkers));
+      } else {
+        workerPool_.stop();
+      }
+      if (prepared_)
+        allocateTiles();
+    } catch (const std::system_error&) {
+      processOfflineSerially();
+    } catch (const std::bad_alloc&) {
+      processOfflineSerially();
+    }
+  }
+
+  bool isOfflineQuality() const { return offlineQuality_; }
+
+  /**
+   * @brief Free all band and node memory (used when the other precision
+   * path becomes active)
+   */
+  void release() {
+    bands_.clear();
+    for (auto& state : planStates_)
+      for (auto& node : state.nodes)
+        node.setSize(0, 0);
+    prepared_ = false;
+  }
+
+  bool isPrepared() const { return prepared_; }
+  int getNumChannels() const { return numChannels_; }
+
+  /**
+   * @brief Tell the bands which side of the listener each channel sits on
+   *
+   * Call from prepareToPlay with the host layout; pan and dry pan use it.
+   */
+  void setChannelSides(const ChannelSide* sides, int numChannels) {
+    const int n = std::min(numChannels, kMaxChannels);
+    for (int ch = 0; ch < n; ++ch)
+      channelSides_[static_cast<size_t>(ch)] = sides[ch];
+    for (auto& band : bands_) {
+      if (band)
+        band->setChannelSides(channelSides_.data(), kMaxChannels);
+    }
+  }
+
+  /**
+   * @brief CPU governor hooks (see CpuGovernor.h)
+   * @param stride Modulation control-rate stride (1 = per sample)
+   */
+  void setModulationControlStride(int stride) {
+    modulationEngine_.setControlStride(stride);
+  }
+
+  /**
+   * @brief Skip idle bands whose input is silent (see DelayBandNode::isIdle)
+   */
+  void setSleepQuietBands(bool shouldSleep) { sleepQuietBands_ = shouldSleep; }
+
+  /**
+   * @brief Delay-line memory policy (see DelayMemory.h; message thread)
+   *
+   * Switching a shared arena or locking on or off after prepare() moves
+   * every resident line to the new backing (contents are dropped).
+   */
+  void setMemoryOptions(const DelayMemoryOptions& options) {
+    const bool migrate = prepared_ && (options.arena != memoryOptions_.arena ||
+                                       options.lock != memoryOptions_.lock);
+    memoryOptions_ = options;
+    arenaActive_.store(options.arena != nullptr);
+    for (auto& band : bands_) {
+      band->setMemoryOptions(options);
+      if (migrate && band->isLineResident()) {
+        band->setLineResident(false);
+        band->setLineResident(true);
+      }
+    }
+  }
+
+  /**
+   * @brief Check shared-arena lines in and out (message thread, e.g. timer)
+   *
+   * Bands that are disabled, unrouted or tap children give their block back;
+   * so does every band once the whole matrix has been silent for
+   * kArenaSleepSeconds. Lines are attached again on the next call after a
+   * band becomes active, so its first echoes in the meantime are lost.
+   */
+  void updateMemoryResidency() {
+    if (!prepared_ || !memoryOptions_.arena)
+      return;
+    const bool asleep =
+        silentSamples_.load() >=
+        static_cast<int64_t>(kArenaSleepSeconds * sampleRate_);
+    for (size_t i = 0; i < bands_.size(); ++i)
+      bands_[i]->setLineResident(!asleep && !bandDormant_[i].load());
+  }
+
+  /**
+   * @brief True once the input is silent and every active band has rung
+   *        out; processWithRouting() then skips the matrix
+   */
+  bool isSilent() const { return silentSamples_.load() > 0; }
+
+  /**
+   * @brief Tail for the current params and routing (seconds, may be
+   *        infinite; updated every block, readable from any thread)
+   */
+  double getTailLengthSeconds() const { return tailSeconds_.load(); }
+
+  /**
+   * @brief Optimizer passes for the routing plan (RoutingPlan::Pass bits;
+   *        0 runs the graph exactly as drawn)
+   */
+  void setPlanPasses(uint32_t passes) { planPasses_ = passes; }
+  uint32_t getPlanPasses() const { return planPasses_; }
+
+  /** @brief The plan the last block ran (audio thread only) */
+  const RoutingPlan& getPlan() const { return live().plan; }
+
+  /**
+   * @brief Share one InputAnalysis per band input signal (default on)
+   *
+   * Off, every band measures its own input. For tests and benchmarks; the
+   * output is the same either way.
+   */
+  void setShareInputAnalysis(bool share) { shareAnalysis_ = share; }
+
+  /** @brief Signals analysed in the last tile (audio thread only) */
+  int getAnalysedInputs() const { return numAnalysed_; }
+
+  /**
+   * @brief Shared analysis of a band's input in the last tile, or null if
+   *        the band measured its own (audio thread only)
+   */
+  const InputAnalysis<SampleType>* getInputAnalysis(int bandIndex) const {
+    const int key = analysisKey(live().plan, bandIndex + 1);
+    return key >= 0 && analysed_[static_cast<size_t>(key)]
+               ? &analyses_[static_cast<size_t>(key)]
+               : nullptr;
+  }
+
+  static constexpr float kMaxRoutingFadeMs = 50.0f;
+  static constexpr float kDefaultRoutingFadeMs = 20.0f;
+
+  /**
+   * @brief Crossfade time for routing changes (0 = switch at once)
+   *
+   * When the connections change, the outgoing plan keeps running beside
+   * the new one for this long and the two outputs are crossfaded. Clamped
+   * to kMaxRoutingFadeMs, so a change costs a bounded amount of extra CPU.
+   */
+  void setRoutingFadeMs(float ms) {
+    routingFadeMs_ = std::clamp(ms, 0.0f, kMaxRoutingFadeMs);
+  }
+  float getRoutingFadeMs() const { return routingFadeMs_; }
+
+  /** @brief True while a routing change is being crossfaded */
+  bool isRoutingFading() const { return fadeRemaining_ > 0; }
+
+  /**
+   * @brief Combined pre-fault/lock/huge-page status of all delay lines
+   */
+  DelayMemoryStatus getMemoryStatus() const {
+    DelayMemoryStatus status;
+    for (const auto& band : bands_)
+      status += band->getMemoryStatus();
+    return status;
+  }
+
   void reset() {
     for (auto& band : bands_) {
       if (band)
         band->reset();
     }
-    limiter_.reset();
-    modulationEngine_.reset();
+    bandParked_.fill(false);
+    resetSharedState();
   }
 
   void setBandParams(int bandIndex, const DelayBandParams& params) {
     if (bandIndex >= 0 && bandIndex < static_cast<int>(bands_.size())) {
       if (bands_[static_cast<size_t>(bandIndex)]) {
         bands_[static_cast<size_t>(bandIndex)]->setParams(params);
+        bandParams_[static_cast<size_t>(bandIndex)] = params;
 
         // Forward modulation params to engine
         modulationEngine_.setBandParams(bandIndex, params.modulationType,
@@ -74,6 +319,42 @@ public:
     }
   }
 
+  /**
+   * @brief Make a band a read head on another band's line (-1 = own line)
+   *
+   * Ignored (band keeps its own line) if the parent is itself a tap or is
+   * the band itself.
+   */
+  void setBandTapParent(int bandIndex, int parentIndex) {
+    if (bandIndex >= 0 && bandIndex < MAX_BANDS)
+      tapParent_[static_cast<size_t>(bandIndex)] =
+          (parentIndex >= 0 && parentIndex < MAX_BANDS) ? parentIndex : -1;
+  }
+
+  int getBandTapParent(int bandIndex) const {
+    if (bandIndex >= 0 && bandIndex < MAX_BANDS)
+      return tapParent_[static_cast<size_t>(bandIndex)];
+    return -1;
+  }
+
+  /**
+   * @brief True if the band currently reads from a parent's line
+   */
+  bool isTapChild(int bandIndex) const {
+    const int parent = getBandTapParent(bandIndex);
+    return parent >= 0 && parent != bandIndex &&
+           tapParent_[static_cast<size_t>(parent)] < 0;
+  }
+
+  /**
+   * @brief True while the band is out of the plan (see compilePlan()),
+   *        including while its line is still being cleared
+   */
+  bool isBandParked(int bandIndex) const {
+    return bandIndex >= 0 && bandIndex < MAX_BANDS &&
+           bandParked_[static_cast<size_t>(bandIndex)];
+  }
+
   /**
    * @brief Get the routing graph for external manipulation
    */
@@ -83,282 +364,1180 @@ public:
   /**
    * @brief Process audio through the delay matrix using routing graph
    */
-  void process(juce::AudioBuffer<float>& buffer, float wetMix,
+  void process(juce::AudioBuffer<SampleType>& buffer, SampleType wetMix,
                float dryLevel = 1.0f, float dryPan = 0.0f) {
+    processWithRouting(buffer, wetMix, routingGraph_, dryLevel, dryPan);
+  }
+
+  /**
+   * @brief Process audio using an external routing graph
+   */
+  void processWithRouting(juce::AudioBuffer<SampleType>& buffer,
+                          SampleType wetMix,
+                          const RoutingGraph& externalRouting,
+                          float dryLevel = 1.0f, float dryPan = 0.0f) {
+    processGraph(buffer, wetMix, externalRouting, dryLevel, dryPan, false);
+  }
+
+  /**
+   * @brief Spill bypass: the buffer passes through at unity and is not
+   *        written to the lines, while the tails already in them ring out
+   *        on top
+   *
+   * Once every tail has gone the call returns straight away (see
+   * isSilent()); combine with setSleepQuietBands(true) so bands stop one
+   * by one as they decay.
+   */
+  void processTails(juce::AudioBuffer<SampleType>& buffer, SampleType wetMix,
+                    const RoutingGraph& externalRouting) {
+    processGraph(buffer, wetMix, externalRouting, 1.0f, 0.0f, true);
+  }
+
+  /**
+   * @brief Hard bypass: no DSP, the buffer is left as it is
+   *
+   * Each call zeroes at most kBypassClearSamples of the lines' written
+   * spans, so the memory is clean by the time playback resumes.
+   */
+  void processHardBypass() {
+    size_t budget = kBypassClearSamples;
+    for (auto& band : bands_) {
+      if (budget == 0)
+        break;
+      budget = band->clearWrittenStep(budget);
+    }
+    bandLevels_.fill(0.0f);
+  }
+
+  /**
+   * @brief Leave hard bypass in constant time: reset the per-sample state
+   *
+   * Bands whose lines are not clean yet (a short bypass) stay parked and
+   * pass audio through; compilePlan() keeps clearing them a slice per
+   * block and lets them rejoin once they are clean.
+   */
+  void resumeFromHardBypass() {
+    for (size_t i = 0; i < bands_.size(); ++i) {
+      auto& band = *bands_[i];
+      if (band.hasWrittenFrames())
+        bandParked_[i] = true;
+      else
+        band.reset();
+    }
+    resetSharedState();
+    silentSamples_.store(0);
+  }
+
+private:
+  /**
+   * @brief Reset everything but the bands: routing rings, analyses, fade,
+   *        limiter and modulation
+   */
+  void resetSharedState() {
+    for (auto& state : planStates_) {
+      for (auto& ring : state.rings)
+        ring.clear();
+      state.ringPos.fill(0);
+    }
+    for (auto& analysis : analyses_)
+      analysis.reset();
+    fadeRemaining_ = 0;
+    limiter_.reset();
+    modulationEngine_.reset();
+  }
+
+  void processGraph(juce::AudioBuffer<SampleType>& buffer, SampleType wetMix,
+                    const RoutingGraph& externalRouting, float dryLevel,
+                    float dryPan, bool tailsOnly) {
     if (!prepared_ || bands_.empty())
       return;
 
     const int numSamples = buffer.getNumSamples();
-    const int numChannels = std::min(2, buffer.getNumChannels());
+    const int numChannels = std::min(numChannels_, buffer.getNumChannels());
     if (numSamples == 0 || numChannels == 0)
       return;
 
-    // Clear all node buffers
-    for (auto& [id, buf] : nodeBuffers_) {
-      buf.clear();
+    updateTailLength(externalRouting);
+    // A change while a fade runs waits for it to finish; until then the
+    // live plan keeps the routing it is fading to
+    const bool holdPlan =
+        fadeRemaining_ > 0 && routingDiffers(externalRouting);
+    const bool routingChanged = !holdPlan && noteRouting(externalRouting);
+
+    // Every line has rung out and the input is silent (or not fed): the
+    // output would be the input, so skip the matrix until something arrives
+    const bool inputSilent =
+        tailsOnly || buffer.getMagnitude(0, numSamples) < kSleepThreshold;
+    const int64_t silent = silentSamples_.load(std::memory_order_relaxed);
+    if (silent > 0 && inputSilent) {
+      silentSamples_.store(silent + numSamples, std::memory_order_relaxed);
+      bandLevels_.fill(0.0f);
+      fadeRemaining_ = 0; // Nothing sounding to fade
+      clearParkedLines(kBypassClearSamples);
+      return;
+    }
+    if (routingChanged && silent == 0)
+      startRoutingFade();
+
+    // Hand each multi-tap parent its read heads (the modulation buffers
+    // they point into are refilled tile by tile), then plan the block
+    updateTapGroups(modulationEngine_.getLocalBuffer());
+    compilePlan(externalRouting, holdPlan);
+
+    // Run the whole plan one tile at a time. Node buffers are a tile long,
+    // so their working set stays in cache, and host blocks of any size
+    // (even beyond the prepared maximum) are safe.
+    bandLevels_.fill(0.0f);
+    for (int start = 0; start < numSamples; start += tileSize_) {
+      const int length = std::min(tileSize_, numSamples - start);
+      processTile(buffer, start, length, numChannels, wetMix, dryLevel,
+                  dryPan, tailsOnly);
     }
 
-    // Store dry signal
-    juce::AudioBuffer<float> dryBuffer;
-    dryBuffer.makeCopyOf(buffer);
+    // Tap children share their parent's activity
+    for (int i = 0; i < MAX_BANDS; ++i) {
+      if (isTapChild(i)) {
+        const auto parent = static_cast<size_t>(getBandTapParent(i));
+        bandLevels_[static_cast<size_t>(i)] = bandLevels_[parent];
+      }
+    }
 
-    // Copy input to Input node buffer
-    for (int ch = 0; ch < numChannels; ++ch) {
-      nodeBuffers_[0].copyFrom(ch, 0, buffer, ch, 0, numSamples);
+    trackLineUse(inputSilent, numSamples);
+  }
+
+  /**
+   * @brief Run the full plan over [tileStart, tileStart + tileLength)
+   *
+   * While a routing change fades, the outgoing plan runs after the live
+   * one and the two Output nodes are crossfaded before the limiter.
+   */
+  void processTile(juce::AudioBuffer<SampleType>& buffer, int tileStart,
+                   int tileLength, int numChannels, SampleType wetMix,
+                   float dryLevel, float dryPan, bool tailsOnly) {
+    const bool fading = fadeRemaining_ > 0;
+    for (auto* state : {&live(), fading ? &outgoing() : nullptr}) {
+      if (state == nullptr)
+        continue;
+      auto& inputNode = state->nodes[static_cast<size_t>(NodeId::Input)];
+      for (int ch = 0; ch < numChannels; ++ch) {
+        if (tailsOnly)
+          inputNode.clear(ch, 0, tileLength); // Silent for tails only
+        else
+          inputNode.copyFrom(ch, 0, buffer, ch, tileStart, tileLength);
+      }
     }
 
-    // Process Modulation Engine for this block
-    modulationEngine_.process(numSamples);
+    // Process Modulation Engine for this tile
+    modulationEngine_.process(tileLength);
     const auto& localMods = modulationEngine_.getLocalBuffer();
     const auto& masterMod = modulationEngine_.getMasterBuffer();
     const float* masterModRead = masterMod.getReadPointer(0);
 
-    // Process nodes in topological order
-    const auto& order = routingGraph_.getProcessingOrder();
-
-    for (int nodeId : order) {
-      if (nodeId == static_cast<int>(NodeId::Input)) {
-        // Input node: already filled with input buffer
-        continue;
+    runPlan(live(), tileLength, numChannels, localMods, masterModRead);
+    if (fading)
+      runPlan(outgoing(), tileLength, numChannels, localMods, masterModRead);
+
+    const auto& plan = live().plan;
+    // Peak level per band for activity indicators (bands fused into a
+    // chain show the chain's output)
+    for (int s = 0; s < plan.getNumSteps(); ++s) {
+      const auto& step = plan.getStep(s);
+      for (int i = step.first; i < step.first + step.count; ++i) {
+        const int nodeId = plan.getNode(i);
+        const int bandIndex = nodeId - 1;
+        if (bandIndex < 0 || bandIndex >= MAX_BANDS)
+          continue;
+
+        float peak = bandLevels_[static_cast<size_t>(bandIndex)];
+        for (int ch = 0; ch < numChannels; ++ch) {
+          auto range = juce::FloatVectorOperations::findMinAndMax(
+              live().nodes[static_cast<size_t>(nodeId)].getReadPointer(ch),
+              tileLength);
+          peak = std::max(peak, static_cast<float>(std::max(
+                                    std::abs(range.getStart()),
+                                    std::abs(range.getEnd()))));
+        }
+        bandLevels_[static_cast<size_t>(bandIndex)] = peak;
+        for (int m = 0; m < plan.getChainLength(nodeId) - 1; ++m)
+          bandLevels_[static_cast<size_t>(plan.getChainBand(nodeId, m) - 1)] =
+              peak;
       }
+    }
 
-      if (nodeId == static_cast<int>(NodeId::Output)) {
-        // Output node: sum all inputs into output
-        auto inputs = routingGraph_.getInputsFor(nodeId);
-        for (int srcId : inputs) {
-          for (int ch = 0; ch < numChannels; ++ch) {
-            nodeBuffers_[nodeId].addFrom(ch, 0, nodeBuffers_[srcId], ch, 0,
-                                         numSamples);
-          }
-        }
-        continue;
+    // Get output node result
+    auto& wetBuffer = live().nodes[static_cast<size_t>(NodeId::Output)];
+    if (fading)
+      crossfadeOutgoing(wetBuffer, tileLength, numChannels);
+
+    // Apply safety limiter (linked across all channels)
+    limiter_.process(wetBuffer.getArrayOfWritePointers(), numChannels,
+                     tileLength);
+
+    // Final mix: output = dry * dryLevel * dryPan + wet * wetMix. The
+    // buffer still holds this tile's dry input.
+    for (int ch = 0; ch < numChannels; ++ch) {
+      const SampleType* wet = wetBuffer.getReadPointer(ch);
+      SampleType* out = buffer.getWritePointer(ch, tileStart);
+      const auto dryGain =
+          tailsOnly
+              ? SampleType(1)
+              : static_cast<SampleType>(
+                    panGainForSide(channelSides_[static_cast<size_t>(ch)],
+                                   dryPan) *
+                    dryLevel);
+
+      for (int s = 0; s < tileLength; ++s) {
+        out[s] = out[s] * dryGain + wet[s] * wetMix;
       }
+    }
+  }
 
-      // Band node (1-8): sum inputs, process through delay, store output
-      int bandIndex = nodeId - 1;
-      if (bandIndex < 0 || bandIndex >= static_cast<int>(bands_.size()))
-        continue;
+public:
+  // Serialization for state save/restore
+  juce::String getRoutingState() const {
+    // TODO: Serialize routing graph connections
+    return "{}";
+  }
 
-      auto& band = bands_[static_cast<size_t>(bandIndex)];
-      if (!band)
-        continue;
+  void setRoutingState(const juce::String& /*state*/) {
+    // TODO: Deserialize routing graph connections
+  }
 
-      // Sum all inputs for this band
-      auto inputs = routingGraph_.getInputsFor(nodeId);
-      juce::AudioBuffer<float> bandInput(numChannels, numSamples);
-      bandInput.clear();
+  // Get output level for a band (for activity indicators)
+  float getBandLevel(int bandIndex) const {
+    if (bandIndex >= 0 && bandIndex < 8)
+      return bandLevels_[static_cast<size_t>(bandIndex)];
+    return 0.0f;
+  }
 
-      for (int srcId : inputs) {
-        for (int ch = 0; ch < numChannels; ++ch) {
-          bandInput.addFrom(ch, 0, nodeBuffers_[srcId], ch, 0, numSamples);
-        }
-      }
+  // Safety limiter access for UI
+  bool isSafetyMuted() const { return limiter_.isPermanentlyMuted(); }
+  SafetyMuteReason getSafetyMuteReason() const {
+    return limiter_.getMuteReason();
+  }
+  void unlockSafetyMute() { limiter_.unlockPermanentMute(); }
 
-      // Process through delay band (wet only, no dry mix)
-      // Get modulation signal for this band (Channel = bandIndex)
-      const float* localModRead = localMods.getReadPointer(bandIndex);
+  /**
+   * @brief Set master LFO parameters
+   */
+  void setMasterLfo(float rate, float depth, int waveform) {
+    masterLfoDepth_ = depth;
+    // Forward to engine
+    modulationEngine_.setMasterParams(static_cast<ModulationType>(waveform),
+                                      rate, depth);
+  }
 
-      band->process(bandInput, 1.0f, localModRead, masterModRead);
+private:
+  /**
+   * @brief A compiled plan and the buffers it runs on
+   *
+   * Fan-in groups have at least two members, so there are at most
+   * kNumNodes / 2. The bands themselves are shared by both states.
+   */
+  struct PlanState {
+    RoutingPlan plan;
+    std::array<std::array<typename DelayBandNode<SampleType>::FusedRead,
+                          RoutingPlan::kMaxFusedReads>,
+               kNumNodes>
+        fusedReads{};
+    std::array<int, kNumNodes> numFusedReads{};
+    static_assert(DelayBandNode<SampleType>::kMaxFusedMembers ==
+                  RoutingPlan::kMaxFused - 1);
+    std::array<juce::AudioBuffer<SampleType>, kNumNodes> nodes;
+    std::array<juce::AudioBuffer<SampleType>, kNumNodes / 2> fanInSums;
+    std::array<bool, kNumNodes / 2> fanInReady{};
+    std::array<juce::AudioBuffer<SampleType>, kNumNodes> rings;
+    std::array<int, kNumNodes> ringPos{};
+  };
 
-      // Store in node buffer
-      for (int ch = 0; ch < numChannels; ++ch) {
-        nodeBuffers_[nodeId].copyFrom(ch, 0, bandInput, ch, 0, numSamples);
-      }
+  /**
+   * @brief Size the per-tile buffers
+   *
+   * Live, a tile is kTileSize samples (or the whole block if smaller).
+   * Offline with a worker pool the tile is a whole prepared block, so the
+   * pool is dispatched once per routing depth rather than once per tile.
+   * reallocate drops the old allocations first (after a failed resize).
+   */
+  void allocateTiles(bool reallocate = false) {
+    const bool parallel = offlineQuality_ && workerPool_.getNumWorkers() > 0;
+    const bool keep = !reallocate;
+    const int maxBlock = std::max(1, static_cast<int>(maxBlockSize_));
+    tileSize_ = parallel ? maxBlock : std::min(kTileSize, maxBlock);
+    for (auto& state : planStates_) {
+      for (auto& node : state.nodes)
+        node.setSize(numChannels_, tileSize_, false, false, keep);
+      for (auto& sum : state.fanInSums)
+        sum.setSize(numChannels_, tileSize_, false, false, keep);
+    }
+    for (auto& wet : fadeWet_)
+      wet.setSize(numChannels_, tileSize_, false, false, keep);
+    bandScratch_.setSize(numChannels_, tileSize_, false, false, keep);
+    for (auto& analysis : analyses_)
+      analysis.prepare(sampleRate_, tileSize_);
+    for (auto& scratch : parallelScratch_) {
+      if (parallel)
+        scratch.setSize(numChannels_, tileSize_, false, false, keep);
+      else
+        scratch.setSize(0, 0);
     }
+  }
 
-    // Get output node result (this is the wet signal)
-    auto& wetBuffer = nodeBuffers_[static_cast<int>(NodeId::Output)];
+  /**
+   * @brief Offline setup failed: stop the pool and size the tiles for
+   *        serial processing on the calling thread
+   */
+  void processOfflineSerially() {
+    workerPool_.stop();
+    if (prepared_)
+      allocateTiles(true);
+  }
 
-    // Apply safety limiter to wet signal
-    if (numChannels >= 2) {
-      limiter_.process(wetBuffer.getWritePointer(0),
-                       wetBuffer.getWritePointer(1), numSamples);
+  /**
+   * @brief Run one plan's steps over the tile (see RoutingPlan.h)
+   *
+   * Acyclic nodes run over the whole tile; feedback loops run together in
+   * sub-blocks, with feedback edges one sub-block late. Offline, the live
+   * plan's acyclic nodes are grouped by routing depth and each depth runs
+   * in parallel.
+   */
+  void runPlan(PlanState& state, int tileLength, int numChannels,
+               const juce::AudioBuffer<float>& localMods,
+               const float* masterModRead) {
+    const auto& plan = state.plan;
+
+    // Every scheduled node overwrites its range with its mixed inputs, so
+    // only an unscheduled Output node needs clearing
+    if (plan.getRole(static_cast<int>(NodeId::Output)) ==
+        RoutingPlan::Role::Skip)
+      for (int ch = 0; ch < numChannels; ++ch)
+        state.nodes[static_cast<size_t>(NodeId::Output)].clear(ch, 0,
+                                                              tileLength);
+
+    const bool parallel = &state == &live() && offlineQuality_ &&
+                          workerPool_.getNumWorkers() > 0;
+    if (parallel)
+      levels_.clear();
+    state.fanInReady.fill(false);
+    if (&state == &live()) {
+      analysed_.fill(false);
+      numAnalysed_ = 0;
     }
 
-    // Final mix: output = dry * dryLevel * dryPan + wet * wetMix
-    // Pan law: equal power panning using cos/sin
-    float dryPanL = std::cos((dryPan + 1.0f) * 0.25f * 3.14159f) * dryLevel;
-    float dryPanR = std::sin((dryPan + 1.0f) * 0.25f * 3.14159f) * dryLevel;
-
-    for (int ch = 0; ch < numChannels; ++ch) {
-      const float* dry = dryBuffer.getReadPointer(ch);
-      const float* wet = wetBuffer.getReadPointer(ch);
-      float* out = buffer.getWritePointer(ch);
-      float dryGain = (ch == 0) ? dryPanL : dryPanR;
+    for (int s = 0; s < plan.getNumSteps(); ++s) {
+      const auto& step = plan.getStep(s);
+      const int end = step.first + step.count;
+      if (!step.cyclic) {
+        for (int i = step.first; i < end; ++i) {
+          const int nodeId = plan.getNode(i);
+          if (parallel)
+            levels_.add(nodeId, plan);
+          else
+            processNode(state, nodeId, 0, tileLength, numChannels, localMods,
+                        masterModRead, 0, bandScratch_);
+        }
+        continue;
+      }
 
-      for (int s = 0; s < numSamples; ++s) {
-        out[s] = dry[s] * dryGain + wet[s] * wetMix;
+      if (parallel)
+        runLevels(tileLength, numChannels, localMods, masterModRead);
+
+      const int chunk = getCycleChunkSize(plan, step);
+      for (int start = 0; start < tileLength; start += chunk) {
+        const int length = std::min(chunk, tileLength - start);
+        for (int i = step.first; i < end; ++i)
+          processNode(state, plan.getNode(i), start, length, numChannels,
+                      localMods, masterModRead, chunk, bandScratch_);
+        for (int i = step.first; i < end; ++i)
+          advanceFeedbackRing(state, plan.getNode(i), length);
       }
     }
+    if (parallel)
+      runLevels(tileLength, numChannels, localMods, masterModRead);
   }
 
   /**
-   * @brief Process audio using an external routing graph
+   * @brief Run one node of a plan over [start, start + length) of the tile
+   *
+   * @param feedbackDelay Sub-block size of the enclosing loop (0 outside
+   *        loops). Inputs over feedback edges are read from the source's
+   *        wet-signal ring this many samples back.
    */
-  void processWithRouting(juce::AudioBuffer<float>& buffer, float wetMix,
-                          const RoutingGraph& externalRouting,
-                          float dryLevel = 1.0f, float dryPan = 0.0f) {
-    if (!prepared_ || bands_.empty())
+  void processNode(PlanState& state, int nodeId, int start, int length,
+                   int numChannels, const juce::AudioBuffer<float>& localMods,
+                   const float* masterModRead, int feedbackDelay,
+                   juce::AudioBuffer<SampleType>& scratch) {
+    if (nodeId == static_cast<int>(NodeId::Input))
       return;
 
-    const int numSamples = buffer.getNumSamples();
-    const int numChannels = std::min(2, buffer.getNumChannels());
-    if (numSamples == 0 || numChannels == 0)
-      return;
+    auto& node = state.nodes[static_cast<size_t>(nodeId)];
 
-    // Clear all node buffers
-    for (auto& [id, buf] : nodeBuffers_) {
-      buf.clear();
+    if (nodeId == static_cast<int>(NodeId::Output)) {
+      gatherInputs(state, nodeId, node, start, start, length, numChannels,
+                   feedbackDelay);
+      return;
     }
 
-    // Store dry signal
-    juce::AudioBuffer<float> dryBuffer;
-    dryBuffer.makeCopyOf(buffer);
+    // Band node (1-12)
+    const int bandIndex = nodeId - 1;
+    auto* band = bandIndex >= 0 && bandIndex < static_cast<int>(bands_.size())
+                     ? bands_[static_cast<size_t>(bandIndex)].get()
+                     : nullptr;
+    if (band == nullptr) {
+      for (int ch = 0; ch < numChannels; ++ch)
+        node.clear(ch, start, length);
+      return;
+    }
 
-    // Copy input to Input node buffer
-    for (int ch = 0; ch < numChannels; ++ch) {
-      nodeBuffers_[0].copyFrom(ch, 0, buffer, ch, 0, numSamples);
+    // Mix the inputs straight into the node; the band processes in place.
+    // The input is kept inside a loop (for the feedback ring's wet part)
+    // and while a routing change fades (for the outgoing plan).
+    gatherInputs(state, nodeId, node, start, start, length, numChannels,
+                 feedbackDelay);
+    const bool isLive = &state == &live();
+    const bool fading = fadeRemaining_ > 0;
+    if (feedbackDelay > 0 || fading)
+      for (int ch = 0; ch < numChannels; ++ch)
+        scratch.copyFrom(ch, 0, node, ch, start, length);
+
+    std::array<SampleType*, kMaxChannels> channels{};
+    for (int ch = 0; ch < numChannels; ++ch)
+      channels[static_cast<size_t>(ch)] = node.getWritePointer(ch, start);
+    juce::AudioBuffer<SampleType> view(channels.data(), numChannels, length);
+
+    const auto role = state.plan.getRole(nodeId);
+    if (!isLive && addLiveWet(nodeId, role, start, length, numChannels,
+                              node)) {
+      // The live plan already ran this band's line
+    } else if (role == RoutingPlan::Role::Fused) {
+      // The live plan keeps the other members' lines recording, so they
+      // carry on with every echo in flight when the chain breaks (unless
+      // the outgoing plan still runs them itself)
+      std::array<DelayBandNode<SampleType>*,
+                 DelayBandNode<SampleType>::kMaxFusedMembers>
+          members{};
+      const int length = state.plan.getChainLength(nodeId);
+      for (int m = 1; isLive && m < length; ++m) {
+        const int member = state.plan.getChainBand(nodeId, m);
+        if (!(fading && outgoing().plan.ownsLine(member)))
+          members[static_cast<size_t>(m - 1)] =
+              bands_[static_cast<size_t>(member - 1)].get();
+      }
+      const int head = state.plan.getChainBand(nodeId, 0) - 1;
+      bands_[static_cast<size_t>(head)]->processFused(
+          view, state.fusedReads[static_cast<size_t>(nodeId)].data(),
+          state.numFusedReads[static_cast<size_t>(nodeId)], members.data(),
+          length - 1);
+    } else {
+      // Under CPU pressure, idle bands with silent input sleep: their
+      // output would equal the (silent) input anyway. A muted band planned
+      // as a wire wakes up when input arrives, so its line records it.
+      auto inputSilent = [&] {
+        SampleType inputPeak = 0;
+        for (int ch = 0; ch < numChannels; ++ch)
+          inputPeak =
+              std::max(inputPeak, node.getMagnitude(ch, start, length));
+        return inputPeak < kSleepThreshold;
+      };
+      bool sleeping = role == RoutingPlan::Role::Wire;
+      if (sleeping && isLive && band->isMuted() &&
+          !bandParked_[static_cast<size_t>(bandIndex)])
+        sleeping = inputSilent();
+      else if (!sleeping && sleepQuietBands_ && band->isIdle())
+        sleeping = inputSilent();
+
+      // Tap children pass their input through; their echo is produced by
+      // the parent's read heads
+      if (!isTapChild(bandIndex) && !sleeping) {
+        // Modulation for this band, offset to the sub-block
+        const auto& taps = tapModSignals_[static_cast<size_t>(bandIndex)];
+        std::array<const float*, DelayBandNode<SampleType>::kMaxTaps>
+            tapMods{};
+        for (size_t t = 0; t < taps.size(); ++t)
+          tapMods[t] = taps[t] ? taps[t] + start : nullptr;
+
+        // A band without LFO gets no signal, so it runs its unmodulated
+        // loop (see DelayBandNode::Stage)
+        const bool local =
+            bandParams_[static_cast<size_t>(bandIndex)].lfoDepth != 0.0f;
+        const bool master = masterLfoDepth_ != 0.0f;
+        const auto* analysis =
+            isLive && feedbackDelay == 0
+                ? analyseInput(nodeId, length, numChannels)
+                : nullptr;
+        band->process(
+            view, SampleType(1),
+            local ? localMods.getReadPointer(bandIndex) + start : nullptr,
+            master ? masterModRead + start : nullptr, tapMods.data(),
+            analysis ? analysis->getPeak() : nullptr);
+      }
     }
 
-    // Process Modulation Engine for this block
-    modulationEngine_.process(numSamples);
-    const auto& localMods = modulationEngine_.getLocalBuffer();
-    const auto& masterMod = modulationEngine_.getMasterBuffer();
-    const float* masterModRead = masterMod.getReadPointer(0);
+    // Wet part (output - input): for the outgoing plan while fading, and
+    // inside a loop for feedback edges leaving this node
+    if (isLive && fading)
+      for (int ch = 0; ch < numChannels; ++ch) {
+        const SampleType* out = node.getReadPointer(ch, start);
+        const SampleType* in = scratch.getReadPointer(ch);
+        SampleType* wet =
+            fadeWet_[static_cast<size_t>(nodeId)].getWritePointer(ch, start);
+        for (int i = 0; i < length; ++i)
+          wet[i] = out[i] - in[i];
+      }
+    if (feedbackDelay > 0)
+      writeFeedbackRing(state, nodeId, start, length, numChannels, scratch);
+  }
 
-    // Process nodes in topological order from external routing
-    const auto& order = externalRouting.getProcessingOrder();
+  /**
+   * @brief Outgoing plan: add the live plan's echo for a band whose line
+   *        the live plan owns (bands are processed by one plan only)
+   *
+   * Exact for a band (or fused chain) whose inputs the change left alone.
+   * A chain that is fused in one plan only gets the live members' echoes
+   * summed, which is close enough for a few milliseconds of fade.
+   * @return false if the outgoing plan should process the band itself
+   */
+  bool addLiveWet(int nodeId, RoutingPlan::Role role, int start, int length,
+                  int numChannels, juce::AudioBuffer<SampleType>& node) {
+    const auto& livePlan = live().plan;
+    const auto& plan = outgoing().plan;
+    auto addWet = [&](int source) {
+      for (int ch = 0; ch < numChannels; ++ch)
+        node.addFrom(ch, start, fadeWet_[static_cast<size_t>(source)], ch,
+                     start, length);
+    };
+    auto ranInLive = [&](int source) {
+      const auto liveRole = livePlan.getRole(source);
+      return liveRole == RoutingPlan::Role::Band ||
+             liveRole == RoutingPlan::Role::Fused;
+    };
+
+    if (role == RoutingPlan::Role::Wire)
+      return false; // Passes its input through either way
+    if (role != RoutingPlan::Role::Fused) {
+      if (!livePlan.ownsLine(nodeId))
+        return false;
+      if (ranInLive(nodeId))
+        addWet(nodeId);
+      return true;
+    }
 
-    for (int nodeId : order) {
-      if (nodeId == static_cast<int>(NodeId::Input)) {
-        continue;
-      }
+    if (!livePlan.ownsLine(plan.getChainBand(nodeId, 0)))
+      return false;
+    bool sameChain = livePlan.getRole(nodeId) == RoutingPlan::Role::Fused &&
+                     livePlan.getChainLength(nodeId) ==
+                         plan.getChainLength(nodeId);
+    for (int m = 0; sameChain && m < plan.getChainLength(nodeId); ++m)
+      sameChain =
+          livePlan.getChainBand(nodeId, m) == plan.getChainBand(nodeId, m);
+    if (sameChain) {
+      addWet(nodeId);
+      return true;
+    }
+    for (int m = 0; m < plan.getChainLength(nodeId); ++m) {
+      const int member = plan.getChainBand(nodeId, m);
+      if (livePlan.getRole(member) == RoutingPlan::Role::Band)
+        addWet(member);
+    }
+    return true;
+  }
 
-      if (nodeId == static_cast<int>(NodeId::Output)) {
-        auto inputs = externalRouting.getInputsFor(nodeId);
-        for (int srcId : inputs) {
-          for (int ch = 0; ch < numChannels; ++ch) {
-            nodeBuffers_[nodeId].addFrom(ch, 0, nodeBuffers_[srcId], ch, 0,
-                                         numSamples);
-          }
-        }
-        continue;
-      }
+  /**
+   * @brief Write a node's mixed plan inputs into dest from destStart
+   *
+   * A shared fan-in sum (see RoutingPlan::getFanInGroup()) is built by the
+   * first member to need it in each tile and copied by the rest.
+   */
+  void gatherInputs(PlanState& state, int nodeId,
+                    juce::AudioBuffer<SampleType>& dest, int destStart,
+                    int start, int length, int numChannels,
+                    int feedbackDelay) {
+    const int group = state.plan.getFanInGroup(nodeId);
+    if (group < 0) {
+      mixInputs(state, nodeId, dest, destStart, start, length, numChannels,
+                feedbackDelay);
+      return;
+    }
+    prepareFanIn(state, nodeId, length, numChannels);
+    for (int ch = 0; ch < numChannels; ++ch)
+      dest.copyFrom(ch, destStart, state.fanInSums[static_cast<size_t>(group)],
+                    ch, 0, length);
+  }
 
-      // Band node (1-8)
-      int bandIndex = nodeId - 1;
-      if (bandIndex < 0 || bandIndex >= static_cast<int>(bands_.size()))
-        continue;
+  /**
+   * @brief Which shared signal a live band's input is: its source node
+   *        (one unity-gain edge) or its fan-in group's sum (kNumNodes +
+   *        group); -1 if neither, or the band has no attack envelope
+   */
+  int analysisKey(const RoutingPlan& plan, int nodeId) const {
+    const int bandIndex = nodeId - 1;
+    if (!shareAnalysis_ || bandIndex < 0 || bandIndex >= MAX_BANDS ||
+        plan.getRole(nodeId) != RoutingPlan::Role::Band ||
+        isTapChild(bandIndex) ||
+        bandParams_[static_cast<size_t>(bandIndex)].attackTimeMs <= 0.0f)
+      return -1;
+    const int group = plan.getFanInGroup(nodeId);
+    if (group >= 0)
+      return kNumNodes + group;
+    if (plan.getNumInputs(nodeId) != 1)
+      return -1;
+    const auto& edge = plan.getInput(nodeId, 0);
+    return edge.gain == 1.0f && !edge.feedback ? edge.source : -1;
+  }
 
-      auto& band = bands_[static_cast<size_t>(bandIndex)];
-      if (!band)
-        continue;
+  /**
+   * @brief Analyse an acyclic live band's input signal, once per tile
+   *        however many bands read it (see InputAnalysis)
+   *
+   * The signal must be complete for the tile: its source node has run, or
+   * its fan-in sum has been mixed.
+   * @return The analysis, or null if the band measures its own input
+   */
+  const InputAnalysis<SampleType>* analyseInput(int nodeId, int length,
+                                                int numChannels) {
+    auto& state = live();
+    const int key = analysisKey(state.plan, nodeId);
+    if (key < 0)
+      return nullptr;
+    auto& analysis = analyses_[static_cast<size_t>(key)];
+    if (!analysed_[static_cast<size_t>(key)]) {
+      const auto& signal =
+          key >= kNumNodes
+              ? state.fanInSums[static_cast<size_t>(key - kNumNodes)]
+              : state.nodes[static_cast<size_t>(key)];
+      analysis.process(signal, numChannels, length);
+      analysed_[static_cast<size_t>(key)] = true;
+      ++numAnalysed_;
+    }
+    return &analysis;
+  }
 
-      // Sum all inputs for this band
-      auto inputs = externalRouting.getInputsFor(nodeId);
-      juce::AudioBuffer<float> bandInput(numChannels, numSamples);
-      bandInput.clear();
+  void prepareFanIn(PlanState& state, int nodeId, int length,
+                    int numChannels) {
+    const int group = state.plan.getFanInGroup(nodeId);
+    if (group < 0 || state.fanInReady[static_cast<size_t>(group)])
+      return;
+    mixInputs(state, nodeId, state.fanInSums[static_cast<size_t>(group)], 0,
+              0, length, numChannels, 0);
+    state.fanInReady[static_cast<size_t>(group)] = true;
+  }
 
-      for (int srcId : inputs) {
-        for (int ch = 0; ch < numChannels; ++ch) {
-          bandInput.addFrom(ch, 0, nodeBuffers_[srcId], ch, 0, numSamples);
+  /**
+   * @brief Mix every input edge of a node into dest in one pass per channel
+   *
+   * Each edge contributes gain * source (FanInMix). Feedback edges inside a
+   * loop read the source's wet ring feedbackDelay samples back; the range
+   * is split where any of those reads wraps, so every segment reads
+   * contiguous memory.
+   */
+  void mixInputs(PlanState& state, int nodeId,
+                 juce::AudioBuffer<SampleType>& dest, int destStart,
+                 int start, int length, int numChannels, int feedbackDelay) {
+    const auto& plan = state.plan;
+    const int numInputs = plan.getNumInputs(nodeId);
+    std::array<SampleType, kNumNodes> gains{};
+    std::array<int, kNumNodes> ringStart{}; // -1 = read the node buffer
+    for (int k = 0; k < numInputs; ++k) {
+      const auto& edge = plan.getInput(nodeId, k);
+      gains[static_cast<size_t>(k)] = static_cast<SampleType>(edge.gain);
+      ringStart[static_cast<size_t>(k)] =
+          feedbackDelay > 0 && edge.feedback
+              ? (state.ringPos[static_cast<size_t>(edge.source)] -
+                 feedbackDelay + kFeedbackRingSize) %
+                    kFeedbackRingSize
+              : -1;
+    }
+
+    std::array<const SampleType*, kNumNodes> sources{};
+    for (int pos = 0; pos < length;) {
+      int end = length;
+      for (int k = 0; k < numInputs; ++k) {
+        const int ring = ringStart[static_cast<size_t>(k)];
+        if (ring >= 0)
+          end = std::min(end, pos + kFeedbackRingSize -
+                                  (ring + pos) % kFeedbackRingSize);
+      }
+      for (int ch = 0; ch < numChannels; ++ch) {
+        for (int k = 0; k < numInputs; ++k) {
+          const auto source =
+              static_cast<size_t>(plan.getInput(nodeId, k).source);
+          const int ring = ringStart[static_cast<size_t>(k)];
+          sources[static_cast<size_t>(k)] =
+              ring >= 0 ? state.rings[source].getReadPointer(
+                              ch, (ring + pos) % kFeedbackRingSize)
+                        : state.nodes[source].getReadPointer(ch, start + pos);
         }
+        FanInMix<SampleType>::run(dest.getWritePointer(ch, destStart + pos),
+                                  sources.data(), gains.data(), numInputs,
+                                  end - pos);
       }
+      pos = end;
+    }
+  }
 
-      // Get modulation signal for this band
-      const float* localModRead = localMods.getReadPointer(bandIndex);
+  /**
+   * @brief Acyclic nodes bucketed by routing depth (offline parallel path)
+   *
+   * A node's depth is one more than the deepest of its inputs, so nodes of
+   * equal depth never feed each other. Fixed-size, allocation-free.
+   */
+  struct NodeLevels {
+    std::array<std::array<int, kNumNodes>, kNumNodes> nodes{};
+    std::array<int, kNumNodes> counts{};
+    std::array<int, kNumNodes> depth{};
+    int numLevels = 0;
+
+    void clear() {
+      counts.fill(0);
+      depth.fill(0);
+      numLevels = 0;
+    }
 
-      // Process through delay band with modulation signals
-      band->process(bandInput, 1.0f, localModRead, masterModRead);
+    void add(int nodeId, const RoutingPlan& plan) {
+      int d = 0;
+      for (int i = 0; i < plan.getNumInputs(nodeId); ++i)
+        d = std::max(
+            d, depth[static_cast<size_t>(plan.getInput(nodeId, i).source)] +
+                   1);
+      d = std::min(d, kNumNodes - 1);
+      depth[static_cast<size_t>(nodeId)] = d;
+      auto& count = counts[static_cast<size_t>(d)];
+      nodes[static_cast<size_t>(d)][static_cast<size_t>(count++)] = nodeId;
+      numLevels = std::max(numLevels, d + 1);
+    }
+  };
 
-      // Calculate peak level for activity indicator
-      float peak = 0.0f;
-      for (int ch = 0; ch < numChannels; ++ch) {
-        auto range = juce::FloatVectorOperations::findMinAndMax(
-            bandInput.getReadPointer(ch), numSamples);
-        peak = std::max(peak, std::max(std::abs(range.getStart()),
-                                       std::abs(range.getEnd())));
+  /**
+   * @brief Run the live plan's collected levels in order, each level's
+   *        nodes in parallel (every band has its own scratch buffer)
+   */
+  void runLevels(int numSamples, int numChannels,
+                 const juce::AudioBuffer<float>& localMods,
+                 const float* masterModRead) {
+    for (int level = 0; level < levels_.numLevels; ++level) {
+      const auto& nodes = levels_.nodes[static_cast<size_t>(level)];
+      const int count = levels_.counts[static_cast<size_t>(level)];
+      // Shared sums and analyses first, so the tasks only read them
+      for (int i = 0; i < count; ++i) {
+        prepareFanIn(live(), nodes[static_cast<size_t>(i)], numSamples,
+                     numChannels);
+        analyseInput(nodes[static_cast<size_t>(i)], numSamples, numChannels);
       }
-      bandLevels_[static_cast<size_t>(bandIndex)] = peak;
+      auto task = [&](int i) {
+        const int nodeId = nodes[static_cast<size_t>(i)];
+        processNode(live(), nodeId, 0, numSamples, numChannels, localMods,
+                    masterModRead, 0,
+                    parallelScratch_[static_cast<size_t>(nodeId)]);
+      };
+      workerPool_.run(count, task);
+    }
+    levels_.clear();
+  }
 
-      // Store in node buffer
-      for (int ch = 0; ch < numChannels; ++ch) {
-        nodeBuffers_[nodeId].copyFrom(ch, 0, bandInput, ch, 0, numSamples);
+  /**
+   * @brief Compile this block's plan and the reads of its fused chains
+   *
+   * Bands the plan stops running while they would otherwise run (dead, or
+   * muted with constant-zero input) are parked: they clear their
+   * line a slice per block (kBypassClearSamples shared by all bands), like
+   * a hard bypass. A parked band whose line is not clean yet is planned as
+   * a wire (audio passes through); once clean it resets its state and
+   * rejoins. An outgoing plan still fading out keeps its lines.
+   *
+   * hold keeps the live plan's schedule as it is (a routing change waiting
+   * for the fade); only the fused reads follow the bands' params.
+   */
+  void compilePlan(const RoutingGraph& routing, bool hold = false) {
+    const bool masterStill = masterLfoDepth_ == 0.0f;
+    for (int i = 0; i < MAX_BANDS; ++i) {
+      const auto& band = *bands_[static_cast<size_t>(i)];
+      auto& info = planInfo_[static_cast<size_t>(i + 1)];
+      // A muted band only drops its wet part: it is a wire once its line
+      // has nothing left to play (input reaching it is still written, see
+      // processNode())
+      info.wire = (band.isWire() && (!band.isMuted() || band.isIdle())) ||
+                  isTapChild(i) ||
+                  (bandParked_[static_cast<size_t>(i)] &&
+                   band.hasWrittenFrames());
+      info.pureDelay = masterStill && !isTapChild(i) && band.isPureDelay();
+      info.delaySamples =
+          info.pureDelay ? static_cast<double>(band.getReadDelaySamples())
+                         : 0.0;
+      info.interpolation = bandParams_[static_cast<size_t>(i)].interpolation;
+    }
+    auto& state = live();
+    auto& plan = state.plan;
+    if (!hold)
+      plan.compile(routing, planInfo_, planPasses_,
+                   bands_[0]->getMaxReadDelaySamples());
+
+    // A chain's transfer is the product of (1 + g z^-d) over its bands:
+    // one read per non-empty subset, at the summed delay and gain
+    for (int nodeId = 0; nodeId < kNumNodes; ++nodeId) {
+      const int length = plan.getChainLength(nodeId);
+      auto& reads = state.fusedReads[static_cast<size_t>(nodeId)];
+      state.numFusedReads[static_cast<size_t>(nodeId)] = 0;
+      if (plan.getRole(nodeId) != RoutingPlan::Role::Fused)
+        continue;
+      for (int subset = 1; subset < (1 << length); ++subset) {
+        auto& read = reads[static_cast<size_t>(subset - 1)];
+        read.delaySamples = SampleType(0);
+        read.gains.fill(SampleType(1));
+        for (int m = 0; m < length; ++m) {
+          if ((subset & (1 << m)) == 0)
+            continue;
+          const auto& band = *bands_[static_cast<size_t>(
+              plan.getChainBand(nodeId, m) - 1)];
+          read.delaySamples += band.getReadDelaySamples();
+          for (int ch = 0; ch < numChannels_; ++ch)
+            read.gains[static_cast<size_t>(ch)] *= band.getWetGain(ch);
+        }
       }
+      state.numFusedReads[static_cast<size_t>(nodeId)] = (1 << length) - 1;
     }
 
-    // Get output node result
-    auto& wetBuffer = nodeBuffers_[static_cast<int>(NodeId::Output)];
+    std::array<bool, MAX_BANDS> drawn{};
+    for (int nodeId : routing.getProcessingOrder()) {
+      if (nodeId >= 1 && nodeId <= MAX_BANDS)
+        drawn[static_cast<size_t>(nodeId - 1)] = true;
+    }
+    for (int i = 0; i < MAX_BANDS; ++i) {
+      const auto idx = static_cast<size_t>(i);
+      auto& band = *bands_[idx];
+      if (lineInUse(i + 1)) {
+        // A parked band only runs again once clean (else it was planned
+        // as a wire); an outgoing plan may still be running it as it was
+        if (bandParked_[idx] && !band.hasWrittenFrames()) {
+          band.reset();
+          state.rings[idx + 1].clear();
+        }
+        bandParked_[idx] = false;
+        continue;
+      }
+      const bool mutedWire =
+          band.isMuted() && plan.getRole(i + 1) == RoutingPlan::Role::Wire;
+      if (drawn[idx] && bandParams_[idx].enabled && !isTapChild(i) &&
+          !mutedWire)
+        bandParked_[idx] = true;
+    }
+    clearParkedLines(kBypassClearSamples);
+  }
 
-    // Apply safety limiter
-    if (numChannels >= 2) {
-      limiter_.process(wetBuffer.getWritePointer(0),
-                       wetBuffer.getWritePointer(1), numSamples);
+  /**
+   * @brief Zero up to budget samples of the parked bands' written spans
+   *        (never waits for a line another thread holds)
+   */
+  void clearParkedLines(size_t budget) {
+    for (size_t i = 0; i < bands_.size() && budget > 0; ++i)
+      if (bandParked_[i])
+        budget = bands_[i]->clearWrittenStep(budget);
+  }
+
+  /**
+   * @brief True if the band at nodeId writes its line this block (in the
+   *        live plan, or in the outgoing one while a change fades)
+   *
+   * Every member of a live fused chain records its line (see
+   * processFused()), not just the one that owns the chain's line.
+   */
+  bool lineInUse(int nodeId) const {
+    return live().plan.ownsLine(nodeId) ||
+           live().plan.getFusedInto(nodeId) >= 0 ||
+           (fadeRemaining_ > 0 &&
+            planStates_[static_cast<size_t>(1 - livePlan_)].plan.ownsLine(
+                nodeId));
+  }
+
+  /**
+   * @brief True if the connections differ from the last noted ones
+   */
+  bool routingDiffers(const RoutingGraph& routing) const {
+    const auto& connections = routing.getConnections();
+    const int count = std::min(static_cast<int>(connections.size()),
+                               RoutingPlan::kMaxEdges);
+    if (count != numLastConnections_)
+      return true;
+    for (int i = 0; i < count; ++i) {
+      const auto& conn = connections[static_cast<size_t>(i)];
+      const auto& last = lastConnections_[static_cast<size_t>(i)];
+      if (!(conn == last) || conn.gain != last.gain)
+        return true;
     }
+    return false;
+  }
 
-    // Final mix
-    float dryPanL = std::cos((dryPan + 1.0f) * 0.25f * 3.14159f) * dryLevel;
-    float dryPanR = std::sin((dryPan + 1.0f) * 0.25f * 3.14159f) * dryLevel;
+  /**
+   * @brief Remember this block's connections; true if they differ from
+   *        the last block's (never on the first block)
+   */
+  bool noteRouting(const RoutingGraph& routing) {
+    if (!routingDiffers(routing))
+      return false;
+    const auto& connections = routing.getConnections();
+    const int count = std::min(static_cast<int>(connections.size()),
+                               RoutingPlan::kMaxEdges);
+    for (int i = 0; i < count; ++i)
+      lastConnections_[static_cast<size_t>(i)] =
+          connections[static_cast<size_t>(i)];
+    const bool first = numLastConnections_ < 0;
+    numLastConnections_ = count;
+    return !first;
+  }
 
-    for (int ch = 0; ch < numChannels; ++ch) {
-      const float* dry = dryBuffer.getReadPointer(ch);
-      const float* wet = wetBuffer.getReadPointer(ch);
-      float* out = buffer.getWritePointer(ch);
-      float dryGain = (ch == 0) ? dryPanL : dryPanR;
+  /**
+   * @brief Keep the current plan running as the outgoing one and fade to
+   *        the plan compiled from the new routing
+   *
+   * The new live state takes over the feedback rings so loops carry on. A
+   * change during a fade is held until it ends (see processGraph()), so at
+   * most two plans ever run and neither is cut off mid-fade.
+   */
+  void startRoutingFade() {
+    fadeLength_ = static_cast<int>(routingFadeMs_ * 0.001 * sampleRate_);
+    fadeRemaining_ = 0;
+    if (fadeLength_ <= 0)
+      return;
+
+    const auto& from = live();
+    livePlan_ = 1 - livePlan_;
+    auto& to = live();
+    for (size_t n = 0; n < to.rings.size(); ++n)
+      for (int ch = 0; ch < to.rings[n].getNumChannels(); ++ch)
+        to.rings[n].copyFrom(ch, 0, from.rings[n], ch, 0, kFeedbackRingSize);
+    to.ringPos = from.ringPos;
+    fadeRemaining_ = fadeLength_;
+  }
 
-      for (int s = 0; s < numSamples; ++s) {
-        out[s] = dry[s] * dryGain + wet[s] * wetMix;
+  /**
+   * @brief Fade the live Output node in over the outgoing plan's
+   *
+   * Linear: the two plans share most of their bands, so their outputs are
+   * strongly correlated.
+   */
+  void crossfadeOutgoing(juce::AudioBuffer<SampleType>& wet, int tileLength,
+                         int numChannels) {
+    const auto& old = outgoing().nodes[static_cast<size_t>(NodeId::Output)];
+    const int done = fadeLength_ - fadeRemaining_;
+    const auto step = SampleType(1) / static_cast<SampleType>(fadeLength_);
+    for (int ch = 0; ch < numChannels; ++ch) {
+      const SampleType* from = old.getReadPointer(ch);
+      SampleType* to = wet.getWritePointer(ch);
+      for (int i = 0; i < tileLength; ++i) {
+        const int pos = done + i + 1;
+        const SampleType amount =
+            pos >= fadeLength_ ? SampleType(1)
+                               : static_cast<SampleType>(pos) * step;
+        to[i] = from[i] + amount * (to[i] - from[i]);
       }
     }
+    fadeRemaining_ = std::max(0, fadeRemaining_ - tileLength);
   }
 
-  // Serialization for state save/restore
-  juce::String getRoutingState() const {
-    // TODO: Serialize routing graph connections
-    return "{}";
+  /**
+   * @brief Recompute the published tail (see TailLength.h)
+   *
+   * Tap children ring with their parent's line, so they take its feedback.
+   */
+  void updateTailLength(const RoutingGraph& routing) {
+    auto params = bandParams_;
+    for (int i = 0; i < MAX_BANDS; ++i) {
+      if (isTapChild(i))
+        params[static_cast<size_t>(i)].feedback =
+            bandParams_[static_cast<size_t>(getBandTapParent(i))].feedback;
+    }
+    tailSeconds_.store(TailLength::matrixSeconds(params, routing),
+                       std::memory_order_relaxed);
   }
 
-  void setRoutingState(const juce::String& /*state*/) {
-    // TODO: Deserialize routing graph connections
+  /**
+   * @brief Publish which bands need a line, for updateMemoryResidency(),
+   *        and whether the whole matrix is silent
+   */
+  void trackLineUse(bool inputSilent, int numSamples) {
+    bool silent = inputSilent;
+    for (int i = 0; i < MAX_BANDS; ++i) {
+      const auto idx = static_cast<size_t>(i);
+      const bool dormant = !lineInUse(i + 1) ||
+                           !bandParams_[idx].enabled || isTapChild(i);
+      bandDormant_[idx].store(dormant, std::memory_order_relaxed);
+      if (!dormant && !bands_[idx]->isIdle())
+        silent = false;
+    }
+
+    silentSamples_.store(silent ? silentSamples_.load() + numSamples : 0);
   }
 
-  // Get output level for a band (for activity indicators)
-  float getBandLevel(int bandIndex) const {
-    if (bandIndex >= 0 && bandIndex < 8)
-      return bandLevels_[static_cast<size_t>(bandIndex)];
-    return 0.0f;
+  /**
+   * @brief Largest safe sub-block for a feedback loop
+   *
+   * Feedback edges arrive one sub-block late, so the sub-block is capped by
+   * kFeedbackSubBlock and by the shortest delay in the loop (allowing for
+   * full modulation depth): the extra latency never exceeds the loop's own
+   * delay and does not depend on the host block size.
+   */
+  int getCycleChunkSize(const RoutingPlan& plan,
+                        const RoutingPlan::Step& step) const {
+    float minDelayMs = kFeedbackSubBlock * 1000.0f /
+                       static_cast<float>(std::max(1.0, sampleRate_));
+    for (int i = step.first; i < step.first + step.count; ++i) {
+      const int bandIndex = plan.getNode(i) - 1;
+      if (bandIndex < 0 || bandIndex >= MAX_BANDS)
+        continue;
+      const auto& p = bandParams_[static_cast<size_t>(bandIndex)];
+      minDelayMs = std::min(minDelayMs,
+                            std::max(1.0f, p.delayTimeMs - kMaxModulationMs));
+    }
+    const int chunk = static_cast<int>(minDelayMs * 0.001 * sampleRate_);
+    return std::clamp(chunk, 1, kFeedbackSubBlock);
   }
 
-  // Safety limiter access for UI
-  bool isSafetyMuted() const { return limiter_.isPermanentlyMuted(); }
-  SafetyLimiter::MuteReason getSafetyMuteReason() const {
-    return limiter_.getMuteReason();
+  void writeFeedbackRing(PlanState& state, int nodeId, int start, int length,
+                         int numChannels,
+                         const juce::AudioBuffer<SampleType>& scratch) {
+    auto& ring = state.rings[static_cast<size_t>(nodeId)];
+    const int pos = state.ringPos[static_cast<size_t>(nodeId)];
+    for (int ch = 0; ch < numChannels; ++ch) {
+      const SampleType* out =
+          state.nodes[static_cast<size_t>(nodeId)].getReadPointer(ch, start);
+      const SampleType* in = scratch.getReadPointer(ch);
+      SampleType* dest = ring.getWritePointer(ch);
+      for (int i = 0; i < length; ++i)
+        dest[(pos + i) % kFeedbackRingSize] = out[i] - in[i];
+    }
+  }
+
+  void advanceFeedbackRing(PlanState& state, int nodeId, int length) {
+    auto& pos = state.ringPos[static_cast<size_t>(nodeId)];
+    pos = (pos + length) % kFeedbackRingSize;
   }
-  void unlockSafetyMute() { limiter_.unlockPermanentMute(); }
 
   /**
-   * @brief Set master LFO parameters
+   * @brief Collect enabled tap children into each parent's read heads
    */
-  void setMasterLfo(float rate, float depth, int waveform) {
-    // Forward to engine
-    modulationEngine_.setMasterParams(static_cast<ModulationType>(waveform),
-                                      rate, depth);
+  void updateTapGroups(const juce::AudioBuffer<float>& localMods) {
+    std::array<DelayTapParams, DelayBandNode<SampleType>::kMaxTaps> taps{};
+
+    for (int parent = 0; parent < static_cast<int>(bands_.size()); ++parent) {
+      auto& band = bands_[static_cast<size_t>(parent)];
+      if (!band)
+        continue;
+
+      auto& mods = tapModSignals_[static_cast<size_t>(parent)];
+      int numTaps = 0;
+      for (int child = 0; child < MAX_BANDS; ++child) {
+        if (numTaps >= DelayBandNode<SampleType>::kMaxTaps)
+          break;
+        if (tapParent_[static_cast<size_t>(child)] != parent ||
+            !isTapChild(child))
+          continue;
+
+        const auto& p = bandParams_[static_cast<size_t>(child)];
+        if (!p.enabled)
+          continue;
+
+        auto& tap = taps[static_cast<size_t>(numTaps)];
+        tap.delayTimeMs = p.delayTimeMs;
+        tap.level = p.level;
+        tap.pan = p.pan;
+        tap.phaseInvert = p.phaseInvert;
+        mods[static_cast<size_t>(numTaps)] = localMods.getReadPointer(child);
+        ++numTaps;
+      }
+
+      band->setTaps(taps.data(), numTaps);
+    }
   }
 
-private:
-  std::vector<std::unique_ptr<DelayBandNode>> bands_;
+  std::vector<std::unique_ptr<DelayBandNode<SampleType>>> bands_;
   RoutingGraph routingGraph_;
-  SafetyLimiter limiter_;
+  SafetyLimiter<SampleType> limiter_;
   ModulationEngine modulationEngine_; // The new engine
 
   // Node buffers (Input + 12 Bands + Output)
   static constexpr int kNumNodes = 14;
-  std::unordered_map<int, juce::AudioBuffer<float>> nodeBuffers_;
+  // Tiles: every node buffer holds one tile (see processTile())
+  static constexpr int kTileSize = 64;
+  int tileSize_ = kTileSize;
+  juce::AudioBuffer<SampleType> bandScratch_;
+
+  // Feedback loops: sub-block cap, modulation headroom and the size of the
+  // per-node wet-signal rings that carry feedback edges one sub-block late
+  static constexpr int kFeedbackSubBlock = 64;
+  static constexpr int kFeedbackRingSize = 2 * kFeedbackSubBlock;
+  static constexpr float kMaxModulationMs = 50.0f; // local + master, ±25ms
+
+  // Optimized schedule, rebuilt every block into the live state (see
+  // compilePlan()); the other state holds the outgoing plan while a
+  // routing change crossfades (see startRoutingFade())
+  std::array<PlanState, 2> planStates_;
+  int livePlan_ = 0;
+  uint32_t planPasses_ = RoutingPlan::kAllPasses;
+  std::array<PlanBandInfo, kNumNodes> planInfo_{};
+  std::array<bool, MAX_BANDS> bandParked_{};
+  float masterLfoDepth_ = 0.0f;
+
+  PlanState& live() { return planStates_[static_cast<size_t>(livePlan_)]; }
+  const PlanState& live() const {
+    return planStates_[static_cast<size_t>(livePlan_)];
+  }
+  PlanState& outgoing() {
+    return planStates_[static_cast<size_t>(1 - livePlan_)];
+  }
+
+  // Routing crossfade: the connections last seen (to spot a change), the
+  // fade length and what is left of it, and each live node's wet part
+  // (output - input) for the outgoing plan to reuse
+  std::array<Connection, RoutingPlan::kMaxEdges> lastConnections_{};
+  int numLastConnections_ = -1; // -1 = no block seen yet
+  float routingFadeMs_ = kDefaultRoutingFadeMs;
+  int fadeLength_ = 0;
+  int fadeRemaining_ = 0;
+  std::array<juce::AudioBuffer<SampleType>, kNumNodes> fadeWet_;
+
+  // Shared input analysis (see analyseInput()): one per source node, then
+  // one per fan-in group, and which of them the current tile has run
+  static constexpr int kNumAnalyses = kNumNodes + kNumNodes / 2;
+  bool shareAnalysis_ = true;
+  std::array<InputAnalysis<SampleType>, kNumAnalyses> analyses_;
+  std::array<bool, kNumAnalyses> analysed_{};
+  int numAnalysed_ = 0;
+
+  // Offline quality: oversampled bands and parallel levels (see
+  // setOfflineQuality())
+  static constexpr int kMaxWorkers = 7;
+  bool offlineQuality_ = false;
+  WorkerPool workerPool_;
+  NodeLevels levels_;
+  std::array<juce::AudioBuffer<SampleType>, kNumNodes> parallelScratch_;
+
+  // Quality reductions requested by the CPU governor
+  static constexpr SampleType kSleepThreshold = SampleType(3.0e-5); // -90dB
+  bool sleepQuietBands_ = false;
 
   double sampleRate_ = 44100.0;
   size_t maxBlockSize_ = 512;
+  int numChannels_ = 2;
+  std::array<ChannelSide, kMaxChannels> channelSides_{};
+
+  // Multi-tap groups: parent band per band (-1 = own line), the last
+  // params seen per band, and per-parent tap modulation pointers
+  std::array<int, MAX_BANDS> tapParent_{
+      {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}};
+  std::array<DelayBandParams, MAX_BANDS> bandParams_{};
+  std::array<std::array<const float*, DelayBandNode<SampleType>::kMaxTaps>,
+             MAX_BANDS>
+      tapModSignals_{};
   bool prepared_ = false;
 
+  // Delay-line memory (see updateMemoryResidency())
+  static constexpr double kArenaSleepSeconds = 10.0;
+  DelayMemoryOptions memoryOptions_;
+  std::atomic<bool> arenaActive_{false};
+  std::array<std::atomic<bool>, MAX_BANDS> bandDormant_{};
+  std::atomic<int64_t> silentSamples_{0};
+  static constexpr double kUnknownTailSeconds = 6.0; // Before the 1st block
+  static constexpr size_t kBypassClearSamples = 1 << 17; // ~0.5 MB float
+  std::atomic<double> tailSeconds_{kUnknownTailSeconds};
+
   std::array<float, 12> bandLevels_{
       {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}};
 };
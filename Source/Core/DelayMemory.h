@@ -0,0 +1,442 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace uds {
+
+class DelayArena;
+
+/**
+ * @brief How DelayMemory backs a delay line
+ */
+struct DelayMemoryOptions {
+  bool prefault = true;  // Touch every page in allocate() (calling thread)
+  bool lock = false;     // mlock/VirtualLock so pages are never swapped out
+  bool hugePages = true; // Ask for transparent huge pages (Linux)
+
+  // Lease blocks from this shared arena instead of owning them (opt-in)
+  std::shared_ptr<DelayArena> arena;
+};
+
+/**
+ * @brief What a DelayMemory block actually got from the OS
+ *
+ * Locking and huge pages are requests; this reports the outcome so the
+ * plugin can surface it (e.g. RLIMIT_MEMLOCK too low to lock).
+ */
+struct DelayMemoryStatus {
+  size_t bytes = 0;
+  bool prefaulted = false;
+  bool locked = false;
+  bool lockFailed = false; // Locking was requested but refused
+  bool hugePages = false;  // Huge pages advised (the kernel may still decline)
+
+  /**
+   * @brief Accumulate another block's status (for matrix-wide reporting)
+   */
+  DelayMemoryStatus& operator+=(const DelayMemoryStatus& other) {
+    const bool wasEmpty = bytes == 0;
+    bytes += other.bytes;
+    prefaulted = (wasEmpty || prefaulted) && other.prefaulted;
+    locked = (wasEmpty || locked) && other.locked;
+    lockFailed = lockFailed || other.lockFailed;
+    hugePages = hugePages || other.hugePages;
+    return *this;
+  }
+};
+
+/**
+ * @brief One page-backed, zero-initialised block of raw delay memory
+ *
+ * Memory comes straight from the OS (mmap/VirtualAlloc) so it starts zeroed,
+ * and allocate() writes to every page before returning. prepare() therefore
+ * takes all the page faults on the message thread instead of the audio
+ * thread taking them the first time a long delay fills. Optionally the pages
+ * are locked and, on Linux, backed by transparent huge pages. Falls back to
+ * a plain zeroed heap block where the OS calls are unavailable.
+ */
+class DelayPages {
+public:
+  DelayPages() = default;
+  ~DelayPages() { release(); }
+
+  DelayPages(const DelayPages&) = delete;
+  DelayPages& operator=(const DelayPages&) = delete;
+
+  /**
+   * @return false if even the heap fallback failed (block stays empty)
+   */
+  bool allocate(size_t bytes, const DelayMemoryOptions& options) {
+    release();
+    if (bytes == 0)
+      return false;
+
+    if (!mapPages(bytes, options)) {
+      heap_ = new (std::nothrow) unsigned char[bytes]();
+      if (heap_ == nullptr)
+        return false;
+      data_ = heap_;
+      status_.prefaulted = true; // Value-initialisation wrote every page
+    }
+
+    bytes_ = bytes;
+    status_.bytes = bytes;
+    hugePagesRequested_ = options.hugePages;
+    return true;
+  }
+
+  void release() {
+    if (heap_ != nullptr) {
+      delete[] heap_;
+      heap_ = nullptr;
+    } else if (mapping_ != nullptr) {
+      unmapPages();
+    }
+    data_ = nullptr;
+    bytes_ = 0;
+    status_ = {};
+    hugePagesRequested_ = false;
+  }
+
+  void* data() const { return data_; }
+  size_t bytes() const { return bytes_; }
+  const DelayMemoryStatus& getStatus() const { return status_; }
+
+  /**
+   * @brief True if the block was set up the way options asks (locking
+   *        tried, huge pages, pre-faulted), so it can be handed out again
+   */
+  bool matches(const DelayMemoryOptions& options) const {
+    return options.lock == (status_.locked || status_.lockFailed) &&
+           options.hugePages == hugePagesRequested_ &&
+           (!options.prefault || status_.prefaulted);
+  }
+
+private:
+  static constexpr size_t kHugePageSize = size_t(2) << 20;
+
+  static size_t pageSize() {
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return static_cast<size_t>(info.dwPageSize);
+#else
+    const long size = sysconf(_SC_PAGESIZE);
+    return size > 0 ? static_cast<size_t>(size) : size_t(4096);
+#endif
+  }
+
+  bool mapPages(size_t bytes, const DelayMemoryOptions& options) {
+#if defined(_WIN32)
+    void* base =
+        VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (base == nullptr)
+      return false;
+    mapping_ = base;
+    mappingBytes_ = bytes;
+    data_ = static_cast<unsigned char*>(base);
+#else
+    // Over-map by one huge page so the block can start on a 2MB boundary
+    const bool wantHuge = options.hugePages && bytes >= kHugePageSize;
+    const size_t mapBytes = wantHuge ? bytes + kHugePageSize : bytes;
+    void* base = mmap(nullptr, mapBytes, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+      return false;
+    mapping_ = base;
+    mappingBytes_ = mapBytes;
+
+    auto address = reinterpret_cast<std::uintptr_t>(base);
+    if (wantHuge)
+      address = (address + kHugePageSize - 1) & ~(kHugePageSize - 1);
+    data_ = reinterpret_cast<unsigned char*>(address);
+
+#if defined(MADV_HUGEPAGE)
+    if (wantHuge)
+      status_.hugePages =
+          madvise(reinterpret_cast<void*>(address),
+                  bytes & ~(kHugePageSize - 1), MADV_HUGEPAGE) == 0;
+#endif
+#endif
+
+    if (options.prefault) {
+      // Fresh pages read as zero; writing a zero commits each one
+      auto* bytePtr = reinterpret_cast<volatile unsigned char*>(data_);
+      const size_t step = pageSize();
+      for (size_t offset = 0; offset < bytes; offset += step)
+        bytePtr[offset] = 0;
+      status_.prefaulted = true;
+    }
+
+    if (options.lock) {
+#if defined(_WIN32)
+      status_.locked = VirtualLock(data_, bytes) != 0;
+#else
+      status_.locked = mlock(data_, bytes) == 0;
+#endif
+      status_.lockFailed = !status_.locked;
+      lockedBytes_ = status_.locked ? bytes : 0;
+    }
+    return true;
+  }
+
+  void unmapPages() {
+#if defined(_WIN32)
+    if (lockedBytes_ > 0)
+      VirtualUnlock(data_, lockedBytes_);
+    VirtualFree(mapping_, 0, MEM_RELEASE);
+#else
+    if (lockedBytes_ > 0)
+      munlock(data_, lockedBytes_);
+    munmap(mapping_, mappingBytes_);
+#endif
+    mapping_ = nullptr;
+    mappingBytes_ = 0;
+    lockedBytes_ = 0;
+  }
+
+  unsigned char* data_ = nullptr;
+  size_t bytes_ = 0;
+
+  // Exactly one of these owns the block
+  unsigned char* heap_ = nullptr;
+  void* mapping_ = nullptr;
+  size_t mappingBytes_ = 0;
+  size_t lockedBytes_ = 0;
+
+  DelayMemoryStatus status_;
+  bool hugePagesRequested_ = false;
+};
+
+/**
+ * @brief Process-wide pool of delay-line blocks shared by plugin instances
+ *
+ * Opt-in. Instances hold the arena through acquire() (reference counted; the
+ * pool and its blocks go away with the last instance) and check blocks out
+ * per resident delay line. A block handed back is zeroed and kept as a spare
+ * for the next checkout, up to the spare limit; beyond that it is returned to
+ * the OS so resident memory follows what the instances actually use.
+ *
+ * Every call takes a mutex and may allocate: message thread only.
+ */
+class DelayArena : public std::enable_shared_from_this<DelayArena> {
+public:
+  struct Stats {
+    size_t inUseBytes = 0;  // Checked out by delay lines
+    size_t spareBytes = 0;  // Zeroed, waiting for the next checkout
+    int numLeases = 0;      // Blocks currently checked out
+    int numUsers = 0;       // Instances holding the arena
+  };
+
+  static constexpr size_t kDefaultSpareLimit = size_t(32) << 20;
+
+  /**
+   * @brief The shared arena, created on first use
+   */
+  static std::shared_ptr<DelayArena> acquire() {
+    static std::mutex mutex;
+    static std::weak_ptr<DelayArena> instance;
+    const std::lock_guard<std::mutex> lock(mutex);
+    auto arena = instance.lock();
+    if (!arena) {
+      arena = std::shared_ptr<DelayArena>(new DelayArena());
+      instance = arena;
+    }
+    return arena;
+  }
+
+  /**
+   * @brief Check out a zeroed block of at least the given size
+   *
+   * Only spares set up with the same lock, huge-page and pre-fault options
+   * are reused. The block returns to the arena when the last shared_ptr to
+   * it goes.
+   */
+  std::shared_ptr<DelayPages> checkout(size_t bytes,
+                                       const DelayMemoryOptions& options) {
+    std::unique_ptr<DelayPages> block;
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+      // Best fit among the spares set up like the request (a spare that
+      // was never locked is no use when locking is asked for), as long as
+      // it wastes less than half
+      auto best = spare_.end();
+      for (auto it = spare_.begin(); it != spare_.end(); ++it) {
+        const size_t size = (*it)->bytes();
+        if (size >= bytes && size / 2 < bytes && (*it)->matches(options) &&
+            (best == spare_.end() || size < (*best)->bytes()))
+          best = it;
+      }
+      if (best != spare_.end()) {
+        block = std::move(*best);
+        spare_.erase(best);
+        spareBytes_ -= block->bytes();
+      }
+    }
+
+    if (!block) {
+      block = std::make_unique<DelayPages>();
+      if (!block->allocate(bytes, options))
+        return nullptr;
+    }
+
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+      inUseBytes_ += block->bytes();
+      ++numLeases_;
+    }
+    auto self = shared_from_this();
+    return std::shared_ptr<DelayPages>(
+        block.release(), [self](DelayPages* pages) { self->giveBack(pages); });
+  }
+
+  /**
+   * @brief Bytes of spare blocks kept for reuse (0 = free on return)
+   */
+  void setSpareLimit(size_t bytes) {
+    std::vector<std::unique_ptr<DelayPages>> freed;
+    const std::lock_guard<std::mutex> lock(mutex_);
+    spareLimit_ = bytes;
+    trimLocked(freed);
+  }
+
+  /**
+   * @brief Return every spare block to the OS
+   */
+  void trim() {
+    std::vector<std::unique_ptr<DelayPages>> freed;
+    const std::lock_guard<std::mutex> lock(mutex_);
+    const size_t limit = spareLimit_;
+    spareLimit_ = 0;
+    trimLocked(freed);
+    spareLimit_ = limit;
+  }
+
+  Stats getStats() const {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats;
+    stats.inUseBytes = inUseBytes_;
+    stats.spareBytes = spareBytes_;
+    stats.numLeases = numLeases_;
+    // Leases hold a reference too; the rest are instances
+    stats.numUsers =
+        static_cast<int>(weak_from_this().use_count()) - numLeases_;
+    return stats;
+  }
+
+private:
+  DelayArena() = default;
+
+  void giveBack(DelayPages* pages) {
+    std::unique_ptr<DelayPages> block(pages);
+    std::vector<std::unique_ptr<DelayPages>> freed;
+
+    const std::lock_guard<std::mutex> lock(mutex_);
+    inUseBytes_ -= block->bytes();
+    --numLeases_;
+    if (spareBytes_ + block->bytes() > spareLimit_) {
+      freed.push_back(std::move(block));
+      return;
+    }
+    // Spares are handed out as if freshly allocated
+    std::memset(block->data(), 0, block->bytes());
+    spareBytes_ += block->bytes();
+    spare_.push_back(std::move(block));
+  }
+
+  void trimLocked(std::vector<std::unique_ptr<DelayPages>>& freed) {
+    while (spareBytes_ > spareLimit_ && !spare_.empty()) {
+      spareBytes_ -= spare_.back()->bytes();
+      freed.push_back(std::move(spare_.back()));
+      spare_.pop_back();
+    }
+  }
+
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<DelayPages>> spare_;
+  size_t spareBytes_ = 0;
+  size_t spareLimit_ = kDefaultSpareLimit;
+  size_t inUseBytes_ = 0;
+  int numLeases_ = 0;
+};
+
+/**
+ * @brief Typed delay-line storage on top of DelayPages
+ *
+ * Owns its block privately, or leases it from a shared DelayArena when
+ * DelayMemoryOptions::arena is set. allocate() only reallocates when the
+ * requested size exceeds the current one; the contents are not preserved
+ * across a reallocation. Message thread only, like the arena.
+ */
+template <typename SampleType> class DelayMemory {
+public:
+  /**
+   * @brief Ensure room for numElements zeroed samples
+   * @return true if a new block was allocated (old contents dropped)
+   */
+  bool allocate(size_t numElements, const DelayMemoryOptions& options = {}) {
+    if (numElements <= size_)
+      return false;
+
+    release();
+    const size_t bytes = numElements * sizeof(SampleType);
+    if (options.arena) {
+      block_ = options.arena->checkout(bytes, options);
+    } else {
+      auto pages = std::make_shared<DelayPages>();
+      if (pages->allocate(bytes, options))
+        block_ = std::move(pages);
+    }
+
+    if (block_) {
+      data_ = static_cast<SampleType*>(block_->data());
+      size_ = numElements;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Drop the block (back to the arena when leased)
+   */
+  void release() {
+    block_.reset();
+    data_ = nullptr;
+    size_ = 0;
+  }
+
+  SampleType* data() { return data_; }
+  const SampleType* data() const { return data_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  const DelayMemoryStatus& getStatus() const {
+    static const DelayMemoryStatus none;
+    return block_ ? block_->getStatus() : none;
+  }
+
+private:
+  std::shared_ptr<DelayPages> block_;
+  SampleType* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+} // namespace uds
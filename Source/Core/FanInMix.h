@@ -0,0 +1,93 @@
+#pragma once
+
+#include "SimdDispatch.h"
+
+#include <algorithm>
+
+namespace uds {
+
+/**
+ * @brief Fused fan-in: dest = sum of gains[k] * sources[k], written once
+ *
+ * A node's inputs are mixed kChunk samples at a time into a local
+ * accumulator that stays in registers: each source is read once and the
+ * destination is stored once, instead of one read-modify-write pass over
+ * dest per source and channel. The inner loops are plain fixed-length
+ * loops the compiler vectorizes. dest must not alias a source.
+ *
+ * No sources writes silence; a single unity-gain source is a copy.
+ * run() calls the build for the current SimdTier. Allocation-free.
+ */
+template <typename SampleType> struct FanInMix {
+  static constexpr int kChunk = 16;
+
+  static void run(SampleType* dest, const SampleType* const* sources,
+                  const SampleType* gains, int numSources, int length) {
+    static constexpr SimdKernel<Fn> kernel{{&runSse2, &runAvx2, &runAvx512}};
+    kernel.get()(dest, sources, gains, numSources, length);
+  }
+
+private:
+  using Fn = void (*)(SampleType*, const SampleType* const*,
+                      const SampleType*, int, int);
+
+  static void runSse2(SampleType* dest, const SampleType* const* sources,
+                      const SampleType* gains, int numSources, int length) {
+    mix(dest, sources, gains, numSources, length);
+  }
+
+  UDS_TARGET_AVX2 static void runAvx2(SampleType* dest,
+                                      const SampleType* const* sources,
+                                      const SampleType* gains, int numSources,
+                                      int length) {
+    mix(dest, sources, gains, numSources, length);
+  }
+
+  UDS_TARGET_AVX512 static void runAvx512(SampleType* dest,
+                                          const SampleType* const* sources,
+                                          const SampleType* gains,
+                                          int numSources, int length) {
+    mix(dest, sources, gains, numSources, length);
+  }
+
+  static UDS_SIMD_INLINE void mix(SampleType* dest,
+                                  const SampleType* const* sources,
+                                  const SampleType* gains, int numSources,
+                                  int length) {
+    if (numSources == 0) {
+      std::fill(dest, dest + length, SampleType(0));
+      return;
+    }
+    if (numSources == 1 && gains[0] == SampleType(1)) {
+      std::copy(sources[0], sources[0] + length, dest);
+      return;
+    }
+
+    int i = 0;
+    for (; i + kChunk <= length; i += kChunk) {
+      SampleType acc[kChunk];
+      const SampleType* first = sources[0] + i;
+      const SampleType g0 = gains[0];
+      for (int j = 0; j < kChunk; ++j)
+        acc[j] = g0 * first[j];
+      for (int k = 1; k < numSources; ++k) {
+        const SampleType* src = sources[k] + i;
+        const SampleType g = gains[k];
+        for (int j = 0; j < kChunk; ++j)
+          acc[j] += g * src[j];
+      }
+      for (int j = 0; j < kChunk; ++j)
+        dest[i + j] = acc[j];
+    }
+
+    // Remainder, one sample at a time
+    for (; i < length; ++i) {
+      SampleType acc = gains[0] * sources[0][i];
+      for (int k = 1; k < numSources; ++k)
+        acc += gains[k] * sources[k][i];
+      dest[i] = acc;
+    }
+  }
+};
+
+} // namespace uds
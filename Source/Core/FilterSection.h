@@ -1,5 +1,9 @@
 #pragma once
 
+#include "ChannelLayout.h"
+
+#include <algorithm>
+#include <array>
 #include <cmath>
 
 namespace uds {
@@ -7,21 +11,21 @@ namespace uds {
 /**
  * @brief Simple biquad filter coefficients
  */
-struct BiquadCoeffs {
-  float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f;
-  float a1 = 0.0f, a2 = 0.0f;
+template <typename SampleType> struct BiquadCoeffs {
+  SampleType b0 = 1, b1 = 0, b2 = 0;
+  SampleType a1 = 0, a2 = 0;
 };
 
 /**
  * @brief Biquad filter state
  */
-struct BiquadState {
-  float z1 = 0.0f, z2 = 0.0f;
+template <typename SampleType> struct BiquadState {
+  SampleType z1 = 0, z2 = 0;
 
-  void reset() { z1 = z2 = 0.0f; }
+  void reset() { z1 = z2 = 0; }
 
-  float process(float input, const BiquadCoeffs &c) {
-    float output = c.b0 * input + z1;
+  SampleType process(SampleType input, const BiquadCoeffs<SampleType>& c) {
+    SampleType output = c.b0 * input + z1;
     z1 = c.b1 * input - c.a1 * output + z2;
     z2 = c.b2 * input - c.a2 * output;
     return output;
@@ -34,19 +38,34 @@ struct BiquadState {
  * Uses 2nd order Butterworth filters for smooth frequency response.
  * Hi-cut: Low-pass filter (removes highs)
  * Lo-cut: High-pass filter (removes lows)
+ *
+ * Templated on sample type so the double-precision path keeps the
+ * recursive filter state in 64-bit (no drift on long feedback tails).
+ *
+ * Filter state is stored structure-of-arrays (one lane per channel) so
+ * processFrame() runs the same coefficients across every channel of a frame
+ * in a single vectorisable loop.
+ *
+ * The ends of the parameter ranges switch a filter off: a hi-cut at
+ * kHiCutOffHz or above and a lo-cut at kLoCutOffHz or below pass the
+ * signal unchanged (identity coefficients, cleared state), and a section
+ * with both off reports !isActive() so callers can skip it.
  */
-class FilterSection {
+template <typename SampleType> class FilterSection {
 public:
+  static constexpr float kHiCutOffHz = 20000.0f;
+  static constexpr float kLoCutOffHz = 20.0f;
+
   void prepare(double sampleRate) {
     sampleRate_ = sampleRate;
     updateCoefficients();
   }
 
   void reset() {
-    hiCutStateL_.reset();
-    hiCutStateR_.reset();
-    loCutStateL_.reset();
-    loCutStateR_.reset();
+    hiCutZ1_.fill(SampleType(0));
+    hiCutZ2_.fill(SampleType(0));
+    loCutZ1_.fill(SampleType(0));
+    loCutZ2_.fill(SampleType(0));
   }
 
   void setHiCutFrequency(float freqHz) {
@@ -64,20 +83,48 @@ public:
   }
 
   // Process stereo pair
-  void processSample(float &left, float &right) {
+  void processSample(SampleType& left, SampleType& right) {
+    SampleType frame[2] = {left, right};
+    processFrame(frame, 2);
+    left = frame[0];
+    right = frame[1];
+  }
+
+  /**
+   * @brief Filter one sample on each of numChannels channels in place
+   */
+  void processFrame(SampleType* frame, int numChannels) {
     // Apply hi-cut (low-pass)
-    left = hiCutStateL_.process(left, hiCutCoeffs_);
-    right = hiCutStateR_.process(right, hiCutCoeffs_);
+    processBiquadLanes(frame, numChannels, hiCutCoeffs_, hiCutZ1_, hiCutZ2_);
 
     // Apply lo-cut (high-pass)
-    left = loCutStateL_.process(left, loCutCoeffs_);
-    right = loCutStateR_.process(right, loCutCoeffs_);
+    processBiquadLanes(frame, numChannels, loCutCoeffs_, loCutZ1_, loCutZ2_);
+  }
+
+  /** @brief False when both filters are off (processFrame() is a no-op) */
+  bool isActive() const {
+    return hiCutHz_ < kHiCutOffHz || loCutHz_ > kLoCutOffHz;
   }
 
   float getHiCutHz() const { return hiCutHz_; }
   float getLoCutHz() const { return loCutHz_; }
 
 private:
+  using Lanes = std::array<SampleType, kMaxChannels>;
+
+  // Transposed direct form II, one lane per channel
+  static void processBiquadLanes(SampleType* frame, int numChannels,
+                                 const BiquadCoeffs<SampleType>& c, Lanes& z1,
+                                 Lanes& z2) {
+    for (int ch = 0; ch < numChannels; ++ch) {
+      const SampleType input = frame[ch];
+      const SampleType output = c.b0 * input + z1[ch];
+      z1[ch] = c.b1 * input - c.a1 * output + z2[ch];
+      z2[ch] = c.b2 * input - c.a2 * output;
+      frame[ch] = output;
+    }
+  }
+
   void updateCoefficients() {
     updateHiCut();
     updateLoCut();
@@ -87,57 +134,75 @@ private:
   void updateHiCut() {
     if (sampleRate_ <= 0.0)
       return;
+    if (hiCutHz_ >= kHiCutOffHz) {
+      hiCutCoeffs_ = {};
+      hiCutZ1_.fill(SampleType(0));
+      hiCutZ2_.fill(SampleType(0));
+      return;
+    }
 
     // Clamp frequency
-    float freq =
-        std::clamp(hiCutHz_, 20.0f, static_cast<float>(sampleRate_ * 0.49));
+    const auto fs = static_cast<SampleType>(sampleRate_);
+    SampleType freq = std::clamp(static_cast<SampleType>(hiCutHz_),
+                                 SampleType(20), fs * SampleType(0.49));
 
     // Butterworth low-pass
-    float omega = 2.0f * 3.14159265f * freq / static_cast<float>(sampleRate_);
-    float sinOmega = std::sin(omega);
-    float cosOmega = std::cos(omega);
-    float alpha = sinOmega / (2.0f * 0.7071f); // Q = sqrt(2)/2 for Butterworth
-
-    float a0 = 1.0f + alpha;
-    hiCutCoeffs_.b0 = ((1.0f - cosOmega) / 2.0f) / a0;
-    hiCutCoeffs_.b1 = (1.0f - cosOmega) / a0;
-    hiCutCoeffs_.b2 = ((1.0f - cosOmega) / 2.0f) / a0;
-    hiCutCoeffs_.a1 = (-2.0f * cosOmega) / a0;
-    hiCutCoeffs_.a2 = (1.0f - alpha) / a0;
+    SampleType omega = SampleType(2) * kPi * freq / fs;
+    SampleType sinOmega = std::sin(omega);
+    SampleType cosOmega = std::cos(omega);
+    SampleType alpha = sinOmega / (SampleType(2) * kButterworthQ);
+
+    SampleType a0 = SampleType(1) + alpha;
+    hiCutCoeffs_.b0 = ((SampleType(1) - cosOmega) / SampleType(2)) / a0;
+    hiCutCoeffs_.b1 = (SampleType(1) - cosOmega) / a0;
+    hiCutCoeffs_.b2 = ((SampleType(1) - cosOmega) / SampleType(2)) / a0;
+    hiCutCoeffs_.a1 = (SampleType(-2) * cosOmega) / a0;
+    hiCutCoeffs_.a2 = (SampleType(1) - alpha) / a0;
   }
 
   // High-pass (lo-cut) Butterworth calculation
   void updateLoCut() {
     if (sampleRate_ <= 0.0)
       return;
+    if (loCutHz_ <= kLoCutOffHz) {
+      loCutCoeffs_ = {};
+      loCutZ1_.fill(SampleType(0));
+      loCutZ2_.fill(SampleType(0));
+      return;
+    }
 
     // Clamp frequency
-    float freq =
-        std::clamp(loCutHz_, 20.0f, static_cast<float>(sampleRate_ * 0.49));
+    const auto fs = static_cast<SampleType>(sampleRate_);
+    SampleType freq = std::clamp(static_cast<SampleType>(loCutHz_),
+                                 SampleType(20), fs * SampleType(0.49));
 
     // Butterworth high-pass
-    float omega = 2.0f * 3.14159265f * freq / static_cast<float>(sampleRate_);
-    float sinOmega = std::sin(omega);
-    float cosOmega = std::cos(omega);
-    float alpha = sinOmega / (2.0f * 0.7071f);
-
-    float a0 = 1.0f + alpha;
-    loCutCoeffs_.b0 = ((1.0f + cosOmega) / 2.0f) / a0;
-    loCutCoeffs_.b1 = (-(1.0f + cosOmega)) / a0;
-    loCutCoeffs_.b2 = ((1.0f + cosOmega) / 2.0f) / a0;
-    loCutCoeffs_.a1 = (-2.0f * cosOmega) / a0;
-    loCutCoeffs_.a2 = (1.0f - alpha) / a0;
+    SampleType omega = SampleType(2) * kPi * freq / fs;
+    SampleType sinOmega = std::sin(omega);
+    SampleType cosOmega = std::cos(omega);
+    SampleType alpha = sinOmega / (SampleType(2) * kButterworthQ);
+
+    SampleType a0 = SampleType(1) + alpha;
+    loCutCoeffs_.b0 = ((SampleType(1) + cosOmega) / SampleType(2)) / a0;
+    loCutCoeffs_.b1 = (-(SampleType(1) + cosOmega)) / a0;
+    loCutCoeffs_.b2 = ((SampleType(1) + cosOmega) / SampleType(2)) / a0;
+    loCutCoeffs_.a1 = (SampleType(-2) * cosOmega) / a0;
+    loCutCoeffs_.a2 = (SampleType(1) - alpha) / a0;
   }
 
+  static constexpr SampleType kPi = static_cast<SampleType>(3.14159265358979);
+  // Q = sqrt(2)/2 for Butterworth
+  static constexpr SampleType kButterworthQ = static_cast<SampleType>(0.7071);
+
   double sampleRate_ = 44100.0;
   float hiCutHz_ = 12000.0f;
   float loCutHz_ = 80.0f;
 
-  BiquadCoeffs hiCutCoeffs_;
-  BiquadCoeffs loCutCoeffs_;
+  BiquadCoeffs<SampleType> hiCutCoeffs_;
+  BiquadCoeffs<SampleType> loCutCoeffs_;
 
-  BiquadState hiCutStateL_, hiCutStateR_;
-  BiquadState loCutStateL_, loCutStateR_;
+  Lanes hiCutZ1_{}, hiCutZ2_{};
+  Lanes loCutZ1_{}, loCutZ2_{};
 };
 
 } // namespace uds
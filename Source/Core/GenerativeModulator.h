@@ -140,11 +140,57 @@ public:
     return rawValue * depth_;
   }
 
+  /**
+   * @brief Advance by stride samples and return the value at the start
+   *
+   * Used when modulation runs at a reduced control rate: periodic shapes
+   * jump their phase directly and the random-walk slew is applied in closed
+   * form. Lorenz keeps its per-sample integration so the trajectory does
+   * not change with the stride.
+   */
+  float tick(int stride) {
+    if (stride <= 1)
+      return tick();
+
+    switch (type_) {
+    case ModulationType::Brownian: {
+      const float prevPhase = phase_;
+      advancePhase(rateHz_ / static_cast<float>(sampleRate_) *
+                   static_cast<float>(stride));
+      if (phase_ < prevPhase) {
+        float step = (rng_.nextFloat() - 0.5f) * 0.4f; // ±0.2 step
+        brownianTarget_ =
+            std::clamp((brownianTarget_ + step) * 0.92f, -1.0f, 1.0f);
+      }
+      const float value = brownianValue_ * depth_;
+      // Same slew as per-sample ticks: (1 - 0.001)^stride of the gap remains
+      const float remaining =
+          std::pow(1.0f - 0.001f, static_cast<float>(stride));
+      brownianValue_ += (brownianTarget_ - brownianValue_) * (1.0f - remaining);
+      return value;
+    }
+
+    case ModulationType::Lorenz: {
+      const float value = tick();
+      for (int i = 1; i < stride; ++i)
+        tick();
+      return value;
+    }
+
+    default: {
+      const float value = tick();
+      advancePhase(rateHz_ / static_cast<float>(sampleRate_) *
+                   static_cast<float>(stride - 1));
+      return value;
+    }
+    }
+  }
+
 private:
   void advancePhase(float inc) {
     phase_ += inc;
     if (phase_ >= 1.0f)
-      phase_ -= 1.0f;
+      phase_ -= std::floor(phase_);
   }
 
   double sampleRate_ = 44100.0;
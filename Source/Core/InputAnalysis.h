@@ -0,0 +1,108 @@
+#pragma once
+
+#include "ChannelLayout.h"
+#include "PeakScan.h"
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace uds {
+
+/**
+ * @brief Level analysis of one signal, shared by every band it feeds
+ *
+ * For each sample of a tile: the peak across channels (what AttackEnvelope
+ * triggers on), a peak envelope follower (kAttackMs / kReleaseMs) and
+ * onsets (the peak rising through kOnsetThreshold). The follower and onset
+ * state carry over from one tile to the next. Buffers are sized in
+ * prepare(); process() is allocation-free.
+ */
+template <typename SampleType> class InputAnalysis {
+public:
+  static constexpr float kOnsetThreshold = 0.001f; // -60 dB, as AttackEnvelope
+  static constexpr float kAttackMs = 1.0f;
+  static constexpr float kReleaseMs = 100.0f;
+
+  void prepare(double sampleRate, int maxSamples) {
+    const auto size = static_cast<size_t>(std::max(maxSamples, 1));
+    peak_.assign(size, 0.0f);
+    if constexpr (!std::is_same_v<SampleType, float>)
+      scan_.assign(size, SampleType(0));
+    envelope_.assign(size, 0.0f);
+    onsets_.assign(size, 0);
+    const double samplesPerMs = sampleRate * 0.001;
+    attackCoeff_ = static_cast<float>(
+        1.0 - std::exp(-1.0 / (kAttackMs * samplesPerMs)));
+    releaseCoeff_ = static_cast<float>(
+        1.0 - std::exp(-1.0 / (kReleaseMs * samplesPerMs)));
+    reset();
+  }
+
+  void reset() {
+    level_ = 0.0f;
+    above_ = false;
+    length_ = 0;
+  }
+
+  /**
+   * @brief Analyse the first length samples of source's first numChannels
+   *        channels (length is clamped to the prepared size)
+   */
+  void process(const juce::AudioBuffer<SampleType>& source, int numChannels,
+               int length) {
+    length_ = std::clamp(length, 0, static_cast<int>(peak_.size()));
+    std::array<const SampleType*, kMaxChannels> channels{};
+    numChannels = std::clamp(numChannels, 0, kMaxChannels);
+    for (int ch = 0; ch < numChannels; ++ch)
+      channels[static_cast<size_t>(ch)] = source.getReadPointer(ch);
+    float* peak = peak_.data();
+    if constexpr (std::is_same_v<SampleType, float>) {
+      PeakScan<float>::run(peak, channels.data(), numChannels, length_);
+    } else {
+      PeakScan<SampleType>::run(scan_.data(), channels.data(), numChannels,
+                                length_);
+      for (int i = 0; i < length_; ++i)
+        peak[i] = static_cast<float>(scan_[static_cast<size_t>(i)]);
+    }
+
+    for (int i = 0; i < length_; ++i) {
+      const bool above = peak[i] > kOnsetThreshold;
+      onsets_[static_cast<size_t>(i)] = above && !above_ ? 1 : 0;
+      above_ = above;
+      level_ += (peak[i] > level_ ? attackCoeff_ : releaseCoeff_) *
+                (peak[i] - level_);
+      envelope_[static_cast<size_t>(i)] = level_;
+    }
+  }
+
+  /** @brief Samples analysed by the last process() call */
+  int getLength() const { return length_; }
+
+  /** @brief Per-sample peak across channels (absolute value) */
+  const float* getPeak() const { return peak_.data(); }
+
+  /** @brief Per-sample envelope of the peak */
+  const float* getEnvelope() const { return envelope_.data(); }
+
+  /** @brief 1 where the peak rises through kOnsetThreshold, else 0 */
+  const uint8_t* getOnsets() const { return onsets_.data(); }
+
+private:
+  std::vector<float> peak_;
+  std::vector<SampleType> scan_; // Peak at SampleType precision (double)
+  std::vector<float> envelope_;
+  std::vector<uint8_t> onsets_;
+  float attackCoeff_ = 1.0f;
+  float releaseCoeff_ = 1.0f;
+  float level_ = 0.0f;
+  bool above_ = false;
+  int length_ = 0;
+};
+
+} // namespace uds
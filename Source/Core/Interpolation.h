@@ -0,0 +1,295 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace uds {
+
+/**
+ * @brief Fractional delay interpolation tiers (cheapest first)
+ *
+ * None reads the nearest sample, Linear/Hermite/Lagrange6 are polynomial
+ * FIR kernels, Allpass is a first-order Thiran allpass (flat magnitude,
+ * stateful), and Sinc is a 16-point Kaiser-windowed sinc read from a
+ * precomputed polyphase table. See DSPBenchmarks.cpp for cost and THD+N.
+ */
+enum class InterpolationType {
+  None,      // Integer (nearest sample)
+  Linear,    // 2-point
+  Hermite,   // 4-point cubic Hermite (default)
+  Lagrange6, // 6-point Lagrange
+  Allpass,   // First-order Thiran allpass
+  Sinc       // 16-point windowed sinc (polyphase table)
+};
+
+/**
+ * @brief Weights for one fractional read, shared by every channel of a frame
+ *
+ * The read sums weights[k] * x[delay - newest + k] for k < numPoints, where
+ * x[m] is the frame written m samples ago. Allpass adds the recursive term
+ * -allpassCoeff * y[n - 1] on top (see FractionalDelay::applyAllpass).
+ */
+template <typename SampleType> struct InterpolationKernel {
+  static constexpr int kMaxPoints = 16;
+
+  std::array<SampleType, kMaxPoints> weights{};
+  int numPoints = 1;
+  int newest = 0;
+  int delay = 0;
+  SampleType allpassCoeff = SampleType(0);
+  bool recursive = false;
+};
+
+/**
+ * @brief Kaiser-windowed sinc phases for the Sinc tier
+ *
+ * kPhases + 1 rows so the last phase (fraction 1.0) can be blended without
+ * wrapping. Built once on first use; call get() from prepare() so the audio
+ * thread never pays for it.
+ */
+class SincTable {
+public:
+  static constexpr int kPoints = 16;
+  static constexpr int kPhases = 256;
+
+  static const SincTable& get() {
+    static const SincTable table;
+    return table;
+  }
+
+  const double* phase(int p) const {
+    return table_[static_cast<size_t>(p)].data();
+  }
+
+private:
+  SincTable() {
+    constexpr double pi = 3.14159265358979323846;
+    constexpr double beta = 8.0;
+    constexpr double half = kPoints / 2;
+    const double norm = besselI0(beta);
+
+    for (int p = 0; p <= kPhases; ++p) {
+      const double frac = static_cast<double>(p) / kPhases;
+      auto& row = table_[static_cast<size_t>(p)];
+      double sum = 0.0;
+      for (int k = 0; k < kPoints; ++k) {
+        // Distance from the read point; points sit at newest = half - 1
+        const double t = static_cast<double>(k) - (half - 1.0) - frac;
+        const double sinc = t == 0.0 ? 1.0 : std::sin(pi * t) / (pi * t);
+        const double r = std::clamp(t / half, -1.0, 1.0);
+        const double window = besselI0(beta * std::sqrt(1.0 - r * r)) / norm;
+        row[static_cast<size_t>(k)] = sinc * window;
+        sum += sinc * window;
+      }
+      // Unity gain at DC for every phase
+      for (auto& w : row)
+        w /= sum;
+    }
+  }
+
+  static double besselI0(double x) {
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 32; ++k) {
+      const double q = x / (2.0 * k);
+      term *= q * q;
+      sum += term;
+    }
+    return sum;
+  }
+
+  std::array<std::array<double, kPoints>, kPhases + 1> table_{};
+};
+
+/**
+ * @brief Kernel builder and frame reader for a frame-interleaved delay line
+ *
+ * Weights are computed once per read head and sample, then applied with
+ * straight loops across the contiguous channels of each frame (the part the
+ * compiler vectorises).
+ */
+template <typename SampleType> class FractionalDelay {
+public:
+  using Kernel = InterpolationKernel<SampleType>;
+
+  /** Points the widest kernel needs on either side of the integer delay. */
+  static constexpr int kMaxNewest = SincTable::kPoints / 2 - 1;
+  static constexpr int kMaxOlder = SincTable::kPoints / 2;
+
+  /**
+   * @brief Build the kernel for a delay of delaySamples (>= kMaxNewest + 1)
+   */
+  static void makeKernel(InterpolationType type, SampleType delaySamples,
+                         Kernel& k) {
+    int n = static_cast<int>(delaySamples);
+    SampleType f = delaySamples - static_cast<SampleType>(n);
+    auto& w = k.weights;
+    k.allpassCoeff = SampleType(0);
+    k.recursive = type == InterpolationType::Allpass;
+
+    switch (type) {
+    case InterpolationType::None:
+      k.numPoints = 1;
+      k.newest = 0;
+      w[0] = SampleType(1);
+      if (f >= SampleType(0.5))
+        ++n;
+      break;
+
+    case InterpolationType::Linear:
+      k.numPoints = 2;
+      k.newest = 0;
+      w[0] = SampleType(1) - f;
+      w[1] = f;
+      break;
+
+    case InterpolationType::Hermite: {
+      const SampleType f2 = f * f;
+      const SampleType f3 = f2 * f;
+      k.numPoints = 4;
+      k.newest = 1;
+      w[0] = SampleType(-0.5) * f + f2 - SampleType(0.5) * f3;
+      w[1] = SampleType(1) - SampleType(2.5) * f2 + SampleType(1.5) * f3;
+      w[2] = SampleType(0.5) * f + SampleType(2) * f2 - SampleType(1.5) * f3;
+      w[3] = SampleType(-0.5) * f2 + SampleType(0.5) * f3;
+      break;
+    }
+
+    case InterpolationType::Lagrange6: {
+      // Points at -2..3 around the integer delay; d is measured from the
+      // newest point so the read sits in the centre interval. Prefix and
+      // suffix products of (d - j) avoid the O(N^2) form; the denominators
+      // prod_{j != i} (i - j) are constants.
+      const SampleType d = f + SampleType(2);
+      constexpr std::array<double, 6> inverseDenominators{
+          -1.0 / 120.0, 1.0 / 24.0, -1.0 / 12.0,
+          1.0 / 12.0,   -1.0 / 24.0, 1.0 / 120.0};
+      std::array<SampleType, 6> prefix{}, suffix{};
+      prefix[0] = SampleType(1);
+      suffix[5] = SampleType(1);
+      for (size_t j = 1; j < 6; ++j) {
+        prefix[j] = prefix[j - 1] * (d - SampleType(j - 1));
+        suffix[5 - j] = suffix[6 - j] * (d - SampleType(6 - j));
+      }
+      k.numPoints = 6;
+      k.newest = 2;
+      for (size_t i = 0; i < 6; ++i)
+        w[i] = prefix[i] * suffix[i] *
+               static_cast<SampleType>(inverseDenominators[i]);
+      break;
+    }
+
+    case InterpolationType::Allpass: {
+      // Keep the fractional part in [0.5, 1.5) so the pole stays well inside
+      // the unit circle: y = c * x[n] + x[n + 1] - c * y[-1]
+      if (f < SampleType(0.5)) {
+        --n;
+        f += SampleType(1);
+      }
+      const SampleType c = (SampleType(1) - f) / (SampleType(1) + f);
+      k.numPoints = 2;
+      k.newest = 0;
+      w[0] = c;
+      w[1] = SampleType(1);
+      k.allpassCoeff = c;
+      break;
+    }
+
+    case InterpolationType::Sinc: {
+      const auto& table = SincTable::get();
+      const SampleType pos = f * SampleType(SincTable::kPhases);
+      const int p = std::min(static_cast<int>(pos), SincTable::kPhases - 1);
+      const SampleType blend = pos - static_cast<SampleType>(p);
+      const double* a = table.phase(p);
+      const double* b = table.phase(p + 1);
+      k.numPoints = SincTable::kPoints;
+      k.newest = kMaxNewest;
+      for (int i = 0; i < SincTable::kPoints; ++i) {
+        const auto wa = static_cast<SampleType>(a[i]);
+        const auto wb = static_cast<SampleType>(b[i]);
+        w[static_cast<size_t>(i)] = wa + (wb - wa) * blend;
+      }
+      break;
+    }
+    }
+
+    k.delay = n;
+  }
+
+  /**
+   * @brief Read one interpolated frame (all channels) before applying gains
+   *
+   * @param line Frame-interleaved circular buffer
+   * @param lineLength Buffer length in frames
+   * @param stride Channels per frame in the buffer
+   * @param writePos Frame about to be written (x[m] sits m frames before)
+   */
+  static void readFrame(const SampleType* line, int lineLength, int stride,
+                        int numChannels, int writePos, const Kernel& k,
+                        SampleType* out) {
+    int pos = writePos - k.delay + k.newest;
+    while (pos < 0)
+      pos += lineLength;
+    while (pos >= lineLength)
+      pos -= lineLength;
+
+    // Fixed point counts let the compiler unroll the taps and vectorise
+    // across channels
+    switch (k.numPoints) {
+    case 1:
+      readPoints<1>(line, lineLength, stride, numChannels, pos, k, out);
+      break;
+    case 2:
+      readPoints<2>(line, lineLength, stride, numChannels, pos, k, out);
+      break;
+    case 4:
+      readPoints<4>(line, lineLength, stride, numChannels, pos, k, out);
+      break;
+    case 6:
+      readPoints<6>(line, lineLength, stride, numChannels, pos, k, out);
+      break;
+    default:
+      readPoints<SincTable::kPoints>(line, lineLength, stride, numChannels,
+                                     pos, k, out);
+      break;
+    }
+  }
+
+  /**
+   * @brief Recursive part of the Allpass tier (no-op for FIR kernels)
+   * @param state Previous output per channel (updated in place)
+   */
+  static void applyAllpass(const Kernel& k, SampleType* frame,
+                           SampleType* state, int numChannels) {
+    if (!k.recursive)
+      return;
+    for (int ch = 0; ch < numChannels; ++ch) {
+      frame[ch] -= k.allpassCoeff * state[ch];
+      state[ch] = frame[ch];
+    }
+  }
+
+private:
+  template <int NumPoints>
+  static void readPoints(const SampleType* line, int lineLength, int stride,
+                         int numChannels, int newestPos, const Kernel& k,
+                         SampleType* out) {
+    std::array<const SampleType*, NumPoints> frames;
+    int pos = newestPos;
+    for (int i = 0; i < NumPoints; ++i) {
+      frames[static_cast<size_t>(i)] =
+          line + static_cast<size_t>(pos) * static_cast<size_t>(stride);
+      pos = pos > 0 ? pos - 1 : lineLength - 1;
+    }
+
+    for (int ch = 0; ch < numChannels; ++ch) {
+      SampleType acc = SampleType(0);
+      for (int i = 0; i < NumPoints; ++i)
+        acc += k.weights[static_cast<size_t>(i)] *
+               frames[static_cast<size_t>(i)][ch];
+      out[ch] = acc;
+    }
+  }
+};
+
+} // namespace uds
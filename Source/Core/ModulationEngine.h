@@ -4,6 +4,7 @@
 
 #include <juce_audio_basics/juce_audio_basics.h>
 
+#include <algorithm>
 #include <array>
 
 
@@ -22,9 +23,11 @@ public:
   void prepare(double sampleRate, size_t maxBlockSize) {
     // Output buffers
     // 12 Channels for bands
-    localModBuffer_.setSize(12, static_cast<int>(maxBlockSize));
+    localModBuffer_.setSize(12, static_cast<int>(maxBlockSize), false, false,
+                            true);
     // 1 Channel for master
-    masterModBuffer_.setSize(1, static_cast<int>(maxBlockSize));
+    masterModBuffer_.setSize(1, static_cast<int>(maxBlockSize), false, false,
+                             true);
 
     // Prepare modulators
     for (auto& mod : bandModulators_) {
@@ -41,6 +44,8 @@ public:
 
     localModBuffer_.clear();
     masterModBuffer_.clear();
+    lastLocal_.fill(0.0f);
+    lastMaster_ = 0.0f;
   }
 
   // Parameter setters
@@ -56,6 +61,15 @@ public:
     masterModulator_.setParams(type, rate, depth);
   }
 
+  /**
+   * @brief Compute modulators once every stride samples (1 = every sample)
+   *
+   * Between control ticks the output ramps linearly, so a reduced rate
+   * stays click-free (at the cost of one stride of lag).
+   */
+  void setControlStride(int stride) { controlStride_ = std::max(1, stride); }
+  int getControlStride() const { return controlStride_; }
+
   /**
    * @brief Generate modulation signals for the current block
    */
@@ -65,18 +79,14 @@ public:
 
     // 1. Process Master Modulator
     auto* masterWrite = masterModBuffer_.getWritePointer(0);
-    for (int i = 0; i < numSamples; ++i) {
-      masterWrite[i] = masterModulator_.tick();
-    }
+    renderModulator(masterModulator_, masterWrite, numSamples, lastMaster_);
 
     // 2. Process Band Modulators
     for (int ch = 0; ch < 12; ++ch) {
       auto* bandWrite = localModBuffer_.getWritePointer(ch);
       auto& modulator = bandModulators_[static_cast<size_t>(ch)];
-
-      for (int i = 0; i < numSamples; ++i) {
-        bandWrite[i] = modulator.tick();
-      }
+      renderModulator(modulator, bandWrite, numSamples,
+                      lastLocal_[static_cast<size_t>(ch)]);
     }
   }
 
@@ -89,6 +99,26 @@ public:
   }
 
 private:
+  void renderModulator(GenerativeModulator& modulator, float* dest,
+                       int numSamples, float& last) const {
+    if (controlStride_ <= 1) {
+      for (int i = 0; i < numSamples; ++i) {
+        dest[i] = modulator.tick();
+      }
+      last = dest[numSamples - 1];
+      return;
+    }
+
+    for (int start = 0; start < numSamples; start += controlStride_) {
+      const int length = std::min(controlStride_, numSamples - start);
+      const float target = modulator.tick(length);
+      const float step = (target - last) / static_cast<float>(length);
+      for (int i = 0; i < length; ++i)
+        dest[start + i] = last + step * static_cast<float>(i + 1);
+      last = target;
+    }
+  }
+
   std::array<GenerativeModulator, 12> bandModulators_;
   GenerativeModulator masterModulator_;
 
@@ -99,6 +129,11 @@ private:
   // masterModulatorBuffer_ in process() I will fix this in the code below by
   // using masterModBuffer_ consistently.
   juce::AudioBuffer<float> masterModBuffer_;
+
+  // Control-rate state (last value written per modulator)
+  int controlStride_ = 1;
+  std::array<float, 12> lastLocal_{};
+  float lastMaster_ = 0.0f;
 };
 
 } // namespace uds
@@ -0,0 +1,383 @@
+#pragma once
+
+#include "ChannelLayout.h"
+#include "SimdDispatch.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+namespace uds {
+
+/**
+ * @brief Kaiser-windowed halfband FIR shared by every 2x oversampler
+ *
+ * kTaps = 4k + 3 so the centre tap sits on an odd index: every other odd
+ * tap is zero and the centre is 0.5, which the polyphase loops below
+ * exploit. Built once on first use; call get() from prepare().
+ */
+class HalfbandTable {
+public:
+  static constexpr int kTaps = 31;
+  static constexpr int kCentre = (kTaps - 1) / 2;
+  static constexpr int kPhaseTaps = (kTaps + 1) / 2; // Non-zero even taps
+
+  static const HalfbandTable& get() {
+    static const HalfbandTable table;
+    return table;
+  }
+
+  /** @brief Tap 2 * i of the prototype (i < kPhaseTaps) */
+  double evenTap(int i) const { return even_[static_cast<size_t>(i)]; }
+
+private:
+  HalfbandTable() {
+    constexpr double pi = 3.14159265358979323846;
+    constexpr double beta = 7.0;
+    const double norm = besselI0(beta);
+    double sum = 0.5; // Centre tap
+    for (int i = 0; i < kPhaseTaps; ++i) {
+      const double t = (2.0 * i - kCentre) / 2.0;
+      const double r = (2.0 * i - kCentre) / (kCentre + 1.0);
+      const double window = besselI0(beta * std::sqrt(1.0 - r * r)) / norm;
+      even_[static_cast<size_t>(i)] = 0.5 * std::sin(pi * t) / (pi * t) *
+                                      window;
+      sum += even_[static_cast<size_t>(i)];
+    }
+    // Unity gain at DC
+    for (auto& tap : even_)
+      tap *= 0.5 / (sum - 0.5);
+  }
+
+  static double besselI0(double x) {
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 32; ++k) {
+      const double q = x / (2.0 * k);
+      term *= q * q;
+      sum += term;
+    }
+    return sum;
+  }
+
+  std::array<double, kPhaseTaps> even_{};
+};
+
+/**
+ * @brief 2x up/down sampler for a frame of up to kMaxChannels lanes
+ *
+ * upsample() turns one frame into two at twice the rate; downsample()
+ * turns two back into one. Both are polyphase halfband FIRs over
+ * frame-interleaved history rings, so the taps are computed once per
+ * frame and applied across the contiguous channels. The round trip delays
+ * the signal by kLatency frames at the base rate.
+ */
+template <typename SampleType> class Oversampler2x {
+public:
+  static constexpr int kLatency = HalfbandTable::kCentre; // Base-rate frames
+
+  void prepare() {
+    const auto& table = HalfbandTable::get();
+    for (int i = 0; i < HalfbandTable::kPhaseTaps; ++i)
+      taps_[static_cast<size_t>(i)] =
+          static_cast<SampleType>(table.evenTap(i));
+    reset();
+  }
+
+  void reset() {
+    for (auto& frame : upHistory_)
+      frame.fill(SampleType(0));
+    for (auto& frame : downHistory_)
+      frame.fill(SampleType(0));
+    upPos_ = 0;
+    downPos_ = 0;
+  }
+
+  /**
+   * @brief One base-rate frame in, two oversampled frames out (first, second)
+   */
+  void upsample(const SampleType* in, SampleType* first, SampleType* second,
+                int numChannels) {
+    upPos_ = (upPos_ + 1) & (kUpSize - 1);
+    auto& newest = upHistory_[static_cast<size_t>(upPos_)];
+    for (int ch = 0; ch < numChannels; ++ch)
+      newest[static_cast<size_t>(ch)] = in[ch];
+
+    // Even phase: the FIR (x2 for the zero-stuffing gain)
+    for (int ch = 0; ch < numChannels; ++ch)
+      first[ch] = SampleType(0);
+    for (int i = 0; i < HalfbandTable::kPhaseTaps; ++i) {
+      const auto& frame = upHistory_[static_cast<size_t>(
+          (upPos_ - i) & (kUpSize - 1))];
+      const SampleType w = SampleType(2) * taps_[static_cast<size_t>(i)];
+      for (int ch = 0; ch < numChannels; ++ch)
+        first[ch] += w * frame[static_cast<size_t>(ch)];
+    }
+
+    // Odd phase: only the centre tap (0.5 x 2) is non-zero
+    const auto& centre = upHistory_[static_cast<size_t>(
+        (upPos_ - HalfbandTable::kCentre / 2) & (kUpSize - 1))];
+    for (int ch = 0; ch < numChannels; ++ch)
+      second[ch] = centre[static_cast<size_t>(ch)];
+  }
+
+  /**
+   * @brief Two oversampled frames in (first, second), one base-rate frame out
+   */
+  void downsample(const SampleType* first, const SampleType* second,
+                  SampleType* out, int numChannels) {
+    push(first, numChannels);
+    push(second, numChannels);
+
+    // Decimate on the even (first) phase so the round trip is a whole
+    // number of base-rate frames
+    const int newest = downPos_ - 1;
+    const auto& centre = downHistory_[static_cast<size_t>(
+        (newest - HalfbandTable::kCentre) & (kDownSize - 1))];
+    for (int ch = 0; ch < numChannels; ++ch)
+      out[ch] = SampleType(0.5) * centre[static_cast<size_t>(ch)];
+    for (int i = 0; i < HalfbandTable::kPhaseTaps; ++i) {
+      const auto& frame = downHistory_[static_cast<size_t>(
+          (newest - 2 * i) & (kDownSize - 1))];
+      const SampleType w = taps_[static_cast<size_t>(i)];
+      for (int ch = 0; ch < numChannels; ++ch)
+        out[ch] += w * frame[static_cast<size_t>(ch)];
+    }
+  }
+
+private:
+  static constexpr int kUpSize = 16;   // >= kPhaseTaps
+  static constexpr int kDownSize = 32; // >= kTaps
+
+  void push(const SampleType* frame, int numChannels) {
+    downPos_ = (downPos_ + 1) & (kDownSize - 1);
+    auto& slot = downHistory_[static_cast<size_t>(downPos_)];
+    for (int ch = 0; ch < numChannels; ++ch)
+      slot[static_cast<size_t>(ch)] = frame[ch];
+  }
+
+  using Frame = std::array<SampleType, kMaxChannels>;
+  std::array<SampleType, HalfbandTable::kPhaseTaps> taps_{};
+  std::array<Frame, kUpSize> upHistory_{};
+  std::array<Frame, kDownSize> downHistory_{};
+  int upPos_ = 0;
+  int downPos_ = 0;
+};
+
+/**
+ * @brief y[k] += sum_i taps[i] * x[k - i] for k < length
+ *
+ * The block FIR behind both halfband resamplers. Outputs are produced
+ * kChunk at a time in a local accumulator, like FanInMix, so the loop
+ * across outputs vectorizes and y is read and written once. run() calls
+ * the build for the current SimdTier.
+ */
+template <typename SampleType> struct FirAccumulate {
+  static constexpr int kChunk = 16;
+
+  static void run(SampleType* y, const SampleType* x, const SampleType* taps,
+                  int numTaps, int length) {
+    static constexpr SimdKernel<Fn> kernel{{&runSse2, &runAvx2, &runAvx512}};
+    kernel.get()(y, x, taps, numTaps, length);
+  }
+
+private:
+  using Fn = void (*)(SampleType*, const SampleType*, const SampleType*, int,
+                      int);
+
+  static void runSse2(SampleType* y, const SampleType* x,
+                      const SampleType* taps, int numTaps, int length) {
+    accumulate(y, x, taps, numTaps, length);
+  }
+
+  UDS_TARGET_AVX2 static void runAvx2(SampleType* y, const SampleType* x,
+                                      const SampleType* taps, int numTaps,
+                                      int length) {
+    accumulate(y, x, taps, numTaps, length);
+  }
+
+  UDS_TARGET_AVX512 static void runAvx512(SampleType* y, const SampleType* x,
+                                          const SampleType* taps,
+                                          int numTaps, int length) {
+    accumulate(y, x, taps, numTaps, length);
+  }
+
+  static UDS_SIMD_INLINE void accumulate(SampleType* y, const SampleType* x,
+                                         const SampleType* taps, int numTaps,
+                                         int length) {
+    int k = 0;
+    for (; k + kChunk <= length; k += kChunk) {
+      SampleType acc[kChunk];
+      for (int j = 0; j < kChunk; ++j)
+        acc[j] = y[k + j];
+      for (int i = 0; i < numTaps; ++i) {
+        const SampleType w = taps[i];
+        const SampleType* xi = x + k - i;
+        for (int j = 0; j < kChunk; ++j)
+          acc[j] += w * xi[j];
+      }
+      for (int j = 0; j < kChunk; ++j)
+        y[k + j] = acc[j];
+    }
+
+    // Remainder, one output at a time
+    for (; k < length; ++k) {
+      SampleType acc = y[k];
+      for (int i = 0; i < numTaps; ++i)
+        acc += taps[i] * x[k - i];
+      y[k] = acc;
+    }
+  }
+};
+
+/**
+ * @brief Block 2x decimator (polyphase halfband, up to kMaxChannels)
+ *
+ * Each channel's input is split into its even and odd phases, so both
+ * branches are contiguous dot products that the compiler vectorizes
+ * across output samples: the odd phase runs the FIR taps, the even phase
+ * only the centre tap. Output k is produced once input 2k + 1 has arrived;
+ * an odd-length call keeps its last input for the next one. Buffers are
+ * sized in prepare(); process() is allocation-free.
+ */
+template <typename SampleType> class HalfbandDecimator {
+public:
+  static constexpr int kDelay = HalfbandTable::kCentre - 1; // Input samples
+
+  void prepare(int numChannels, int maxInput) {
+    const auto& table = HalfbandTable::get();
+    for (int i = 0; i < HalfbandTable::kPhaseTaps; ++i)
+      taps_[static_cast<size_t>(i)] =
+          static_cast<SampleType>(table.evenTap(i));
+    numChannels_ = std::clamp(numChannels, 1, kMaxChannels);
+    maxInput_ = std::max(maxInput, 1);
+    stride_ = kHistory + maxInput_ + 1;
+    buffer_.assign(static_cast<size_t>(numChannels_ * stride_),
+                   SampleType(0));
+    odd_.assign(static_cast<size_t>(stride_ / 2 + 1), SampleType(0));
+    reset();
+  }
+
+  void reset() {
+    std::fill(buffer_.begin(), buffer_.end(), SampleType(0));
+    pending_ = 0;
+  }
+
+  /**
+   * @brief Feed numInput (<= maxInput) samples per channel
+   * @return Outputs written per channel: (pending + numInput) / 2
+   */
+  int process(const SampleType* const* in, SampleType* const* out,
+              int numInput, int numChannels) {
+    numInput = std::clamp(numInput, 0, maxInput_);
+    numChannels = std::min(numChannels, numChannels_);
+    const int available = pending_ + numInput;
+    const int numOutput = available / 2;
+
+    for (int ch = 0; ch < numChannels; ++ch) {
+      SampleType* b = channel(ch);
+      std::copy(in[ch], in[ch] + numInput, b + kHistory + pending_);
+
+      // y[k] = 0.5 x[2k - 14] + sum_i tap_i x[2k + 1 - 2i], with
+      // x[0] = b[kHistory]; kHistory is even, so odd x are odd b
+      SampleType* odd = odd_.data();
+      const int numOdd = kHistory / 2 + numOutput;
+      for (int q = 0; q < numOdd; ++q)
+        odd[q] = b[2 * q + 1];
+      SampleType* y = out[ch];
+      const SampleType* centre = b + kHistory - kDelay;
+      for (int k = 0; k < numOutput; ++k)
+        y[k] = SampleType(0.5) * centre[2 * k];
+      FirAccumulate<SampleType>::run(y, odd + kHistory / 2, taps_.data(),
+                                     HalfbandTable::kPhaseTaps, numOutput);
+
+      // Keep the history (and an unpaired input) for the next call
+      std::copy(b + 2 * numOutput, b + kHistory + available, b);
+    }
+    pending_ = available - 2 * numOutput;
+    return numOutput;
+  }
+
+private:
+  static constexpr int kHistory = HalfbandTable::kTaps - 1;
+
+  SampleType* channel(int ch) {
+    return buffer_.data() + static_cast<size_t>(ch * stride_);
+  }
+
+  std::array<SampleType, HalfbandTable::kPhaseTaps> taps_{};
+  std::vector<SampleType> buffer_; // Per channel: history, then input
+  std::vector<SampleType> odd_;
+  int numChannels_ = 1;
+  int maxInput_ = 1;
+  int stride_ = 0;
+  int pending_ = 0;
+};
+
+/**
+ * @brief Block 2x interpolator (polyphase halfband, up to kMaxChannels)
+ *
+ * Every input sample gives two outputs: the even one is the FIR over the
+ * input history (a contiguous dot product, vectorized across samples),
+ * the odd one is the centre tap, a delayed copy. Buffers are sized in
+ * prepare(); process() is allocation-free.
+ */
+template <typename SampleType> class HalfbandInterpolator {
+public:
+  static constexpr int kDelay = HalfbandTable::kCentre; // Output samples
+
+  void prepare(int numChannels, int maxInput) {
+    const auto& table = HalfbandTable::get();
+    for (int i = 0; i < HalfbandTable::kPhaseTaps; ++i)
+      taps_[static_cast<size_t>(i)] =
+          static_cast<SampleType>(2.0 * table.evenTap(i));
+    numChannels_ = std::clamp(numChannels, 1, kMaxChannels);
+    maxInput_ = std::max(maxInput, 1);
+    stride_ = kHistory + maxInput_;
+    buffer_.assign(static_cast<size_t>(numChannels_ * stride_),
+                   SampleType(0));
+    even_.assign(static_cast<size_t>(maxInput_), SampleType(0));
+    reset();
+  }
+
+  void reset() { std::fill(buffer_.begin(), buffer_.end(), SampleType(0)); }
+
+  /**
+   * @brief numInput (<= maxInput) samples per channel in, twice as many
+   *        out
+   */
+  void process(const SampleType* const* in, SampleType* const* out,
+               int numInput, int numChannels) {
+    numInput = std::clamp(numInput, 0, maxInput_);
+    numChannels = std::min(numChannels, numChannels_);
+    for (int ch = 0; ch < numChannels; ++ch) {
+      SampleType* u = buffer_.data() + static_cast<size_t>(ch * stride_);
+      std::copy(in[ch], in[ch] + numInput, u + kHistory);
+
+      SampleType* even = even_.data();
+      std::fill(even, even + numInput, SampleType(0));
+      FirAccumulate<SampleType>::run(even, u + kHistory, taps_.data(),
+                                     HalfbandTable::kPhaseTaps, numInput);
+      SampleType* v = out[ch];
+      const SampleType* centre = u + kHistory - HalfbandTable::kCentre / 2;
+      for (int k = 0; k < numInput; ++k) {
+        v[2 * k] = even[k];
+        v[2 * k + 1] = centre[k];
+      }
+
+      std::copy(u + numInput, u + kHistory + numInput, u);
+    }
+  }
+
+private:
+  static constexpr int kHistory = HalfbandTable::kPhaseTaps - 1;
+
+  std::array<SampleType, HalfbandTable::kPhaseTaps> taps_{};
+  std::vector<SampleType> buffer_; // Per channel: history, then input
+  std::vector<SampleType> even_;
+  int numChannels_ = 1;
+  int maxInput_ = 1;
+  int stride_ = 0;
+};
+
+} // namespace uds
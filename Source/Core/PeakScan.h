@@ -0,0 +1,59 @@
+#pragma once
+
+#include "SimdDispatch.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace uds {
+
+/**
+ * @brief peak[i] = max over channels of |channels[ch][i]|, for i < length
+ *
+ * The per-sample peak across channels that the SafetyLimiter's detectors
+ * and InputAnalysis start from, scanned a block at a time so it
+ * vectorizes across samples. A NaN input sample leaves the peak as it
+ * was (std::max keeps its first argument). run() calls the build for the
+ * current SimdTier.
+ */
+template <typename SampleType> struct PeakScan {
+  static void run(SampleType* peak, const SampleType* const* channels,
+                  int numChannels, int length) {
+    static constexpr SimdKernel<Fn> kernel{{&runSse2, &runAvx2, &runAvx512}};
+    kernel.get()(peak, channels, numChannels, length);
+  }
+
+private:
+  using Fn = void (*)(SampleType*, const SampleType* const*, int, int);
+
+  static void runSse2(SampleType* peak, const SampleType* const* channels,
+                      int numChannels, int length) {
+    scan(peak, channels, numChannels, length);
+  }
+
+  UDS_TARGET_AVX2 static void runAvx2(SampleType* peak,
+                                      const SampleType* const* channels,
+                                      int numChannels, int length) {
+    scan(peak, channels, numChannels, length);
+  }
+
+  UDS_TARGET_AVX512 static void runAvx512(SampleType* peak,
+                                          const SampleType* const* channels,
+                                          int numChannels, int length) {
+    scan(peak, channels, numChannels, length);
+  }
+
+  static UDS_SIMD_INLINE void scan(SampleType* peak,
+                                   const SampleType* const* channels,
+                                   int numChannels, int length) {
+    for (int i = 0; i < length; ++i)
+      peak[i] = SampleType(0);
+    for (int ch = 0; ch < numChannels; ++ch) {
+      const SampleType* x = channels[ch];
+      for (int i = 0; i < length; ++i)
+        peak[i] = std::max(peak[i], std::abs(x[i]));
+    }
+  }
+};
+
+} // namespace uds
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "ChannelLayout.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace uds {
+
+/**
+ * @brief Fixed-cost two-head granular pitch shifter (feedback-loop shimmer)
+ *
+ * Two read heads sweep a short frame-interleaved ring half a grain apart;
+ * each head's delay ramps at (1 - ratio) frames per frame and jumps back by
+ * a grain where its crossfade gain is zero. The smoothstep crossfades of
+ * the two heads sum to one, so a steady tone keeps its level.
+ *
+ * Cost is the same every frame: one phasor step, two linear reads per
+ * channel, no FFT hops and nothing that depends on the block size. The
+ * ring is allocated in prepare() only. Both heads average half a grain of
+ * delay, which getLatencySamples() reports so the owner can shorten its
+ * loop to keep the delay time exact.
+ */
+template <typename SampleType> class PitchShifter {
+public:
+  static constexpr double kGrainSeconds = 0.04;
+
+  void prepare(double sampleRate) {
+    grainFrames_ = std::max(
+        16, static_cast<int>(std::lround(kGrainSeconds * sampleRate)));
+
+    // Reads reach one grain back plus the linear-interpolation neighbour
+    int frames = 1;
+    while (frames < grainFrames_ + 2)
+      frames <<= 1;
+    ringFrames_ = frames;
+    ring_.assign(static_cast<size_t>(ringFrames_) *
+                     static_cast<size_t>(kMaxChannels),
+                 SampleType(0));
+    reset();
+  }
+
+  void reset() {
+    std::fill(ring_.begin(), ring_.end(), SampleType(0));
+    writePos_ = 0;
+    phase_ = SampleType(0);
+  }
+
+  /** @brief Output/input frequency ratio (2 = octave up) */
+  void setRatio(double ratio) {
+    phaseIncrement_ = static_cast<SampleType>((1.0 - ratio) / grainFrames_);
+  }
+
+  /** @brief Average delay of the two heads, in frames */
+  double getLatencySamples() const { return 0.5 * grainFrames_; }
+
+  void processFrame(SampleType* frame, int numChannels) {
+    if (ring_.empty())
+      return;
+
+    SampleType* write = frameAt(writePos_);
+    for (int ch = 0; ch < numChannels; ++ch)
+      write[ch] = frame[ch];
+
+    phase_ += phaseIncrement_;
+    phase_ -= std::floor(phase_);
+
+    // Head B trails head A by half a grain; gains are complementary
+    SampleType phaseB = phase_ + SampleType(0.5);
+    if (phaseB >= SampleType(1))
+      phaseB -= SampleType(1);
+    const SampleType triangle =
+        SampleType(1) - std::abs(SampleType(2) * phase_ - SampleType(1));
+    const SampleType gainA =
+        triangle * triangle * (SampleType(3) - SampleType(2) * triangle);
+    const SampleType gainB = SampleType(1) - gainA;
+
+    Head a = makeHead(phase_, gainA);
+    Head b = makeHead(phaseB, gainB);
+    for (int ch = 0; ch < numChannels; ++ch)
+      frame[ch] = a.w0 * a.newer[ch] + a.w1 * a.older[ch] +
+                  b.w0 * b.newer[ch] + b.w1 * b.older[ch];
+
+    writePos_ = (writePos_ + 1) & (ringFrames_ - 1);
+  }
+
+private:
+  struct Head {
+    const SampleType* newer;
+    const SampleType* older;
+    SampleType w0, w1;
+  };
+
+  Head makeHead(SampleType phase, SampleType gain) {
+    const SampleType delay = phase * static_cast<SampleType>(grainFrames_);
+    const int n = static_cast<int>(delay);
+    const SampleType frac = delay - static_cast<SampleType>(n);
+    const int mask = ringFrames_ - 1;
+    return {frameAt((writePos_ - n) & mask),
+            frameAt((writePos_ - n - 1) & mask), gain * (SampleType(1) - frac),
+            gain * frac};
+  }
+
+  SampleType* frameAt(int pos) {
+    return ring_.data() +
+           static_cast<size_t>(pos) * static_cast<size_t>(kMaxChannels);
+  }
+
+  std::vector<SampleType> ring_;
+  int ringFrames_ = 0;
+  int grainFrames_ = 1764;
+  int writePos_ = 0;
+  SampleType phase_ = SampleType(0);
+  SampleType phaseIncrement_ = SampleType(0);
+};
+
+} // namespace uds
@@ -157,9 +157,20 @@ public:
           setParam("hiCut", parentHiCut);
           setParam("loCut", parentLoCut);
         }
+
+        // tapOnly bands become read heads on the parent's delay line
+        processor_.setBandTapParent(
+            band, (isTapOnly && parentBand >= 0) ? parentBand : -1);
       }
     }
 
+    // User presets saved from plugin state carry explicit tap groups
+    if (auto* tapXml = xml->getChildByName("TapGroups")) {
+      for (int band = 0; band < 8; ++band)
+        processor_.setBandTapParent(
+            band, tapXml->getIntAttribute("band" + juce::String(band), -1));
+    }
+
     // Load routing if present
     auto* routingXml = xml->getChildByName("Routing");
     if (routingXml != nullptr) {
@@ -374,7 +385,7 @@ public:
     float feedbackPct = 30.0f;
     float pan = 0.0f;
     float levelDb = 0.0f;
-    int algorithm = 0; // 0=Digital, 1=Analog, 2=Tape, 3=LoFi
+    int algorithm = 0; // 0=Digital, 1=Analog, 2=Tape, 3=LoFi, 4=Shimmer
     float hiCut = 12000.0f;
     float loCut = 80.0f;
     float lfoRate = 0.0f;
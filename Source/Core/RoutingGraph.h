@@ -3,7 +3,9 @@
 #include "../UI/NodeVisual.h"
 
 #include <algorithm>
+#include <cmath>
 #include <functional>
+#include <map>
 #include <queue>
 #include <set>
 #include <unordered_map>
@@ -13,16 +15,31 @@
 
 namespace uds {
 
+/**
+ * @brief A unit of the processing schedule
+ *
+ * Either a single node (acyclic part of the graph) or a strongly connected
+ * component (a feedback loop between bands) that must run as one unit.
+ */
+struct RoutingComponent {
+  std::vector<int> nodes; // Processing order within the component
+  bool cyclic = false;    // True for feedback loops
+};
+
 /**
  * @brief Manages routing connections between delay bands.
  *
  * Supports:
  * - Adding/removing connections
  * - Topological sorting for processing order
- * - Cycle detection for feedback protection
+ * - Feedback loops: cycles are grouped into strongly connected components;
+ *   edges that close a loop are marked as feedback edges (the processor
+ *   delays them by one sub-block)
  */
 class RoutingGraph {
 public:
+  static constexpr float kMaxConnectionGain = 4.0f; // +12 dB either polarity
+
   RoutingGraph() {
     // Initialize with bands 1-8 active by default
     for (int i = 1; i <= kNumBands; ++i) {
@@ -96,6 +113,33 @@ public:
     rebuildProcessingOrder();
   }
 
+  /**
+   * @brief Set the gain of an existing connection (negative inverts it)
+   *
+   * Clamped to +/- kMaxConnectionGain. Does not change the schedule.
+   * @return true if the connection exists
+   */
+  bool setConnectionGain(int sourceId, int destId, float gain) {
+    for (auto& conn : connections_) {
+      if (conn.sourceId == sourceId && conn.destId == destId) {
+        conn.gain = clampGain(gain);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief Gain of a connection (0 if the nodes are not connected)
+   */
+  float getConnectionGain(int sourceId, int destId) const {
+    for (const auto& conn : connections_) {
+      if (conn.sourceId == sourceId && conn.destId == destId)
+        return conn.gain;
+    }
+    return 0.0f;
+  }
+
   /**
    * @brief Clear all connections and reset to default
    */
@@ -136,14 +180,34 @@ public:
   }
 
   /**
-   * @brief Get processing order (topologically sorted)
+   * @brief Get processing order (topologically sorted, loops kept together)
    */
   const std::vector<int>& getProcessingOrder() const {
     return processingOrder_;
   }
 
+  /**
+   * @brief Get the processing schedule as components in topological order
+   */
+  const std::vector<RoutingComponent>& getComponents() const {
+    return components_;
+  }
+
+  /**
+   * @brief True if the connection closes a feedback loop
+   *
+   * Its destination runs before its source inside the loop, so the signal
+   * arrives one sub-block late.
+   */
+  bool isFeedbackEdge(int sourceId, int destId) const {
+    return feedbackEdges_.count({sourceId, destId}) > 0;
+  }
+
   /**
    * @brief Check if adding a connection would create a cycle
+   *
+   * Cycles are allowed (they become feedback loops); the editor can use this
+   * to draw feedback cables differently.
    */
   bool wouldCreateCycle(int sourceId, int destId) const {
     std::unordered_map<int, std::vector<int>> adj;
@@ -294,6 +358,8 @@ public:
       auto* connXml = xml->createNewChildElement("Connection");
       connXml->setAttribute("source", conn.sourceId);
       connXml->setAttribute("dest", conn.destId);
+      if (conn.gain != 1.0f)
+        connXml->setAttribute("gain", static_cast<double>(conn.gain));
     }
     return xml;
   }
@@ -330,6 +396,8 @@ public:
       Connection conn;
       conn.sourceId = connXml->getIntAttribute("source", 0);
       conn.destId = connXml->getIntAttribute("dest", 10);
+      conn.gain = clampGain(
+          static_cast<float>(connXml->getDoubleAttribute("gain", 1.0)));
       connections_.push_back(conn);
     }
     rebuildProcessingOrder();
@@ -346,14 +414,27 @@ public:
 private:
   std::vector<Connection> connections_;
   std::vector<int> processingOrder_;
+  std::vector<RoutingComponent> components_;
+  std::set<std::pair<int, int>> feedbackEdges_;
   std::set<int> activeBands_; // Active band IDs (1-12)
 
+  static float clampGain(float gain) {
+    if (!std::isfinite(gain))
+      return 1.0f;
+    return std::clamp(gain, -kMaxConnectionGain, kMaxConnectionGain);
+  }
+
+  /**
+   * @brief Rebuild the schedule: Tarjan SCCs, then Kahn over the
+   * condensation so acyclic parts keep their usual order
+   */
   void rebuildProcessingOrder() {
     processingOrder_.clear();
+    components_.clear();
+    feedbackEdges_.clear();
 
-    std::unordered_map<int, std::vector<int>> adj;
-    std::unordered_map<int, int> inDegree;
-    std::unordered_set<int> allNodes;
+    std::map<int, std::vector<int>> adj;
+    std::set<int> allNodes;
 
     // Collect all nodes from connections
     for (const auto& conn : connections_) {
@@ -361,32 +442,148 @@ private:
       allNodes.insert(conn.destId);
       adj[conn.sourceId].push_back(conn.destId);
     }
+    for (auto& [node, targets] : adj)
+      std::sort(targets.begin(), targets.end());
+
+    // === Tarjan's strongly connected components ===
+    std::unordered_map<int, int> index, lowLink, componentOf;
+    std::vector<int> stack;
+    std::unordered_set<int> onStack;
+    std::vector<std::vector<int>> sccs;
+    int nextIndex = 0;
+
+    std::function<void(int)> strongConnect = [&](int node) {
+      index[node] = lowLink[node] = nextIndex++;
+      stack.push_back(node);
+      onStack.insert(node);
+
+      for (int next : adj[node]) {
+        if (index.count(next) == 0) {
+          strongConnect(next);
+          lowLink[node] = std::min(lowLink[node], lowLink[next]);
+        } else if (onStack.count(next) > 0) {
+          lowLink[node] = std::min(lowLink[node], index[next]);
+        }
+      }
+
+      if (lowLink[node] == index[node]) {
+        std::vector<int> scc;
+        int member = 0;
+        do {
+          member = stack.back();
+          stack.pop_back();
+          onStack.erase(member);
+          componentOf[member] = static_cast<int>(sccs.size());
+          scc.push_back(member);
+        } while (member != node);
+        sccs.push_back(std::move(scc));
+      }
+    };
 
-    // Initialize inDegree for all nodes
     for (int node : allNodes) {
-      inDegree[node] = 0;
+      if (index.count(node) == 0)
+        strongConnect(node);
     }
 
-    // Calculate inDegree
+    // === Kahn over the condensation (component DAG) ===
+    const int numComponents = static_cast<int>(sccs.size());
+    std::vector<std::set<int>> componentAdj(static_cast<size_t>(numComponents));
+    std::vector<int> inDegree(static_cast<size_t>(numComponents), 0);
     for (const auto& conn : connections_) {
-      inDegree[conn.destId]++;
+      const int from = componentOf[conn.sourceId];
+      const int to = componentOf[conn.destId];
+      if (from != to &&
+          componentAdj[static_cast<size_t>(from)].insert(to).second)
+        ++inDegree[static_cast<size_t>(to)];
     }
 
-    std::queue<int> queue;
-    for (int node : allNodes) {
-      if (inDegree[node] == 0)
-        queue.push(node);
+    // Ready components ordered by their smallest node id (deterministic)
+    auto smallestNode = [&](int c) {
+      return *std::min_element(sccs[static_cast<size_t>(c)].begin(),
+                               sccs[static_cast<size_t>(c)].end());
+    };
+    auto later = [&](int a, int b) {
+      return smallestNode(a) > smallestNode(b);
+    };
+    std::priority_queue<int, std::vector<int>, decltype(later)> ready(later);
+    for (int c = 0; c < numComponents; ++c) {
+      if (inDegree[static_cast<size_t>(c)] == 0)
+        ready.push(c);
+    }
+
+    while (!ready.empty()) {
+      const int c = ready.top();
+      ready.pop();
+      components_.push_back(
+          buildComponent(sccs[static_cast<size_t>(c)], adj, componentOf, c));
+      for (int node : components_.back().nodes)
+        processingOrder_.push_back(node);
+      for (int next : componentAdj[static_cast<size_t>(c)]) {
+        if (--inDegree[static_cast<size_t>(next)] == 0)
+          ready.push(next);
+      }
     }
+  }
+
+  /**
+   * @brief Order a component's nodes and record its feedback edges
+   *
+   * Depth-first from the loop's entry node (the first one fed from outside
+   * the loop); reverse postorder leaves exactly the DFS back edges pointing
+   * backwards, and those become the feedback edges.
+   */
+  RoutingComponent
+  buildComponent(const std::vector<int>& members,
+                 std::map<int, std::vector<int>>& adj,
+                 std::unordered_map<int, int>& componentOf, int component) {
+    RoutingComponent result;
+    if (members.size() == 1) {
+      result.nodes = members;
+      return result;
+    }
+
+    result.cyclic = true;
+    std::set<int> memberSet(members.begin(), members.end());
+
+    // Entry: smallest member fed from outside the loop
+    int entry = -1;
+    for (const auto& conn : connections_) {
+      if (memberSet.count(conn.destId) > 0 &&
+          componentOf[conn.sourceId] != component &&
+          (entry < 0 || conn.destId < entry))
+        entry = conn.destId;
+    }
+    if (entry < 0)
+      entry = *memberSet.begin();
+
+    std::unordered_set<int> visited;
+    std::vector<int> postOrder;
+    std::function<void(int)> dfs = [&](int node) {
+      visited.insert(node);
+      for (int next : adj[node]) {
+        if (memberSet.count(next) > 0 && visited.count(next) == 0)
+          dfs(next);
+      }
+      postOrder.push_back(node);
+    };
+    dfs(entry);
+    for (int node : memberSet) {
+      if (visited.count(node) == 0)
+        dfs(node);
+    }
+
+    result.nodes.assign(postOrder.rbegin(), postOrder.rend());
 
-    while (!queue.empty()) {
-      int node = queue.front();
-      queue.pop();
-      processingOrder_.push_back(node);
-      for (int neighbor : adj[node]) {
-        if (--inDegree[neighbor] == 0)
-          queue.push(neighbor);
+    std::unordered_map<int, size_t> position;
+    for (size_t i = 0; i < result.nodes.size(); ++i)
+      position[result.nodes[i]] = i;
+    for (int node : result.nodes) {
+      for (int next : adj[node]) {
+        if (memberSet.count(next) > 0 && position[next] <= position[node])
+          feedbackEdges_.insert({node, next});
       }
     }
+    return result;
   }
 
   static bool hasCycle(const std::unordered_map<int, std::vector<int>>& adj) {
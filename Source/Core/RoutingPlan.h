@@ -0,0 +1,502 @@
+#pragma once
+
+#include "Interpolation.h"
+#include "RoutingGraph.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+namespace uds {
+
+/**
+ * @brief What the plan optimizer needs to know about one band this block
+ *
+ * Filled by DelayMatrix from the band's params (index = node id).
+ */
+struct PlanBandInfo {
+  // Output equals input and nothing is lost by not running the band:
+  // disabled, muted with an idle line (level 0, no read heads; the matrix
+  // still writes input that reaches it) or a tap child whose echo the
+  // parent produces
+  bool wire = false;
+  // Output is input + gain * input(t - delaySamples) on every channel:
+  // enabled Digital band without feedback, modulation, swell or taps
+  bool pureDelay = false;
+  double delaySamples = 0.0;
+  InterpolationType interpolation = InterpolationType::Hermite;
+};
+
+/**
+ * @brief The routing graph compiled into the schedule the matrix runs
+ *
+ * Starts as the graph exactly as drawn (RoutingGraph::getComponents()) and
+ * is rewritten by optimizer passes that leave the output unchanged:
+ *
+ * - kConstantZero: zero-gain connections are dropped; wire bands are not
+ *   processed, only summed; a wire fed by nothing but constant-zero nodes
+ *   (or by feedback edges from wires, which carry only the wet part) is
+ *   itself constant zero and is dropped with its edges.
+ * - kDeadBands: nodes that cannot reach the Output node are dropped.
+ * - kFuseDelays: a series chain of pure-delay bands (each link the only
+ *   output of one band and the only input of the next, at unity gain) runs
+ *   on the first band's line as one write and one read per term of the
+ *   product (1 + g1 z^-d1)(1 + g2 z^-d2)..., at most kMaxFused bands per
+ *   chain. The other members still record their input on their own line,
+ *   so the chain can break at any time.
+ * - kShareFanIn: nodes with identical input sets (same sources at the same
+ *   gains) share one summed buffer.
+ *
+ * compile() allocates nothing and is cheap enough to run every block. All
+ * storage is fixed-size and indexed by node id.
+ */
+class RoutingPlan {
+public:
+  enum Pass : uint32_t {
+    kConstantZero = 1u << 0,
+    kDeadBands = 1u << 1,
+    kFuseDelays = 1u << 2,
+    kShareFanIn = 1u << 3
+  };
+  static constexpr uint32_t kAllPasses =
+      kConstantZero | kDeadBands | kFuseDelays | kShareFanIn;
+
+  static constexpr int kMaxFused = 3; // 2^3 - 1 reads on one line
+  static constexpr int kMaxFusedReads = (1 << kMaxFused) - 1;
+  static constexpr int kMaxEdges = kNumNodes * kNumNodes;
+
+  /** @brief How a scheduled node is run */
+  enum class Role : uint8_t {
+    Skip,   // Not processed (absent, dead, constant zero or fused away)
+    Band,   // Sum inputs, run the band (Input/Output: as usual)
+    Wire,   // Sum inputs only
+    Fused   // Last band of a fused chain: run the chain on the head's line
+  };
+
+  struct Edge {
+    int source = 0;
+    bool feedback = false; // Read one loop sub-block late (wet part only)
+    float gain = 1.0f;     // Connection gain (negative = inverted)
+  };
+
+  struct Step {
+    int first = 0; // Into the node order (see getNode())
+    int count = 0;
+    bool cyclic = false;
+  };
+
+  /**
+   * @param bands Per node id (entries for Input/Output are ignored)
+   * @param maxFusedDelay Longest read a fused line can make, in samples
+   */
+  void compile(const RoutingGraph& routing,
+               const std::array<PlanBandInfo, kNumNodes>& bands,
+               uint32_t passes, double maxFusedDelay) {
+    constexpr int input = static_cast<int>(NodeId::Input);
+    constexpr int output = static_cast<int>(NodeId::Output);
+
+    role_.fill(Role::Skip);
+    fanInGroup_.fill(-1);
+    chainLength_.fill(0);
+    numSteps_ = 0;
+    numGroups_ = 0;
+
+    // Schedule as drawn
+    std::array<bool, kNumNodes> cyclic{};
+    int numOrdered = 0;
+    for (const auto& component : routing.getComponents()) {
+      if (numSteps_ >= kNumNodes)
+        break;
+      auto& step = steps_[static_cast<size_t>(numSteps_++)];
+      step.first = numOrdered;
+      step.count = 0;
+      step.cyclic = component.cyclic;
+      for (int nodeId : component.nodes) {
+        if (!isNode(nodeId) || numOrdered >= kNumNodes)
+          continue;
+        order_[static_cast<size_t>(numOrdered++)] = nodeId;
+        ++step.count;
+        role_[static_cast<size_t>(nodeId)] = Role::Band;
+        cyclic[static_cast<size_t>(nodeId)] = component.cyclic;
+      }
+    }
+
+    // Candidate edges between scheduled nodes
+    std::array<int, kMaxEdges> from{}, to{};
+    std::array<bool, kMaxEdges> feedback{}, live{};
+    std::array<float, kMaxEdges> gain{};
+    int numEdges = 0;
+    for (const auto& conn : routing.getConnections()) {
+      if (numEdges >= kMaxEdges || !isNode(conn.sourceId) ||
+          !isNode(conn.destId) || !scheduled(conn.sourceId) ||
+          !scheduled(conn.destId))
+        continue;
+      const auto e = static_cast<size_t>(numEdges++);
+      from[e] = conn.sourceId;
+      to[e] = conn.destId;
+      feedback[e] = routing.isFeedbackEdge(conn.sourceId, conn.destId);
+      gain[e] = conn.gain;
+      live[e] = true;
+    }
+
+    auto isBand = [](int nodeId) {
+      return nodeId != input && nodeId != output;
+    };
+
+    if ((passes & kConstantZero) != 0) {
+      for (int e = 0; e < numEdges; ++e)
+        if (gain[static_cast<size_t>(e)] == 0.0f)
+          live[static_cast<size_t>(e)] = false;
+      for (int nodeId = 0; nodeId < kNumNodes; ++nodeId) {
+        if (isBand(nodeId) && scheduled(nodeId) &&
+            bands[static_cast<size_t>(nodeId)].wire)
+          role_[static_cast<size_t>(nodeId)] = Role::Wire;
+      }
+
+      // A wire's feedback edges carry its (zero) wet part; a wire left
+      // without inputs is zero. Repeat until nothing changes.
+      for (bool changed = true; changed;) {
+        changed = false;
+        for (int e = 0; e < numEdges; ++e) {
+          const auto idx = static_cast<size_t>(e);
+          const auto src = role_[static_cast<size_t>(from[idx])];
+          if (live[idx] && (src == Role::Skip ||
+                            (feedback[idx] && src == Role::Wire))) {
+            live[idx] = false;
+            changed = true;
+          }
+        }
+        for (int nodeId = 0; nodeId < kNumNodes; ++nodeId) {
+          if (role_[static_cast<size_t>(nodeId)] != Role::Wire)
+            continue;
+          bool fed = false;
+          for (int e = 0; e < numEdges && !fed; ++e)
+            fed = live[static_cast<size_t>(e)] &&
+                  to[static_cast<size_t>(e)] == nodeId;
+          if (!fed) {
+            role_[static_cast<size_t>(nodeId)] = Role::Skip;
+            changed = true;
+          }
+        }
+      }
+      // Edges into zero nodes go nowhere
+      for (int e = 0; e < numEdges; ++e)
+        if (role_[static_cast<size_t>(to[static_cast<size_t>(e)])] ==
+            Role::Skip)
+          live[static_cast<size_t>(e)] = false;
+    }
+
+    if ((passes & kDeadBands) != 0) {
+      // Reverse reachability from the Output node
+      std::array<bool, kNumNodes> reaches{};
+      reaches[static_cast<size_t>(output)] = scheduled(output);
+      for (bool changed = true; changed;) {
+        changed = false;
+        for (int e = 0; e < numEdges; ++e) {
+          const auto idx = static_cast<size_t>(e);
+          if (live[idx] && reaches[static_cast<size_t>(to[idx])] &&
+              !reaches[static_cast<size_t>(from[idx])]) {
+            reaches[static_cast<size_t>(from[idx])] = true;
+            changed = true;
+          }
+        }
+      }
+      for (int nodeId = 0; nodeId < kNumNodes; ++nodeId) {
+        if (!reaches[static_cast<size_t>(nodeId)])
+          role_[static_cast<size_t>(nodeId)] = Role::Skip;
+      }
+      for (int e = 0; e < numEdges; ++e) {
+        const auto idx = static_cast<size_t>(e);
+        if (role_[static_cast<size_t>(from[idx])] == Role::Skip ||
+            role_[static_cast<size_t>(to[idx])] == Role::Skip)
+          live[idx] = false;
+      }
+    }
+
+    // Per-node live input and output counts, and the single link of each
+    std::array<int, kNumNodes> numIn{}, numOut{}, onlyIn{};
+    std::array<float, kNumNodes> onlyInGain{};
+    for (int e = 0; e < numEdges; ++e) {
+      const auto idx = static_cast<size_t>(e);
+      if (!live[idx])
+        continue;
+      ++numIn[static_cast<size_t>(to[idx])];
+      ++numOut[static_cast<size_t>(from[idx])];
+      onlyIn[static_cast<size_t>(to[idx])] = from[idx];
+      onlyInGain[static_cast<size_t>(to[idx])] = gain[idx];
+    }
+
+    // Fused chains take the inputs of their first band
+    std::array<int, kNumNodes> inputsFrom{};
+    inputsFrom.fill(-1);
+    if ((passes & kFuseDelays) != 0) {
+      auto fusible = [&](int nodeId) {
+        return isBand(nodeId) && !cyclic[static_cast<size_t>(nodeId)] &&
+               role_[static_cast<size_t>(nodeId)] == Role::Band &&
+               bands[static_cast<size_t>(nodeId)].pureDelay;
+      };
+      // Does b follow a directly, as the only consumer / only input, at
+      // unity gain?
+      auto linked = [&](int a, int b) {
+        const auto& infoA = bands[static_cast<size_t>(a)];
+        const auto& infoB = bands[static_cast<size_t>(b)];
+        return fusible(a) && fusible(b) &&
+               numOut[static_cast<size_t>(a)] == 1 &&
+               numIn[static_cast<size_t>(b)] == 1 &&
+               onlyIn[static_cast<size_t>(b)] == a &&
+               onlyInGain[static_cast<size_t>(b)] == 1.0f &&
+               infoA.interpolation == infoB.interpolation;
+      };
+
+      // Walk the order: a chain grows while the next scheduled node it
+      // feeds is linked (a node's only consumer is scheduled later)
+      std::array<int, kNumNodes> next{};
+      next.fill(-1);
+      for (int e = 0; e < numEdges; ++e) {
+        const auto idx = static_cast<size_t>(e);
+        if (live[idx] && linked(from[idx], to[idx]))
+          next[static_cast<size_t>(from[idx])] = to[idx];
+      }
+      std::array<bool, kNumNodes> hasPrev{};
+      for (int nodeId = 0; nodeId < kNumNodes; ++nodeId)
+        if (next[static_cast<size_t>(nodeId)] >= 0)
+          hasPrev[static_cast<size_t>(next[static_cast<size_t>(nodeId)])] =
+              true;
+
+      for (int head = 0; head < kNumNodes; ++head) {
+        if (!fusible(head) || hasPrev[static_cast<size_t>(head)])
+          continue;
+        int node = head;
+        while (node >= 0) {
+          // One segment of up to kMaxFused bands whose reads fit the line
+          std::array<int, kMaxFused> members{};
+          int length = 0;
+          double total = 0.0;
+          while (node >= 0 && length < kMaxFused &&
+                 total + bands[static_cast<size_t>(node)].delaySamples <=
+                     maxFusedDelay) {
+            total += bands[static_cast<size_t>(node)].delaySamples;
+            members[static_cast<size_t>(length++)] = node;
+            node = next[static_cast<size_t>(node)];
+          }
+          if (length == 0) {
+            node = next[static_cast<size_t>(node)];
+            continue;
+          }
+          if (length < 2)
+            continue;
+
+          const int first = members[0];
+          const int last = members[static_cast<size_t>(length - 1)];
+          for (int m = 0; m < length - 1; ++m)
+            role_[static_cast<size_t>(members[static_cast<size_t>(m)])] =
+                Role::Skip;
+          role_[static_cast<size_t>(last)] = Role::Fused;
+          chain_[static_cast<size_t>(last)] = members;
+          chainLength_[static_cast<size_t>(last)] = length;
+          inputsFrom[static_cast<size_t>(last)] = first;
+        }
+      }
+    }
+
+    // Final edges, grouped by destination in connection order
+    int numLive = 0;
+    for (int nodeId = 0; nodeId < kNumNodes; ++nodeId) {
+      inputStart_[static_cast<size_t>(nodeId)] = numLive;
+      if (role_[static_cast<size_t>(nodeId)] == Role::Skip)
+        continue;
+      const int dest = inputsFrom[static_cast<size_t>(nodeId)] >= 0
+                           ? inputsFrom[static_cast<size_t>(nodeId)]
+                           : nodeId;
+      for (int e = 0; e < numEdges; ++e) {
+        const auto idx = static_cast<size_t>(e);
+        if (!live[idx] || to[idx] != dest ||
+            role_[static_cast<size_t>(from[idx])] == Role::Skip)
+          continue;
+        auto& edge = edges_[static_cast<size_t>(numLive++)];
+        edge.source = from[idx];
+        edge.feedback = feedback[idx];
+        edge.gain = gain[idx];
+      }
+    }
+    inputStart_[static_cast<size_t>(kNumNodes)] = numLive;
+
+    // Drop skipped nodes from the schedule
+    int kept = 0;
+    for (int s = 0; s < numSteps_; ++s) {
+      auto& step = steps_[static_cast<size_t>(s)];
+      const int first = kept;
+      for (int i = step.first; i < step.first + step.count; ++i) {
+        const int nodeId = order_[static_cast<size_t>(i)];
+        if (role_[static_cast<size_t>(nodeId)] != Role::Skip)
+          order_[static_cast<size_t>(kept++)] = nodeId;
+      }
+      step.first = first;
+      step.count = kept - first;
+    }
+    int keptSteps = 0;
+    for (int s = 0; s < numSteps_; ++s) {
+      if (steps_[static_cast<size_t>(s)].count > 0)
+        steps_[static_cast<size_t>(keptSteps++)] =
+            steps_[static_cast<size_t>(s)];
+    }
+    numSteps_ = keptSteps;
+
+    if ((passes & kShareFanIn) != 0)
+      groupFanIn(cyclic);
+  }
+
+  int getNumSteps() const { return numSteps_; }
+  const Step& getStep(int index) const {
+    return steps_[static_cast<size_t>(index)];
+  }
+  int getNode(int orderIndex) const {
+    return order_[static_cast<size_t>(orderIndex)];
+  }
+
+  Role getRole(int nodeId) const { return role_[static_cast<size_t>(nodeId)]; }
+
+  int getNumInputs(int nodeId) const {
+    return inputStart_[static_cast<size_t>(nodeId) + 1] -
+           inputStart_[static_cast<size_t>(nodeId)];
+  }
+  const Edge& getInput(int nodeId, int index) const {
+    return edges_[static_cast<size_t>(
+        inputStart_[static_cast<size_t>(nodeId)] + index)];
+  }
+
+  /**
+   * @brief Bands of the chain a Fused node runs, first (line owner) first
+   */
+  int getChainLength(int nodeId) const {
+    return chainLength_[static_cast<size_t>(nodeId)];
+  }
+  int getChainBand(int nodeId, int index) const {
+    return chain_[static_cast<size_t>(nodeId)][static_cast<size_t>(index)];
+  }
+
+  /**
+   * @brief True if the node's band writes its own line this block
+   */
+  bool ownsLine(int nodeId) const {
+    const auto role = role_[static_cast<size_t>(nodeId)];
+    if (role == Role::Band)
+      return true;
+    return isFusedAway(nodeId) && chainHead(nodeId);
+  }
+
+  /**
+   * @brief Fused chain that absorbed the node (its last band), or -1
+   */
+  int getFusedInto(int nodeId) const {
+    for (int last = 0; last < kNumNodes; ++last) {
+      const int length = chainLength_[static_cast<size_t>(last)];
+      for (int m = 0; m < length; ++m)
+        if (chain_[static_cast<size_t>(last)][static_cast<size_t>(m)] ==
+            nodeId)
+          return last;
+    }
+    return -1;
+  }
+
+  /** @brief Shared fan-in group of the node (-1 = sums its own inputs) */
+  int getFanInGroup(int nodeId) const {
+    return fanInGroup_[static_cast<size_t>(nodeId)];
+  }
+  int getNumFanInGroups() const { return numGroups_; }
+
+private:
+  static bool isNode(int nodeId) { return nodeId >= 0 && nodeId < kNumNodes; }
+
+  bool scheduled(int nodeId) const {
+    return role_[static_cast<size_t>(nodeId)] != Role::Skip;
+  }
+
+  bool isFusedAway(int nodeId) const { return getFusedInto(nodeId) >= 0; }
+
+  bool chainHead(int nodeId) const {
+    const int last = getFusedInto(nodeId);
+    return last >= 0 && chain_[static_cast<size_t>(last)][0] == nodeId;
+  }
+
+  /**
+   * @brief Group acyclic nodes whose (feedback-free) inputs are the same
+   *        set of at least two sources at the same gains
+   */
+  void groupFanIn(const std::array<bool, kNumNodes>& cyclic) {
+    auto sameInputs = [&](int a, int b) {
+      const int n = getNumInputs(a);
+      if (n != getNumInputs(b))
+        return false;
+      for (int i = 0; i < n; ++i) {
+        bool found = false;
+        for (int j = 0; j < n && !found; ++j)
+          found = getInput(a, i).source == getInput(b, j).source &&
+                  getInput(a, i).gain == getInput(b, j).gain;
+        if (!found)
+          return false;
+      }
+      return true;
+    };
+    auto candidate = [&](int nodeId) {
+      if (cyclic[static_cast<size_t>(nodeId)] ||
+          nodeId == static_cast<int>(NodeId::Input) ||
+          getNumInputs(nodeId) < 2)
+        return false;
+      for (int i = 0; i < getNumInputs(nodeId); ++i)
+        if (getInput(nodeId, i).feedback)
+          return false;
+      return true;
+    };
+
+    // Sources of a group leader keep their connection order; members take
+    // the same order so the sums round identically
+    std::array<int, kNumNodes> leader{};
+    leader.fill(-1);
+    for (int i = 0; i < stepsNodeCount(); ++i) {
+      const int a = order_[static_cast<size_t>(i)];
+      if (!candidate(a) || fanInGroup_[static_cast<size_t>(a)] >= 0)
+        continue;
+      for (int j = i + 1; j < stepsNodeCount(); ++j) {
+        const int b = order_[static_cast<size_t>(j)];
+        if (!candidate(b) || fanInGroup_[static_cast<size_t>(b)] >= 0 ||
+            !sameInputs(a, b))
+          continue;
+        if (fanInGroup_[static_cast<size_t>(a)] < 0) {
+          fanInGroup_[static_cast<size_t>(a)] = numGroups_;
+          leader[static_cast<size_t>(numGroups_++)] = a;
+        }
+        fanInGroup_[static_cast<size_t>(b)] =
+            fanInGroup_[static_cast<size_t>(a)];
+        copyInputOrder(a, b);
+      }
+    }
+  }
+
+  int stepsNodeCount() const {
+    if (numSteps_ == 0)
+      return 0;
+    const auto& last = steps_[static_cast<size_t>(numSteps_ - 1)];
+    return last.first + last.count;
+  }
+
+  void copyInputOrder(int from, int to) {
+    const int n = getNumInputs(from);
+    for (int i = 0; i < n; ++i)
+      edges_[static_cast<size_t>(inputStart_[static_cast<size_t>(to)] + i)] =
+          getInput(from, i);
+  }
+
+  std::array<Step, kNumNodes> steps_{};
+  int numSteps_ = 0;
+  std::array<int, kNumNodes> order_{};
+  std::array<Role, kNumNodes> role_{};
+  std::array<int, kNumNodes + 1> inputStart_{};
+  std::array<Edge, kMaxEdges> edges_{};
+  std::array<std::array<int, kMaxFused>, kNumNodes> chain_{};
+  std::array<int, kNumNodes> chainLength_{};
+  std::array<int, kNumNodes> fanInGroup_{};
+  int numGroups_ = 0;
+};
+
+} // namespace uds
@@ -89,6 +89,7 @@ private:
     graph.clearAllConnections();
     for (const auto &conn : state) {
       graph.connect(conn.sourceId, conn.destId);
+      graph.setConnectionGain(conn.sourceId, conn.destId, conn.gain);
     }
   }
 
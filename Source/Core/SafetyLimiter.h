@@ -1,10 +1,27 @@
 #pragma once
 
+#include "ChannelLayout.h"
+#include "PeakScan.h"
+
 #include <algorithm>
+#include <array>
 #include <cmath>
 
 namespace uds {
 
+/**
+ * @brief Reason the SafetyLimiter engaged its permanent mute
+ *
+ * Lives outside the (templated) limiter so float and double processing
+ * paths report the same type to the UI.
+ */
+enum class SafetyMuteReason {
+  None,
+  SustainedPeak, // +6dBFS for 100ms
+  DCOffset,      // DC > 0.5 for 500ms
+  NaNInf         // NaN or Inf detected
+};
+
 /**
  * @brief Comprehensive audio safety system to protect equipment and hearing
  *
@@ -20,8 +37,11 @@ namespace uds {
  *
  * CRITICAL: Once permanently muted, output stays silent until manually reset.
  * This is intentional - dangerous audio conditions should require human review.
+ *
+ * Templated on sample type; thresholds stay in float, state and audio
+ * follow the processing precision.
  */
-class SafetyLimiter {
+template <typename SampleType> class SafetyLimiter {
 public:
   SafetyLimiter() = default;
 
@@ -53,43 +73,82 @@ public:
   }
 
   void reset() {
-    envelope_ = 0.0f;
-    dcBlockStateL_ = 0.0f;
-    dcBlockStateR_ = 0.0f;
-    dcBlockPrevL_ = 0.0f;
-    dcBlockPrevR_ = 0.0f;
-    sustainedLevel_ = 0.0f;
-    sustainedPeakLevel_ = 0.0f;
-    dcOffsetLevel_ = 0.0f;
+    envelope_ = 0;
+    dcBlockState_.fill(SampleType(0));
+    dcBlockPrev_.fill(SampleType(0));
+    sustainedLevel_ = 0;
+    sustainedPeakLevel_ = 0;
+    dcOffsetLevel_ = 0;
     sustainedPeakCounter_ = 0;
     dcOffsetCounter_ = 0;
-    prevOutputL_ = 0.0f;
-    prevOutputR_ = 0.0f;
+    prevOutput_.fill(SampleType(0));
     // NOTE: permanentlyMuted_ is NOT reset here - requires explicit unlock
   }
 
   /**
    * @brief Process a stereo buffer with full safety chain
    */
-  void process(float* left, float* right, int numSamples) {
+  void process(SampleType* left, SampleType* right, int numSamples) {
+    SampleType* channels[2] = {left, right};
+    process(channels, 2, numSamples);
+  }
+
+  /**
+   * @brief Process an N-channel buffer with full safety chain
+   *
+   * Detection and gain reduction are linked across all channels so the
+   * image stays put in surround beds; DC blocking and slew limiting keep
+   * per-channel state.
+   */
+  void process(SampleType* const* channels, int numChannels, int numSamples) {
+    numChannels = std::min(numChannels, kMaxChannels);
+    if (numChannels <= 0)
+      return;
+
+    const auto sustainedPeakCoeff =
+        static_cast<SampleType>(sustainedPeakCoeff_);
+    const auto dcDetectCoeff = static_cast<SampleType>(dcDetectCoeff_);
+    const auto dcBlockCoeff = static_cast<SampleType>(dcBlockCoeff_);
+    const auto attackCoeff = static_cast<SampleType>(attackCoeff_);
+    const auto releaseCoeff = static_cast<SampleType>(releaseCoeff_);
+    const auto sustainedCoeff = static_cast<SampleType>(sustainedCoeff_);
+    const auto threshold = static_cast<SampleType>(threshold_);
+    const auto sustainedThreshold =
+        static_cast<SampleType>(sustainedThreshold_);
+    const auto maxSlewRate = static_cast<SampleType>(maxSlewRate_);
+    const auto channelScale =
+        SampleType(1) / static_cast<SampleType>(numChannels);
+
+    // Per-sample peaks of the input, scanned kScanChunk samples ahead (the
+    // stages below only modify the current sample)
+    std::array<SampleType, kScanChunk> peaks;
+    std::array<const SampleType*, kMaxChannels> scan{};
+
     for (int i = 0; i < numSamples; ++i) {
+      const int slot = i & (kScanChunk - 1);
+      if (slot == 0) {
+        for (int ch = 0; ch < numChannels; ++ch)
+          scan[static_cast<size_t>(ch)] = channels[ch] + i;
+        PeakScan<SampleType>::run(peaks.data(), scan.data(), numChannels,
+                                  std::min(kScanChunk, numSamples - i));
+      }
+
       // === PERMANENT MUTE CHECK (highest priority) ===
       if (permanentlyMuted_) {
-        left[i] = 0.0f;
-        right[i] = 0.0f;
+        for (int ch = 0; ch < numChannels; ++ch)
+          channels[ch][i] = 0;
         continue;
       }
 
       // === Stage 0: Sustained Peak Detection (+6dBFS for 100ms) ===
-      float instantPeak = std::max(std::abs(left[i]), std::abs(right[i]));
+      const SampleType instantPeak = peaks[static_cast<size_t>(slot)];
 
       // Track sustained peak level (100ms window)
-      sustainedPeakLevel_ =
-          static_cast<float>(sustainedPeakCoeff_) * sustainedPeakLevel_ +
-          (1.0f - static_cast<float>(sustainedPeakCoeff_)) * instantPeak;
+      sustainedPeakLevel_ = sustainedPeakCoeff * sustainedPeakLevel_ +
+                            (SampleType(1) - sustainedPeakCoeff) * instantPeak;
 
       // +6dBFS = 2.0 linear
-      if (sustainedPeakLevel_ > dangerPeakThreshold_) {
+      if (sustainedPeakLevel_ > static_cast<SampleType>(dangerPeakThreshold_)) {
         ++sustainedPeakCounter_;
         if (sustainedPeakCounter_ >= sustainedPeakThresholdSamples_) {
           triggerPermanentMute(MuteReason::SustainedPeak);
@@ -100,23 +159,24 @@ public:
       }
 
       // === Stage 1: NaN/Inf Protection ===
-      if (!std::isfinite(left[i])) {
-        left[i] = 0.0f;
-        triggerPermanentMute(MuteReason::NaNInf);
-      }
-      if (!std::isfinite(right[i])) {
-        right[i] = 0.0f;
-        triggerPermanentMute(MuteReason::NaNInf);
+      for (int ch = 0; ch < numChannels; ++ch) {
+        if (!std::isfinite(channels[ch][i])) {
+          channels[ch][i] = 0;
+          triggerPermanentMute(MuteReason::NaNInf);
+        }
       }
 
       // === Stage 2: DC Offset Detection (>0.5 for 500ms) ===
       // Track DC offset level (500ms window) - uses raw input before DC
       // blocking
-      float dcLevel = std::abs(0.5f * (left[i] + right[i])); // Mono DC check
-      dcOffsetLevel_ = static_cast<float>(dcDetectCoeff_) * dcOffsetLevel_ +
-                       (1.0f - static_cast<float>(dcDetectCoeff_)) * dcLevel;
-
-      if (dcOffsetLevel_ > dcOffsetThreshold_) {
+      SampleType sum = 0;
+      for (int ch = 0; ch < numChannels; ++ch)
+        sum += channels[ch][i];
+      SampleType dcLevel = std::abs(sum * channelScale); // Mono DC check
+      dcOffsetLevel_ = dcDetectCoeff * dcOffsetLevel_ +
+                       (SampleType(1) - dcDetectCoeff) * dcLevel;
+
+      if (dcOffsetLevel_ > static_cast<SampleType>(dcOffsetThreshold_)) {
         ++dcOffsetCounter_;
         if (dcOffsetCounter_ >= dcOffsetThresholdSamples_) {
           triggerPermanentMute(MuteReason::DCOffset);
@@ -127,67 +187,60 @@ public:
       }
 
       // === Stage 3: DC Offset Blocking (10Hz HPF) ===
-      float dcFreeL = left[i] - dcBlockPrevL_ +
-                      static_cast<float>(dcBlockCoeff_) * dcBlockStateL_;
-      float dcFreeR = right[i] - dcBlockPrevR_ +
-                      static_cast<float>(dcBlockCoeff_) * dcBlockStateR_;
-      dcBlockPrevL_ = left[i];
-      dcBlockPrevR_ = right[i];
-      dcBlockStateL_ = dcFreeL;
-      dcBlockStateR_ = dcFreeR;
-      left[i] = dcFreeL;
-      right[i] = dcFreeR;
+      SampleType peak = 0;
+      for (int ch = 0; ch < numChannels; ++ch) {
+        const SampleType x = channels[ch][i];
+        const SampleType dcFree =
+            x - dcBlockPrev_[ch] + dcBlockCoeff * dcBlockState_[ch];
+        dcBlockPrev_[ch] = x;
+        dcBlockState_[ch] = dcFree;
+        channels[ch][i] = dcFree;
+        peak = std::max(peak, std::abs(dcFree));
+      }
 
       // === Stage 4: Soft-Knee Limiting ===
-      float peak = std::max(std::abs(left[i]), std::abs(right[i]));
-
       // Envelope follower
       if (peak > envelope_)
-        envelope_ = static_cast<float>(attackCoeff_) * envelope_ +
-                    (1.0f - static_cast<float>(attackCoeff_)) * peak;
+        envelope_ =
+            attackCoeff * envelope_ + (SampleType(1) - attackCoeff) * peak;
       else
-        envelope_ = static_cast<float>(releaseCoeff_) * envelope_ +
-                    (1.0f - static_cast<float>(releaseCoeff_)) * peak;
+        envelope_ =
+            releaseCoeff * envelope_ + (SampleType(1) - releaseCoeff) * peak;
 
       // Calculate gain reduction
-      float gain = 1.0f;
-      if (envelope_ > threshold_) {
-        float overshoot = envelope_ / threshold_;
-        gain = 1.0f / overshoot;
+      SampleType gain = 1;
+      if (envelope_ > threshold) {
+        SampleType overshoot = envelope_ / threshold;
+        gain = SampleType(1) / overshoot;
       }
 
       // Apply limiting
-      left[i] *= gain;
-      right[i] *= gain;
+      SampleType postPeak = 0;
+      for (int ch = 0; ch < numChannels; ++ch) {
+        channels[ch][i] *= gain;
+        postPeak = std::max(postPeak, std::abs(channels[ch][i]));
+      }
 
       // === Stage 5: Sustained Loudness Detection (feedback runaway) ===
-      float postPeak = std::max(std::abs(left[i]), std::abs(right[i]));
-      sustainedLevel_ = static_cast<float>(sustainedCoeff_) * sustainedLevel_ +
-                        (1.0f - static_cast<float>(sustainedCoeff_)) * postPeak;
-
-      if (sustainedLevel_ > sustainedThreshold_) {
-        float sustainGain = sustainedThreshold_ / sustainedLevel_;
-        left[i] *= sustainGain;
-        right[i] *= sustainGain;
-      }
+      sustainedLevel_ = sustainedCoeff * sustainedLevel_ +
+                        (SampleType(1) - sustainedCoeff) * postPeak;
 
-      // === Stage 6: Slew Rate Limiting (Ultrasonic Protection) ===
-      float slewL = left[i] - prevOutputL_;
-      float slewR = right[i] - prevOutputR_;
+      SampleType sustainGain = 1;
+      if (sustainedLevel_ > sustainedThreshold)
+        sustainGain = sustainedThreshold / sustainedLevel_;
 
-      if (std::abs(slewL) > maxSlewRate_) {
-        left[i] = prevOutputL_ + (slewL > 0 ? maxSlewRate_ : -maxSlewRate_);
-      }
-      if (std::abs(slewR) > maxSlewRate_) {
-        right[i] = prevOutputR_ + (slewR > 0 ? maxSlewRate_ : -maxSlewRate_);
-      }
+      for (int ch = 0; ch < numChannels; ++ch) {
+        SampleType x = channels[ch][i] * sustainGain;
 
-      prevOutputL_ = left[i];
-      prevOutputR_ = right[i];
+        // === Stage 6: Slew Rate Limiting (Ultrasonic Protection) ===
+        const SampleType slew = x - prevOutput_[ch];
+        if (std::abs(slew) > maxSlewRate)
+          x = prevOutput_[ch] + (slew > 0 ? maxSlewRate : -maxSlewRate);
+        prevOutput_[ch] = x;
 
-      // === Stage 7: Hard Clip (Final Safety Net) ===
-      left[i] = std::clamp(left[i], -1.0f, 1.0f);
-      right[i] = std::clamp(right[i], -1.0f, 1.0f);
+        // === Stage 7: Hard Clip (Final Safety Net) ===
+        channels[ch][i] = std::clamp(x, SampleType(-1), SampleType(1));
+      }
     }
   }
 
@@ -201,12 +254,7 @@ public:
 
   // ==================== PERMANENT MUTE CONTROL ====================
 
-  enum class MuteReason {
-    None,
-    SustainedPeak, // +6dBFS for 100ms
-    DCOffset,      // DC > 0.5 for 500ms
-    NaNInf         // NaN or Inf detected
-  };
+  using MuteReason = SafetyMuteReason;
 
   /**
    * @brief Check if output is permanently muted
@@ -227,14 +275,14 @@ public:
     muteReason_ = MuteReason::None;
     sustainedPeakCounter_ = 0;
     dcOffsetCounter_ = 0;
-    sustainedPeakLevel_ = 0.0f;
-    dcOffsetLevel_ = 0.0f;
+    sustainedPeakLevel_ = 0;
+    dcOffsetLevel_ = 0;
   }
 
   /**
    * @brief Get current envelope level (for metering)
    */
-  float getEnvelopeLevel() const { return envelope_; }
+  float getEnvelopeLevel() const { return static_cast<float>(envelope_); }
 
   /**
    * @brief Get count of danger events (for diagnostics)
@@ -244,6 +292,8 @@ public:
   void resetDangerEventCount() { dangerEventCount_ = 0; }
 
 private:
+  static constexpr int kScanChunk = 64; // Power of two
+
   void triggerPermanentMute(MuteReason reason) {
     permanentlyMuted_ = true;
     muteReason_ = reason;
@@ -254,31 +304,29 @@ private:
   // Limiter coefficients
   double attackCoeff_ = 0.0;
   double releaseCoeff_ = 0.0;
-  float envelope_ = 0.0f;
+  SampleType envelope_ = 0;
   float threshold_ = 0.9f; // ~-1dB default
 
   // DC blocker state (10Hz HPF)
   double dcBlockCoeff_ = 0.999;
-  float dcBlockStateL_ = 0.0f;
-  float dcBlockStateR_ = 0.0f;
-  float dcBlockPrevL_ = 0.0f;
-  float dcBlockPrevR_ = 0.0f;
+  std::array<SampleType, kMaxChannels> dcBlockState_{};
+  std::array<SampleType, kMaxChannels> dcBlockPrev_{};
 
   // Sustained loudness detection
   double sustainedCoeff_ = 0.0;
-  float sustainedLevel_ = 0.0f;
+  SampleType sustainedLevel_ = 0;
   float sustainedThreshold_ = 0.7f; // ~-3dB
 
   // Sustained peak detection (+6dBFS for 100ms)
   double sustainedPeakCoeff_ = 0.0;
-  float sustainedPeakLevel_ = 0.0f;
+  SampleType sustainedPeakLevel_ = 0;
   float dangerPeakThreshold_ = 2.0f; // +6dBFS
   int sustainedPeakCounter_ = 0;
   int sustainedPeakThresholdSamples_ = 4410; // 100ms @ 44.1kHz
 
   // DC offset detection (>0.5 for 500ms)
   double dcDetectCoeff_ = 0.0;
-  float dcOffsetLevel_ = 0.0f;
+  SampleType dcOffsetLevel_ = 0;
   float dcOffsetThreshold_ = 0.5f;
   int dcOffsetCounter_ = 0;
   int dcOffsetThresholdSamples_ = 22050; // 500ms @ 44.1kHz
@@ -290,8 +338,7 @@ private:
 
   // Slew rate limiting
   float maxSlewRate_ = 0.5f;
-  float prevOutputL_ = 0.0f;
-  float prevOutputR_ = 0.0f;
+  std::array<SampleType, kMaxChannels> prevOutput_{};
 };
 
 } // namespace uds
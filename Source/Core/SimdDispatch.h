@@ -0,0 +1,117 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include <array>
+#include <atomic>
+
+// Per-function instruction-set targets. With GCC/Clang on x86 each kernel
+// is compiled once per tier from the same source; elsewhere (MSVC, ARM)
+// the tiers share the baseline build and only Sse2 is reported.
+#if (defined(__GNUC__) || defined(__clang__)) &&                              \
+    (defined(__x86_64__) || defined(__i386__))
+#define UDS_SIMD_TARGETS 1
+#define UDS_SIMD_INLINE inline __attribute__((always_inline))
+#define UDS_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define UDS_TARGET_AVX512                                                      \
+  __attribute__((target("avx512f,avx512vl,avx2,fma")))
+#else
+#define UDS_SIMD_TARGETS 0
+#define UDS_SIMD_INLINE inline
+#define UDS_TARGET_AVX2
+#define UDS_TARGET_AVX512
+#endif
+
+namespace uds {
+
+/**
+ * @brief Instruction-set tiers the block kernels are built for
+ *
+ * Sse2 is the baseline build (SSE2 on x86-64, the compiler's default on
+ * other targets). Avx2 and Avx512 also use FMA, so the compiler may fuse
+ * multiply-adds: results agree with Sse2 to within rounding, not bit for
+ * bit.
+ */
+enum class SimdTier { Sse2, Avx2, Avx512 };
+
+/**
+ * @brief Picks the kernel tier once at startup, with a forced mode for
+ *        tests and benchmarks
+ *
+ * The CPU is queried (juce::SystemStats) on first use. forceTier() runs
+ * a lower tier on the same machine so every tier can be checked against
+ * the others; it refuses tiers this CPU or build cannot run. Reading the
+ * tier is one relaxed atomic load.
+ */
+struct SimdDispatch {
+  static constexpr int kNumTiers = 3;
+
+  /** @brief Best tier this CPU supports and this build has code for */
+  static SimdTier getSupportedTier() {
+    static const SimdTier supported = detect();
+    return supported;
+  }
+
+  /** @brief Tier the kernels currently run */
+  static SimdTier getTier() {
+    const int forced = forcedTier().load(std::memory_order_relaxed);
+    return forced >= 0 ? static_cast<SimdTier>(forced) : getSupportedTier();
+  }
+
+  /**
+   * @brief Run tier instead of the detected one
+   * @return false (and no change) if the CPU or build cannot run it
+   */
+  static bool forceTier(SimdTier tier) {
+    if (static_cast<int>(tier) > static_cast<int>(getSupportedTier()))
+      return false;
+    forcedTier().store(static_cast<int>(tier), std::memory_order_relaxed);
+    return true;
+  }
+
+  /** @brief Go back to the detected tier */
+  static void clearForcedTier() {
+    forcedTier().store(-1, std::memory_order_relaxed);
+  }
+
+  static const char* getTierName(SimdTier tier) {
+    switch (tier) {
+    case SimdTier::Avx2:
+      return "AVX2";
+    case SimdTier::Avx512:
+      return "AVX-512";
+    default:
+      return "SSE2";
+    }
+  }
+
+private:
+  static SimdTier detect() {
+#if UDS_SIMD_TARGETS
+    if (juce::SystemStats::hasAVX512F() && juce::SystemStats::hasAVX512VL() &&
+        juce::SystemStats::hasFMA3())
+      return SimdTier::Avx512;
+    if (juce::SystemStats::hasAVX2() && juce::SystemStats::hasFMA3())
+      return SimdTier::Avx2;
+#endif
+    return SimdTier::Sse2;
+  }
+
+  static std::atomic<int>& forcedTier() {
+    static std::atomic<int> forced{-1};
+    return forced;
+  }
+};
+
+/**
+ * @brief One entry point per tier for a kernel with signature Fn
+ */
+template <typename Fn> struct SimdKernel {
+  std::array<Fn, SimdDispatch::kNumTiers> tiers;
+
+  Fn get() const {
+    return tiers[static_cast<size_t>(SimdDispatch::getTier())];
+  }
+};
+
+} // namespace uds
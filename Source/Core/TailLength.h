@@ -0,0 +1,168 @@
+#pragma once
+
+#include "DelayBandNode.h"
+#include "RoutingGraph.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace uds {
+
+/**
+ * @brief How long the matrix keeps sounding after its input stops
+ *
+ * A band rings until its echoes (level * feedback^n) fall below kFloorGain.
+ * Bands in series add their ring times, so the tail is the longest such
+ * sum over any Input -> Output path through the routing schedule. A
+ * feedback loop between bands repeats its members' ring times until the
+ * loop's worst-case gain (its bands' and connections') has decayed as
+ * well; a loop (or band) that does not decay gives an infinite tail. A
+ * band passes its input through along with its echoes, so only a member
+ * driving a feedback edge (which carries the wet part alone) can take
+ * the loop gain below one.
+ * Zero-gain connections carry nothing.
+ *
+ * Allocation-free; cheap enough to run every block.
+ */
+struct TailLength {
+  static constexpr double kFloorGain = 1.0e-4; // -80 dB
+  static constexpr double kModulationReachMs = 50.0; // See isIdle()
+
+  static double infinite() { return std::numeric_limits<double>::infinity(); }
+
+  /**
+   * @brief Ring time of one band after its input stops (0 = pass-through)
+   */
+  static double bandSeconds(const DelayBandParams& params) {
+    if (!params.enabled)
+      return 0.0;
+    const double level = std::abs(params.level);
+    if (level <= kFloorGain)
+      return 0.0;
+
+    double delayMs = params.delayTimeMs;
+    if (params.lfoDepth > 0.0f)
+      delayMs += kModulationReachMs;
+    const double delay = std::max(delayMs, 0.0) * 0.001;
+
+    const double feedback = std::abs(params.feedback);
+    if (feedback >= 1.0)
+      return infinite();
+    if (feedback <= 0.0)
+      return delay;
+
+    // Echo n (1-based) has gain level * feedback^(n - 1)
+    const double echoes =
+        1.0 + std::ceil(std::log(kFloorGain / level) / std::log(feedback));
+    return delay * std::max(echoes, 1.0);
+  }
+
+  /**
+   * @brief Upper bound on a band's wet gain summed over all its echoes
+   *        (0 for a disabled band, which only passes its input through)
+   */
+  static double wetGain(const DelayBandParams& params) {
+    if (!params.enabled)
+      return 0.0;
+    const double feedback = std::abs(params.feedback);
+    if (feedback >= 1.0)
+      return infinite();
+    return std::abs(params.level) / (1.0 - feedback);
+  }
+
+  /**
+   * @brief Tail of the whole matrix, in seconds (may be infinite)
+   * @param bands Parameters of band nodes 1..N (index = node - 1)
+   */
+  template <size_t NumBands>
+  static double matrixSeconds(const std::array<DelayBandParams, NumBands>& bands,
+                              const RoutingGraph& routing) {
+    constexpr int input = static_cast<int>(NodeId::Input);
+    constexpr int output = static_cast<int>(NodeId::Output);
+
+    // Latest time (after the input stops) each node can still be sounding;
+    // negative = not fed from the input
+    std::array<double, kNumNodes> nodeTail{};
+    nodeTail.fill(-1.0);
+    nodeTail[static_cast<size_t>(input)] = 0.0;
+
+    auto ringOf = [&](int nodeId) {
+      const int band = nodeId - 1;
+      if (band < 0 || band >= static_cast<int>(NumBands))
+        return 0.0;
+      return bandSeconds(bands[static_cast<size_t>(band)]);
+    };
+    auto wetOf = [&](int nodeId) {
+      const int band = nodeId - 1;
+      if (band < 0 || band >= static_cast<int>(NumBands))
+        return 0.0;
+      return wetGain(bands[static_cast<size_t>(band)]);
+    };
+
+    std::array<bool, kNumNodes> inComponent{};
+    for (const auto& component : routing.getComponents()) {
+      inComponent.fill(false);
+      for (int nodeId : component.nodes)
+        if (nodeId >= 0 && nodeId < kNumNodes)
+          inComponent[static_cast<size_t>(nodeId)] = true;
+
+      // Latest arrival from outside the component
+      double entry = -1.0;
+      for (const auto& conn : routing.getConnections()) {
+        if (conn.destId < 0 || conn.destId >= kNumNodes ||
+            conn.sourceId < 0 || conn.sourceId >= kNumNodes ||
+            conn.gain == 0.0f)
+          continue;
+        if (inComponent[static_cast<size_t>(conn.destId)] &&
+            !inComponent[static_cast<size_t>(conn.sourceId)])
+          entry = std::max(entry, nodeTail[static_cast<size_t>(conn.sourceId)]);
+      }
+      if (entry < 0.0)
+        continue; // Unreachable from the input
+
+      if (!component.cyclic) {
+        for (int nodeId : component.nodes)
+          nodeTail[static_cast<size_t>(nodeId)] = entry + ringOf(nodeId);
+        continue;
+      }
+
+      // Each trip round the loop can extend the tail by every member's ring
+      // time, and must be repeated until the loop gain has decayed. A
+      // member passes on its input plus its echoes (1 + wet), or only its
+      // echoes over a feedback edge; take its loudest connection back into
+      // the loop.
+      double round = 0.0;
+      double loopGain = 1.0;
+      for (int nodeId : component.nodes) {
+        round += ringOf(nodeId);
+        const double wet = wetOf(nodeId);
+        double memberGain = 0.0;
+        for (const auto& conn : routing.getConnections()) {
+          if (conn.sourceId != nodeId || conn.gain == 0.0f || conn.destId < 0 ||
+              conn.destId >= kNumNodes ||
+              !inComponent[static_cast<size_t>(conn.destId)])
+            continue;
+          const double through =
+              routing.isFeedbackEdge(conn.sourceId, conn.destId) ? wet
+                                                                 : 1.0 + wet;
+          memberGain = std::max(
+              memberGain, std::abs(static_cast<double>(conn.gain)) * through);
+        }
+        loopGain *= memberGain;
+      }
+      double tail = entry + round;
+      if (loopGain >= 1.0)
+        tail = infinite();
+      else if (loopGain > 0.0)
+        tail += round * std::ceil(std::log(kFloorGain) / std::log(loopGain));
+      for (int nodeId : component.nodes)
+        nodeTail[static_cast<size_t>(nodeId)] = tail;
+    }
+
+    return std::max(nodeTail[static_cast<size_t>(output)], 0.0);
+  }
+};
+
+} // namespace uds
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace uds {
+
+/**
+ * @brief Small fork/join pool for running independent bands in parallel
+ *
+ * Only used for offline rendering: workers sleep on a condition variable
+ * and the caller yields while it waits, neither of which is real-time
+ * safe. start()/stop() create and join the threads (message thread, or
+ * with processing suspended); run() allocates nothing.
+ */
+class WorkerPool {
+public:
+  WorkerPool() = default;
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+  ~WorkerPool() { stop(); }
+
+  /**
+   * @brief Spawn helper threads (0 = run everything on the caller)
+   */
+  void start(int numWorkers) {
+    stop();
+    stopping_ = false;
+    for (int i = 0; i < numWorkers; ++i)
+      workers_.emplace_back([this] { workerLoop(); });
+  }
+
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_)
+      worker.join();
+    workers_.clear();
+  }
+
+  int getNumWorkers() const { return static_cast<int>(workers_.size()); }
+
+  /**
+   * @brief Call fn(i) for every i in [0, numTasks); returns when all are done
+   *
+   * The caller takes tasks too. fn must be safe to call concurrently for
+   * different i.
+   */
+  template <typename Fn> void run(int numTasks, Fn& fn) {
+    if (workers_.empty() || numTasks < 2) {
+      for (int i = 0; i < numTasks; ++i)
+        fn(i);
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      job_ = [](void* context, int task) {
+        (*static_cast<Fn*>(context))(task);
+      };
+      context_ = &fn;
+      numTasks_ = numTasks;
+      next_.store(0);
+      done_.store(0);
+      ++generation_;
+    }
+    wake_.notify_all();
+
+    runTasks(job_, context_, numTasks);
+    while (done_.load(std::memory_order_acquire) < numTasks ||
+           busy_.load(std::memory_order_acquire) > 0)
+      std::this_thread::yield();
+  }
+
+private:
+  using Job = void (*)(void*, int);
+
+  void runTasks(Job job, void* context, int numTasks) {
+    for (int task = next_.fetch_add(1); task < numTasks;
+         task = next_.fetch_add(1)) {
+      job(context, task);
+      done_.fetch_add(1, std::memory_order_release);
+    }
+  }
+
+  void workerLoop() {
+    unsigned seen = 0;
+    for (;;) {
+      Job job = nullptr;
+      void* context = nullptr;
+      int numTasks = 0;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+        if (stopping_)
+          return;
+        seen = generation_;
+        // A job that is already fully claimed may be finished and its
+        // context gone: skip it
+        if (next_.load() >= numTasks_)
+          continue;
+        job = job_;
+        context = context_;
+        numTasks = numTasks_;
+        busy_.fetch_add(1);
+      }
+      runTasks(job, context, numTasks);
+      busy_.fetch_sub(1, std::memory_order_release);
+    }
+  }
+
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  bool stopping_ = false;
+  unsigned generation_ = 0;
+
+  Job job_ = nullptr;
+  void* context_ = nullptr;
+  int numTasks_ = 0;
+  std::atomic<int> next_{0};
+  std::atomic<int> done_{0};
+  std::atomic<int> busy_{0};
+};
+
+} // namespace uds
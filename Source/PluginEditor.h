@@ -79,6 +79,11 @@ private:
         levels[static_cast<size_t>(i)] = processorRef_.getBandLevel(i);
       }
       mainComponent_->updateBandLevels(levels);
+
+      mainComponent_->updateQualityStatus(processorRef_.getQualityLevel(),
+                                          processorRef_.getQualityReason(),
+                                          processorRef_.getCpuLoad(),
+                                          processorRef_.isOutputSilent());
     }
 
     // Check for safety mute status
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Core/CpuGovernor.h"
 #include "Core/DelayMatrix.h"
 #include "Core/RoutingGraph.h"
 
@@ -25,7 +26,7 @@ struct ExpressionMapping {
  *
  * 8-band configurable delay matrix inspired by the Yamaha UD Stomp.
  */
-class UDSAudioProcessor : public juce::AudioProcessor {
+class UDSAudioProcessor : public juce::AudioProcessor, private juce::Timer {
 public:
   UDSAudioProcessor()
       : AudioProcessor(
@@ -36,34 +37,57 @@ public:
                     createParameterLayout()) {
     // Initialize with default parallel routing
     routingGraph_.setDefaultParallelRouting();
+
+    // Delay lines are pre-faulted; locking them in RAM is opt-in
+    // (lockDelayMemory)
+    memoryOptions_.lock = isLockMemoryParameterOn();
+    delayMatrixFloat_.setMemoryOptions(memoryOptions_);
+    delayMatrixDouble_.setMemoryOptions(memoryOptions_);
+
+    // Shared delay-memory residency runs on the message thread
+    startTimerHz(10);
   }
 
-  ~UDSAudioProcessor() override = default;
+  ~UDSAudioProcessor() override { stopTimer(); }
 
   void prepareToPlay(double sampleRate, int samplesPerBlock) override {
-    delayMatrix_.prepare(sampleRate, static_cast<size_t>(samplesPerBlock));
+    preparedSampleRate_ = sampleRate;
+    preparedBlockSize_ = samplesPerBlock;
+    prepareMatrix();
+    cpuGovernor_.prepare(sampleRate);
+  }
+
+  /**
+   * @brief Offline renders switch to the most expensive settings
+   *
+   * Hosts call this outside processBlock; processing is suspended anyway
+   * while the worker threads and oversampling state are set up.
+   */
+  void setNonRealtime(bool isNonRealtime) noexcept override {
+    juce::AudioProcessor::setNonRealtime(isNonRealtime);
+    const ScopedSuspend suspend(*this);
+    applyOfflineQuality(isNonRealtime);
+  }
+
+  void releaseResources() override {
+    delayMatrixFloat_.reset();
+    delayMatrixDouble_.reset();
   }
 
-  void releaseResources() override { delayMatrix_.reset(); }
+  bool supportsDoublePrecisionProcessing() const override { return true; }
 
   bool isBusesLayoutSupported(const BusesLayout& layouts) const override {
     const auto& mainOutput = layouts.getMainOutputChannelSet();
     const auto& mainInput = layouts.getMainInputChannelSet();
 
-    // 1. Output must be Stereo or Mono
-    if (mainOutput != juce::AudioChannelSet::stereo() &&
-        mainOutput != juce::AudioChannelSet::mono())
+    // 1. Output may be any layout up to kMaxChannels (mono, stereo, quad,
+    // 5.1, 7.1.4, ...)
+    if (mainOutput.size() < 1 || mainOutput.size() > uds::kMaxChannels)
       return false;
 
-    // 2. Input must be Stereo or Mono
-    if (mainInput != juce::AudioChannelSet::stereo() &&
-        mainInput != juce::AudioChannelSet::mono())
-      return false;
-
-    // 3. We allow Mono->Stereo, Stereo->Stereo, Mono->Mono.
-    // We do NOT allow Stereo Input -> Mono Output (downmixing not supported
-    // yet)
-    if (mainInput.size() > mainOutput.size())
+    // 2. Input must be Mono (upmixed to every output channel) or match the
+    // output layout. We do NOT allow downmixing (e.g. Stereo -> Mono).
+    if (mainInput.size() != 1 && mainInput != mainOutput)
       return false;
 
     return true;
@@ -71,12 +95,528 @@ public:
 
   void processBlock(juce::AudioBuffer<float>& buffer,
                     juce::MidiBuffer& midiMessages) override {
+    if (isBypassParameterOn())
+      processBypassedInternal(buffer, delayMatrixFloat_);
+    else
+      processBlockInternal(buffer, midiMessages, delayMatrixFloat_);
+  }
+
+  void processBlock(juce::AudioBuffer<double>& buffer,
+                    juce::MidiBuffer& midiMessages) override {
+    if (isBypassParameterOn())
+      processBypassedInternal(buffer, delayMatrixDouble_);
+    else
+      processBlockInternal(buffer, midiMessages, delayMatrixDouble_);
+  }
+
+  // Hosts that bypass without the parameter call these instead
+  void processBlockBypassed(juce::AudioBuffer<float>& buffer,
+                            juce::MidiBuffer&) override {
+    processBypassedInternal(buffer, delayMatrixFloat_);
+  }
+
+  void processBlockBypassed(juce::AudioBuffer<double>& buffer,
+                            juce::MidiBuffer&) override {
+    processBypassedInternal(buffer, delayMatrixDouble_);
+  }
+
+  juce::AudioProcessorParameter* getBypassParameter() const override {
+    return parameters_.getParameter("bypass");
+  }
+
+  juce::AudioProcessorEditor* createEditor() override;
+  bool hasEditor() const override { return true; }
+
+  const juce::String getName() const override { return JucePlugin_Name; }
+  bool acceptsMidi() const override { return true; }
+  bool producesMidi() const override { return false; }
+  bool isMidiEffect() const override { return false; }
+  /**
+   * @brief Longest decay path through the current routing (see
+   *        TailLength.h); infinite for self-sustaining feedback
+   */
+  double getTailLengthSeconds() const override {
+    return isUsingDoublePrecision()
+               ? delayMatrixDouble_.getTailLengthSeconds()
+               : delayMatrixFloat_.getTailLengthSeconds();
+  }
+
+  /**
+   * @brief True while the input is silent and every tail has rung out
+   *        (the matrix is skipped; polled by the editor)
+   */
+  bool isOutputSilent() const {
+    return isUsingDoublePrecision() ? delayMatrixDouble_.isSilent()
+                                    : delayMatrixFloat_.isSilent();
+  }
+
+  int getNumPrograms() override { return 1; }
+  int getCurrentProgram() override { return 0; }
+  void setCurrentProgram(int) override {}
+  const juce::String getProgramName(int) override { return {}; }
+  void changeProgramName(int, const juce::String&) override {}
+
+  void getStateInformation(juce::MemoryBlock& destData) override {
+    // Create root XML element
+    auto xml = std::make_unique<juce::XmlElement>("UDSState");
+
+    // Add APVTS parameters
+    auto state = parameters_.copyState();
+    xml->addChildElement(state.createXml().release());
+
+    // Add routing graph
+    xml->addChildElement(routingGraph_.toXml().release());
+
+    // Add per-band channel routing (bitmask of bus channels per band)
+    auto* channelRouting = new juce::XmlElement("ChannelRouting");
+    for (int band = 0; band < 8; ++band)
+      channelRouting->setAttribute("band" + juce::String(band),
+                                   static_cast<int>(getBandChannelMask(band)));
+    xml->addChildElement(channelRouting);
+
+    // Add multi-tap groups (parent band per band, -1 = own delay line)
+    auto* tapGroups = new juce::XmlElement("TapGroups");
+    for (int band = 0; band < 8; ++band)
+      tapGroups->setAttribute("band" + juce::String(band),
+                              getBandTapParent(band));
+    xml->addChildElement(tapGroups);
+
+    copyXmlToBinary(*xml, destData);
+  }
+
+  void setStateInformation(const void* data, int sizeInBytes) override {
+    std::unique_ptr<juce::XmlElement> xmlState(
+        getXmlFromBinary(data, sizeInBytes));
+
+    if (xmlState == nullptr)
+      return;
+
+    // Handle both old format (just APVTS) and new format (UDSState wrapper)
+    if (xmlState->hasTagName("UDSState")) {
+      // New format: extract APVTS and routing separately
+      if (auto* apvtsXml =
+              xmlState->getChildByName(parameters_.state.getType())) {
+        parameters_.replaceState(juce::ValueTree::fromXml(*apvtsXml));
+      }
+      if (auto* routingXml = xmlState->getChildByName("Routing")) {
+        routingGraph_.fromXml(routingXml);
+      }
+      if (auto* channelXml = xmlState->getChildByName("ChannelRouting")) {
+        for (int band = 0; band < 8; ++band)
+          setBandChannelMask(band,
+                             static_cast<uint32_t>(channelXml->getIntAttribute(
+                                 "band" + juce::String(band),
+                                 static_cast<int>(uds::kAllChannels))));
+      }
+      if (auto* tapXml = xmlState->getChildByName("TapGroups")) {
+        for (int band = 0; band < 8; ++band)
+          setBandTapParent(band, tapXml->getIntAttribute(
+                                     "band" + juce::String(band), -1));
+      }
+    } else if (xmlState->hasTagName(parameters_.state.getType())) {
+      // Old format: just APVTS state (backwards compatibility)
+      parameters_.replaceState(juce::ValueTree::fromXml(*xmlState));
+    }
+  }
+
+  juce::AudioProcessorValueTreeState& getParameters() { return parameters_; }
+
+  // Access to routing graph for editor
+  uds::RoutingGraph& getRoutingGraph() { return routingGraph_; }
+  const uds::RoutingGraph& getRoutingGraph() const { return routingGraph_; }
+
+  // Per-band channel routing (bit n = bus channel n; default all channels)
+  void setBandChannelMask(int band, uint32_t mask) {
+    if (band >= 0 && band < 8)
+      bandChannelMasks_[static_cast<size_t>(band)].store(mask);
+  }
+  uint32_t getBandChannelMask(int band) const {
+    if (band >= 0 && band < 8)
+      return bandChannelMasks_[static_cast<size_t>(band)].load();
+    return uds::kAllChannels;
+  }
+
+  // Multi-tap groups: band reads from parent band's line (-1 = own line)
+  void setBandTapParent(int band, int parentBand) {
+    if (band >= 0 && band < 8)
+      bandTapParents_[static_cast<size_t>(band)].store(parentBand);
+  }
+  int getBandTapParent(int band) const {
+    if (band >= 0 && band < 8)
+      return bandTapParents_[static_cast<size_t>(band)].load();
+    return -1;
+  }
+
+  // Internal metronome BPM for standalone mode
+  void setInternalBpm(double bpm) { internalBpm_.store(bpm); }
+  double getInternalBpm() const { return internalBpm_.load(); }
+
+  // Per-band output levels for activity indicators
+  float getBandLevel(int band) const {
+    if (band >= 0 && band < 8)
+      return bandLevels_[band].load();
+    return 0.0f;
+  }
+
+  // Safety mute status for UI
+  bool isSafetyMuted() const {
+    return isUsingDoublePrecision() ? delayMatrixDouble_.isSafetyMuted()
+                                    : delayMatrixFloat_.isSafetyMuted();
+  }
+  int getSafetyMuteReason() const {
+    return static_cast<int>(isUsingDoublePrecision()
+                                ? delayMatrixDouble_.getSafetyMuteReason()
+                                : delayMatrixFloat_.getSafetyMuteReason());
+  }
+  void unlockSafetyMute() {
+    delayMatrixFloat_.unlockSafetyMute();
+    delayMatrixDouble_.unlockSafetyMute();
+  }
+
+  // Adaptive quality status for UI (uds::QualityLevel / uds::QualityReason)
+  int getQualityLevel() const {
+    return static_cast<int>(cpuGovernor_.getLevel());
+  }
+  int getQualityReason() const {
+    return static_cast<int>(cpuGovernor_.getReason());
+  }
+  float getCpuLoad() const { return cpuGovernor_.getLoad(); }
+
+  // Delay-line memory diagnostics (bytes, pre-faulted, locked, huge pages)
+  uds::DelayMemoryStatus getDelayMemoryStatus() const {
+    return delayMatrixDouble_.isPrepared()
+               ? delayMatrixDouble_.getMemoryStatus()
+               : delayMatrixFloat_.getMemoryStatus();
+  }
+
+  // Process-wide shared arena usage (all zero while sharing is off)
+  uds::DelayArena::Stats getDelayArenaStats() const {
+    return delayArena_ ? delayArena_->getStats() : uds::DelayArena::Stats{};
+  }
+
+  // Accessors for preset management
+  juce::AudioProcessorValueTreeState& getAPVTS() { return parameters_; }
+
+  // Expression pedal mapping API
+  void setExpressionMapping(const juce::String& paramId, float minVal,
+                            float maxVal) {
+    std::lock_guard<std::mutex> lock(expressionMutex_);
+    expressionMapping_ = ExpressionMapping{paramId, minVal, maxVal, false};
+  }
+  void clearExpressionMapping() {
+    std::lock_guard<std::mutex> lock(expressionMutex_);
+    expressionMapping_.reset();
+  }
+  std::optional<ExpressionMapping> getExpressionMapping() const {
+    std::lock_guard<std::mutex> lock(expressionMutex_);
+    return expressionMapping_;
+  }
+  bool hasExpressionMapping(const juce::String& paramId) const {
+    std::lock_guard<std::mutex> lock(expressionMutex_);
+    return expressionMapping_.has_value() &&
+           expressionMapping_->paramId == paramId;
+  }
+  float getExpressionValue() const { return expressionValue_.load(); }
+
+private:
+  /**
+   * @brief Suspends processing while set-up runs outside processBlock
+   *
+   * Guards may overlap (e.g. setNonRealtime() on a host thread while the
+   * timer rebuilds the matrix). Only the last one out resumes, and only if
+   * processing was running when the first one came in, so a suspension
+   * held by the host or anyone else is left alone.
+   */
+  class ScopedSuspend {
+  public:
+    explicit ScopedSuspend(UDSAudioProcessor& processor)
+        : processor_(processor) {
+      const std::lock_guard<std::mutex> lock(processor_.suspendMutex_);
+      if (processor_.suspendDepth_++ == 0) {
+        processor_.resumeAfterSetup_ = !processor_.isSuspended();
+        processor_.suspendProcessing(true);
+      }
+    }
+
+    ~ScopedSuspend() {
+      const std::lock_guard<std::mutex> lock(processor_.suspendMutex_);
+      if (--processor_.suspendDepth_ == 0 && processor_.resumeAfterSetup_)
+        processor_.suspendProcessing(false);
+    }
+
+    ScopedSuspend(const ScopedSuspend&) = delete;
+    ScopedSuspend& operator=(const ScopedSuspend&) = delete;
+
+  private:
+    UDSAudioProcessor& processor_;
+  };
+
+  void applyOfflineQuality(bool offline) {
+    offlineQuality_.store(offline, std::memory_order_relaxed);
+    if (isUsingDoublePrecision())
+      delayMatrixDouble_.setOfflineQuality(offline);
+    else
+      delayMatrixFloat_.setOfflineQuality(offline);
+  }
+
+  juce::AudioProcessorValueTreeState parameters_;
+  uds::DelayMatrix<float> delayMatrixFloat_;
+  uds::DelayMatrix<double> delayMatrixDouble_;
+  uds::RoutingGraph routingGraph_;
+  uds::CpuGovernor cpuGovernor_;
+  std::atomic<bool> offlineQuality_{false};
+  bool hardBypassed_ = false; // Audio thread only
+  double preparedSampleRate_ = 44100.0;
+  int preparedBlockSize_ = 0; // 0 until prepareToPlay
+  int engineChannels_ = 0;    // Width the matrix was prepared with
+  uds::DelayMemoryOptions memoryOptions_;
+  std::shared_ptr<uds::DelayArena> delayArena_;
+  std::atomic<double> internalBpm_{120.0};
+  std::array<std::atomic<float>, 8> bandLevels_{
+      {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}};
+  std::array<std::atomic<uint32_t>, 8> bandChannelMasks_{
+      {uds::kAllChannels, uds::kAllChannels, uds::kAllChannels,
+       uds::kAllChannels, uds::kAllChannels, uds::kAllChannels,
+       uds::kAllChannels, uds::kAllChannels}};
+  std::array<std::atomic<int>, 8> bandTapParents_{
+      {-1, -1, -1, -1, -1, -1, -1, -1}};
+
+  // Expression pedal value (0-1 normalized, updated from MIDI CC)
+  std::atomic<float> expressionValue_{1.0f};
+
+  // Expression pedal mapping (which parameter to control)
+  std::optional<ExpressionMapping> expressionMapping_;
+  mutable std::mutex expressionMutex_; // Protects expressionMapping_
+
+  // ScopedSuspend state
+  std::mutex suspendMutex_;
+  int suspendDepth_ = 0;          // Guards currently held
+  bool resumeAfterSetup_ = false; // Processing ran before the first guard
+
+  /**
+   * @brief Listener side of each output channel, from the host bus layout
+   */
+  std::array<uds::ChannelSide, uds::kMaxChannels>
+  getOutputChannelSides() const {
+    const auto layout = getChannelLayoutOfBus(false, 0);
+    const int numChannels = juce::jmin(layout.size(), uds::kMaxChannels);
+
+    std::array<uds::ChannelSide, uds::kMaxChannels> sides{};
+    for (int ch = 0; ch < uds::kMaxChannels; ++ch) {
+      sides[static_cast<size_t>(ch)] =
+          (ch < numChannels && numChannels > 1)
+              ? channelSideFor(layout.getTypeOfChannel(ch), ch, numChannels)
+              : uds::defaultChannelSide(ch, numChannels);
+    }
+    return sides;
+  }
+
+  /**
+   * @brief Message-thread housekeeping for shared delay memory
+   *
+   * Follows the sharedDelayMemory and lockDelayMemory parameters (moving
+   * lines to the new backing) and lets the matrix check lines in and out.
+   */
+  void timerCallback() override {
+    // I/O mode switched to or from Mono: rebuild the matrix at the new
+    // width (the audio thread runs channel 0 only until then)
+    if (preparedBlockSize_ > 0 && getEngineChannels() != engineChannels_) {
+      const ScopedSuspend suspend(*this);
+      prepareMatrix();
+    }
+
+    const bool shared =
+        parameters_.getRawParameterValue("sharedDelayMemory")->load() > 0.5f;
+    const bool lock = isLockMemoryParameterOn();
+    if (shared != (delayArena_ != nullptr) || lock != memoryOptions_.lock) {
+      if (shared != (delayArena_ != nullptr))
+        delayArena_ = shared ? uds::DelayArena::acquire() : nullptr;
+      memoryOptions_.arena = delayArena_;
+      memoryOptions_.lock = lock;
+      delayMatrixFloat_.setMemoryOptions(memoryOptions_);
+      delayMatrixDouble_.setMemoryOptions(memoryOptions_);
+    }
+    delayMatrixFloat_.updateMemoryResidency();
+    delayMatrixDouble_.updateMemoryResidency();
+  }
+
+  static uds::ChannelSide
+  channelSideFor(juce::AudioChannelSet::ChannelType type, int channel,
+                 int numChannels) {
+    switch (type) {
+    case juce::AudioChannelSet::left:
+    case juce::AudioChannelSet::leftCentre:
+    case juce::AudioChannelSet::leftSurround:
+    case juce::AudioChannelSet::leftSurroundSide:
+    case juce::AudioChannelSet::leftSurroundRear:
+    case juce::AudioChannelSet::wideLeft:
+    case juce::AudioChannelSet::topFrontLeft:
+    case juce::AudioChannelSet::topSideLeft:
+    case juce::AudioChannelSet::topRearLeft:
+      return uds::ChannelSide::Left;
+    case juce::AudioChannelSet::right:
+    case juce::AudioChannelSet::rightCentre:
+    case juce::AudioChannelSet::rightSurround:
+    case juce::AudioChannelSet::rightSurroundSide:
+    case juce::AudioChannelSet::rightSurroundRear:
+    case juce::AudioChannelSet::wideRight:
+    case juce::AudioChannelSet::topFrontRight:
+    case juce::AudioChannelSet::topSideRight:
+    case juce::AudioChannelSet::topRearRight:
+      return uds::ChannelSide::Right;
+    case juce::AudioChannelSet::centre:
+    case juce::AudioChannelSet::LFE:
+    case juce::AudioChannelSet::LFE2:
+    case juce::AudioChannelSet::centreSurround:
+    case juce::AudioChannelSet::topMiddle:
+    case juce::AudioChannelSet::topFrontCentre:
+    case juce::AudioChannelSet::topRearCentre:
+      return uds::ChannelSide::Centre;
+    default:
+      // Discrete/unknown channels: alternate L/R
+      return uds::defaultChannelSide(channel, numChannels);
+    }
+  }
+
+  /**
+   * @brief Channels the matrix runs: one in Mono I/O mode (one line per
+   *        band, one limiter channel), otherwise the wider bus
+   */
+  int getEngineChannels() const {
+    if (static_cast<int>(parameters_.getRawParameterValue("ioMode")->load()) ==
+        1)
+      return 1;
+    return juce::jlimit(
+        1, uds::kMaxChannels,
+        juce::jmax(getTotalNumInputChannels(), getTotalNumOutputChannels()));
+  }
+
+  /**
+   * @brief (Re)build the active precision's matrix for the engine width
+   *
+   * Only the matrix matching the host's precision owns delay memory. A
+   * width change releases it first so a mono engine really holds half the
+   * memory.
+   */
+  void prepareMatrix() {
+    const int numChannels = getEngineChannels();
+    auto sides = getOutputChannelSides();
+    if (numChannels == 1)
+      sides[0] = uds::ChannelSide::Centre;
+    const bool widthChanged = numChannels != engineChannels_;
+    engineChannels_ = numChannels;
+
+    const auto blockSize = static_cast<size_t>(preparedBlockSize_);
+    if (isUsingDoublePrecision()) {
+      delayMatrixFloat_.release();
+      if (widthChanged)
+        delayMatrixDouble_.release();
+      delayMatrixDouble_.prepare(preparedSampleRate_, blockSize, numChannels);
+      delayMatrixDouble_.setChannelSides(sides.data(), numChannels);
+    } else {
+      delayMatrixDouble_.release();
+      if (widthChanged)
+        delayMatrixFloat_.release();
+      delayMatrixFloat_.prepare(preparedSampleRate_, blockSize, numChannels);
+      delayMatrixFloat_.setChannelSides(sides.data(), numChannels);
+    }
+    applyOfflineQuality(isNonRealtime());
+  }
+
+  bool isLockMemoryParameterOn() const {
+    return parameters_.getRawParameterValue("lockDelayMemory")->load() > 0.5f;
+  }
+
+  bool isBypassParameterOn() const {
+    return parameters_.getRawParameterValue("bypass")->load() > 0.5f;
+  }
+
+  /**
+   * @brief Bypassed block (bypassMode: 0 = Spill, 1 = Hard)
+   *
+   * Both pass the input through untouched. Spill keeps running the matrix
+   * without feeding it, so existing tails ring out on top and bands sleep
+   * as they decay; Hard runs no DSP and only clears the lines a slice per
+   * block, so resuming afterwards costs a state reset.
+   */
+  template <typename SampleType>
+  void processBypassedInternal(juce::AudioBuffer<SampleType>& buffer,
+                               uds::DelayMatrix<SampleType>& delayMatrix) {
+    juce::ScopedNoDenormals noDenormals;
+    for (auto i = getTotalNumInputChannels(); i < getTotalNumOutputChannels();
+         ++i)
+      buffer.clear(i, 0, buffer.getNumSamples());
+
+    const bool hard =
+        parameters_.getRawParameterValue("bypassMode")->load() > 0.5f;
+    if (hard) {
+      hardBypassed_ = true;
+      delayMatrix.processHardBypass();
+    } else {
+      if (hardBypassed_) {
+        delayMatrix.resumeFromHardBypass();
+        hardBypassed_ = false;
+      }
+      const float mix =
+          parameters_.getRawParameterValue("mix")->load() / 100.0f;
+      delayMatrix.setSleepQuietBands(true);
+      if (static_cast<int>(
+              parameters_.getRawParameterValue("ioMode")->load()) == 1) {
+        // Mono: fold and run channel 0 like processBlockInternal(), so
+        // the tails reach every output
+        const int numSamples = buffer.getNumSamples();
+        if (getTotalNumInputChannels() >= 2) {
+          buffer.addFrom(0, 0, buffer, 1, 0, numSamples, SampleType(0.5));
+          buffer.applyGain(0, 0, numSamples, SampleType(0.5));
+        }
+        juce::AudioBuffer<SampleType> mono(buffer.getArrayOfWritePointers(),
+                                           1, numSamples);
+        delayMatrix.processTails(mono, static_cast<SampleType>(mix),
+                                 routingGraph_);
+        for (int ch = 1; ch < getTotalNumOutputChannels(); ++ch)
+          buffer.copyFrom(ch, 0, buffer, 0, 0, numSamples);
+      } else {
+        delayMatrix.processTails(buffer, static_cast<SampleType>(mix),
+                                 routingGraph_);
+      }
+    }
+
+    for (int band = 0; band < 8; ++band)
+      bandLevels_[band].store(delayMatrix.getBandLevel(band));
+  }
+
+  /**
+   * @brief Shared processBlock body for the float and double paths
+   */
+  template <typename SampleType>
+  void processBlockInternal(juce::AudioBuffer<SampleType>& buffer,
+                            juce::MidiBuffer& midiMessages,
+                            uds::DelayMatrix<SampleType>& delayMatrix) {
     juce::ScopedNoDenormals noDenormals;
 
     auto totalNumInputChannels = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
     auto numSamples = buffer.getNumSamples();
 
+    // Back from a hard bypass: the lines are (nearly) clear already
+    if (hardBypassed_) {
+      delayMatrix.resumeFromHardBypass();
+      hardBypassed_ = false;
+    }
+
+    // Time the whole block against its real-time budget
+    uds::CpuGovernor::ScopedMeasurement cpuMeasurement(cpuGovernor_,
+                                                       numSamples);
+    cpuGovernor_.setEnabled(
+        parameters_.getRawParameterValue("adaptiveQuality")->load() > 0.5f);
+    const bool offline = offlineQuality_.load(std::memory_order_relaxed);
+    delayMatrix.setModulationControlStride(
+        offline ? 1 : cpuGovernor_.getModulationControlStride());
+    delayMatrix.setSleepQuietBands(!offline &&
+                                   cpuGovernor_.shouldSleepQuietBands());
+    delayMatrix.setRoutingFadeMs(
+        parameters_.getRawParameterValue("routingFade")->load());
+
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
       buffer.clear(i, 0, numSamples);
 
@@ -116,9 +656,10 @@ public:
     // When expression = 1, effective gain = inputGainDb (parameter value)
     float effectiveInputGainDb = -60.0f + (inputGainDb + 60.0f) * exprValue;
     if (effectiveInputGainDb > -59.9f) {
-      buffer.applyGain(juce::Decibels::decibelsToGain(effectiveInputGainDb));
+      buffer.applyGain(static_cast<SampleType>(
+          juce::Decibels::decibelsToGain(effectiveInputGainDb)));
     } else {
-      buffer.applyGain(0.0f); // Effectively silent
+      buffer.applyGain(SampleType(0)); // Effectively silent
     }
 
     // Get I/O mode: 0=Auto, 1=Mono, 2=Mono→Stereo, 3=Stereo
@@ -130,19 +671,20 @@ public:
       // Mono: Mix input to mono, process, output mono on both channels
       if (totalNumInputChannels >= 2) {
         // Mix L+R to mono
-        buffer.addFrom(0, 0, buffer, 1, 0, numSamples, 0.5f);
-        buffer.applyGain(0, 0, numSamples, 0.5f);
+        buffer.addFrom(0, 0, buffer, 1, 0, numSamples, SampleType(0.5));
+        buffer.applyGain(0, 0, numSamples, SampleType(0.5));
       }
       // After processing, we'll copy ch0 to ch1 at the end
     } else if (ioMode == 2 || (ioMode == 0 && totalNumInputChannels == 1 &&
-                               totalNumOutputChannels == 2)) {
-      // Mono→Stereo: Expand mono input to stereo buffer
+                               totalNumOutputChannels >= 2)) {
+      // Mono→Stereo: Expand mono input to every output channel
       if (totalNumInputChannels == 1 && totalNumOutputChannels >= 2) {
-        buffer.copyFrom(1, 0, buffer, 0, 0, numSamples);
+        for (int ch = 1; ch < totalNumOutputChannels; ++ch)
+          buffer.copyFrom(ch, 0, buffer, 0, 0, numSamples);
       } else if (totalNumInputChannels >= 2) {
         // Even with stereo input, treat as mono then expand
-        buffer.addFrom(0, 0, buffer, 1, 0, numSamples, 0.5f);
-        buffer.applyGain(0, 0, numSamples, 0.5f);
+        buffer.addFrom(0, 0, buffer, 1, 0, numSamples, SampleType(0.5));
+        buffer.applyGain(0, 0, numSamples, SampleType(0.5));
         buffer.copyFrom(1, 0, buffer, 0, 0, numSamples);
       }
     }
@@ -182,7 +724,7 @@ public:
     // Waveform index for setMasterLfo: 0=Sine, 1=Triangle, etc. (shift by -1
     // when not None)
     int adjustedWaveform = (masterLfoWaveform > 0) ? masterLfoWaveform - 1 : 0;
-    delayMatrix_.setMasterLfo(masterLfoRate, masterLfoDepth, adjustedWaveform);
+    delayMatrix.setMasterLfo(masterLfoRate, masterLfoDepth, adjustedWaveform);
 
     // Note division multipliers for tempo sync
     static const float noteDivisionMultipliers[] = {
@@ -273,10 +815,21 @@ public:
       params.enabled =
           parameters_.getRawParameterValue(prefix + "enabled")->load() > 0.5f;
 
-      // Algorithm selection (0=Digital, 1=Analog, 2=Tape, 3=LoFi)
+      // Algorithm selection (0=Digital, 1=Analog, 2=Tape, 3=LoFi, 4=Shimmer)
       int algoIndex = static_cast<int>(
           parameters_.getRawParameterValue(prefix + "algorithm")->load());
       params.algorithm = static_cast<uds::DelayAlgorithmType>(algoIndex);
+      params.pitchSemitones =
+          parameters_.getRawParameterValue(prefix + "pitch")->load();
+
+      // Read interpolation (0=None ... 5=Sinc, see Interpolation.h)
+      int interpIndex = static_cast<int>(
+          parameters_.getRawParameterValue(prefix + "interpolation")->load());
+      params.interpolation =
+          offline ? uds::InterpolationType::Sinc
+                  : cpuGovernor_.limitInterpolation(
+                        static_cast<uds::InterpolationType>(interpIndex));
+      params.channelMask = bandChannelMasks_[static_cast<size_t>(band)].load();
 
       // Solo/mute logic
       bool isMuted =
@@ -292,149 +845,46 @@ public:
       // Master LFO modulation is now handled by ModulationEngine inside
       // DelayMatrix
 
-      delayMatrix_.setBandParams(band, params);
+      delayMatrix.setBandParams(band, params);
+      delayMatrix.setBandTapParent(
+          band, bandTapParents_[static_cast<size_t>(band)].load());
     }
 
-    // Process through delay matrix with current routing
-    delayMatrix_.processWithRouting(buffer, mix, routingGraph_, dryLevel,
-                                    dryPan);
+    // Process through delay matrix with current routing. Mono runs the
+    // folded channel 0 only; the result is copied out below.
+    if (ioMode == 1) {
+      juce::AudioBuffer<SampleType> mono(buffer.getArrayOfWritePointers(), 1,
+                                         numSamples);
+      delayMatrix.processWithRouting(mono, static_cast<SampleType>(mix),
+                                     routingGraph_, dryLevel, dryPan);
+    } else {
+      delayMatrix.processWithRouting(buffer, static_cast<SampleType>(mix),
+                                     routingGraph_, dryLevel, dryPan);
+    }
 
     // Copy band levels for UI activity indicators
     for (int band = 0; band < 8; ++band) {
-      bandLevels_[band].store(delayMatrix_.getBandLevel(band));
+      bandLevels_[band].store(delayMatrix.getBandLevel(band));
     }
 
     // Apply mono output mode post-processing
-    if (ioMode == 1 && totalNumOutputChannels >= 2) {
-      // Mono: Copy processed channel 0 to channel 1
-      buffer.copyFrom(1, 0, buffer, 0, 0, numSamples);
+    if (ioMode == 1) {
+      // Mono: Copy processed channel 0 to every output
+      for (int ch = 1; ch < totalNumOutputChannels; ++ch)
+        buffer.copyFrom(ch, 0, buffer, 0, 0, numSamples);
     }
 
     // --- Apply Master Output (Post-Delay) ---
     float masterOutputDb =
         parameters_.getRawParameterValue("masterOutput")->load();
     if (masterOutputDb > -59.9f) {
-      buffer.applyGain(juce::Decibels::decibelsToGain(masterOutputDb));
+      buffer.applyGain(static_cast<SampleType>(
+          juce::Decibels::decibelsToGain(masterOutputDb)));
     } else {
-      buffer.applyGain(0.0f);
+      buffer.applyGain(SampleType(0));
     }
   }
 
-  juce::AudioProcessorEditor* createEditor() override;
-  bool hasEditor() const override { return true; }
-
-  const juce::String getName() const override { return JucePlugin_Name; }
-  bool acceptsMidi() const override { return true; }
-  bool producesMidi() const override { return false; }
-  bool isMidiEffect() const override { return false; }
-  double getTailLengthSeconds() const override { return 6.0; }
-
-  int getNumPrograms() override { return 1; }
-  int getCurrentProgram() override { return 0; }
-  void setCurrentProgram(int) override {}
-  const juce::String getProgramName(int) override { return {}; }
-  void changeProgramName(int, const juce::String&) override {}
-
-  void getStateInformation(juce::MemoryBlock& destData) override {
-    // Create root XML element
-    auto xml = std::make_unique<juce::XmlElement>("UDSState");
-
-    // Add APVTS parameters
-    auto state = parameters_.copyState();
-    xml->addChildElement(state.createXml().release());
-
-    // Add routing graph
-    xml->addChildElement(routingGraph_.toXml().release());
-
-    copyXmlToBinary(*xml, destData);
-  }
-
-  void setStateInformation(const void* data, int sizeInBytes) override {
-    std::unique_ptr<juce::XmlElement> xmlState(
-        getXmlFromBinary(data, sizeInBytes));
-
-    if (xmlState == nullptr)
-      return;
-
-    // Handle both old format (just APVTS) and new format (UDSState wrapper)
-    if (xmlState->hasTagName("UDSState")) {
-      // New format: extract APVTS and routing separately
-      if (auto* apvtsXml =
-              xmlState->getChildByName(parameters_.state.getType())) {
-        parameters_.replaceState(juce::ValueTree::fromXml(*apvtsXml));
-      }
-      if (auto* routingXml = xmlState->getChildByName("Routing")) {
-        routingGraph_.fromXml(routingXml);
-      }
-    } else if (xmlState->hasTagName(parameters_.state.getType())) {
-      // Old format: just APVTS state (backwards compatibility)
-      parameters_.replaceState(juce::ValueTree::fromXml(*xmlState));
-    }
-  }
-
-  juce::AudioProcessorValueTreeState& getParameters() { return parameters_; }
-
-  // Access to routing graph for editor
-  uds::RoutingGraph& getRoutingGraph() { return routingGraph_; }
-  const uds::RoutingGraph& getRoutingGraph() const { return routingGraph_; }
-
-  // Internal metronome BPM for standalone mode
-  void setInternalBpm(double bpm) { internalBpm_.store(bpm); }
-  double getInternalBpm() const { return internalBpm_.load(); }
-
-  // Per-band output levels for activity indicators
-  float getBandLevel(int band) const {
-    if (band >= 0 && band < 8)
-      return bandLevels_[band].load();
-    return 0.0f;
-  }
-
-  // Safety mute status for UI
-  bool isSafetyMuted() const { return delayMatrix_.isSafetyMuted(); }
-  int getSafetyMuteReason() const {
-    return static_cast<int>(delayMatrix_.getSafetyMuteReason());
-  }
-  void unlockSafetyMute() { delayMatrix_.unlockSafetyMute(); }
-
-  // Accessors for preset management
-  juce::AudioProcessorValueTreeState& getAPVTS() { return parameters_; }
-
-  // Expression pedal mapping API
-  void setExpressionMapping(const juce::String& paramId, float minVal,
-                            float maxVal) {
-    std::lock_guard<std::mutex> lock(expressionMutex_);
-    expressionMapping_ = ExpressionMapping{paramId, minVal, maxVal, false};
-  }
-  void clearExpressionMapping() {
-    std::lock_guard<std::mutex> lock(expressionMutex_);
-    expressionMapping_.reset();
-  }
-  std::optional<ExpressionMapping> getExpressionMapping() const {
-    std::lock_guard<std::mutex> lock(expressionMutex_);
-    return expressionMapping_;
-  }
-  bool hasExpressionMapping(const juce::String& paramId) const {
-    std::lock_guard<std::mutex> lock(expressionMutex_);
-    return expressionMapping_.has_value() &&
-           expressionMapping_->paramId == paramId;
-  }
-  float getExpressionValue() const { return expressionValue_.load(); }
-
-private:
-  juce::AudioProcessorValueTreeState parameters_;
-  uds::DelayMatrix delayMatrix_;
-  uds::RoutingGraph routingGraph_;
-  std::atomic<double> internalBpm_{120.0};
-  std::array<std::atomic<float>, 8> bandLevels_{
-      {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}};
-
-  // Expression pedal value (0-1 normalized, updated from MIDI CC)
-  std::atomic<float> expressionValue_{1.0f};
-
-  // Expression pedal mapping (which parameter to control)
-  std::optional<ExpressionMapping> expressionMapping_;
-  mutable std::mutex expressionMutex_; // Protects expressionMapping_
-
   static juce::AudioProcessorValueTreeState::ParameterLayout
   createParameterLayout() {
     std::vector<std::unique_ptr<juce::RangedAudioParameter>> params;
@@ -471,6 +921,42 @@ private:
         juce::ParameterID{"ioMode", 1}, "I/O Mode",
         juce::StringArray{"Auto", "Mono", "Mono→Stereo", "Stereo"}, 0));
 
+    // Adaptive quality: step quality down when processBlock overruns its
+    // budget (see uds::CpuGovernor)
+    params.push_back(std::make_unique<juce::AudioParameterBool>(
+        juce::ParameterID{"adaptiveQuality", 3}, "Adaptive Quality", true));
+
+    // Shared delay memory: lease delay lines from a process-wide arena and
+    // give them back while bands are unused or the plugin is silent (see
+    // uds::DelayArena). Off by default.
+    params.push_back(std::make_unique<juce::AudioParameterBool>(
+        juce::ParameterID{"sharedDelayMemory", 3}, "Shared Delay Memory",
+        false));
+
+    // Lock delay memory: mlock/VirtualLock the delay lines so they are
+    // never paged out (see uds::DelayMemoryOptions). Off by default, since
+    // it pins up to several hundred MB per instance; lines are pre-faulted
+    // either way.
+    params.push_back(std::make_unique<juce::AudioParameterBool>(
+        juce::ParameterID{"lockDelayMemory", 3}, "Lock Delay Memory", false));
+
+    // Bypass (also the host's bypass). Spill lets the tails ring out with
+    // the input no longer feeding the lines; Hard stops all processing.
+    params.push_back(std::make_unique<juce::AudioParameterBool>(
+        juce::ParameterID{"bypass", 3}, "Bypass", false));
+    params.push_back(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID{"bypassMode", 3}, "Bypass Mode",
+        juce::StringArray{"Spill", "Hard"}, 0));
+
+    // Routing fade: how long a routing change crossfades from the old
+    // processing order to the new one (0 = switch at once)
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{"routingFade", 3}, "Routing Fade",
+        juce::NormalisableRange<float>(
+            0.0f, uds::DelayMatrix<float>::kMaxRoutingFadeMs, 0.1f),
+        uds::DelayMatrix<float>::kDefaultRoutingFadeMs,
+        juce::AudioParameterFloatAttributes().withLabel("ms")));
+
     // Dry level (for MagicStomp presets that attenuate dry signal)
     params.push_back(std::make_unique<juce::AudioParameterFloat>(
         juce::ParameterID{"dryLevel", 1}, "Dry Level",
@@ -571,7 +1057,23 @@ private:
       // Algorithm selection
       params.push_back(std::make_unique<juce::AudioParameterChoice>(
           juce::ParameterID{prefix + "algorithm", 2}, bandName + "Algorithm",
-          juce::StringArray{"Digital", "Analog", "Tape", "Lo-Fi"}, 0));
+          juce::StringArray{"Digital", "Analog", "Tape", "Lo-Fi", "Shimmer"},
+          0));
+
+      // Shimmer transposition per repeat
+      params.push_back(std::make_unique<juce::AudioParameterFloat>(
+          juce::ParameterID{prefix + "pitch", 3}, bandName + "Pitch",
+          juce::NormalisableRange<float>(-12.0f, 12.0f, 1.0f), 12.0f,
+          juce::AudioParameterFloatAttributes().withLabel("st")));
+
+      // Read interpolation quality (cheap for static delays, higher tiers
+      // for heavy modulation)
+      params.push_back(std::make_unique<juce::AudioParameterChoice>(
+          juce::ParameterID{prefix + "interpolation", 3},
+          bandName + "Interpolation",
+          juce::StringArray{"None", "Linear", "Hermite", "Lagrange",
+                            "Allpass", "Sinc"},
+          2));
 
       // Tempo sync
       params.push_back(std::make_unique<juce::AudioParameterBool>(
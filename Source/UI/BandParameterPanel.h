@@ -84,6 +84,7 @@ public:
     algorithmBox_.addItem("Analog", 2);
     algorithmBox_.addItem("Tape", 3);
     algorithmBox_.addItem("Lo-Fi", 4);
+    algorithmBox_.addItem("Shimmer", 5);
     algorithmBox_.setColour(juce::ComboBox::backgroundColourId,
                             juce::Colour(0xff303030));
     algorithmBox_.setColour(juce::ComboBox::textColourId, juce::Colours::white);
@@ -91,6 +92,19 @@ public:
                             juce::Colour(0xff505050));
     addAndMakeVisible(algorithmBox_);
 
+    // Interpolation selector (order matches the "interpolation" parameter)
+    interpolationBox_.addItemList({"None", "Linear", "Hermite", "Lagrange",
+                                   "Allpass", "Sinc"},
+                                  1);
+    interpolationBox_.setColour(juce::ComboBox::backgroundColourId,
+                                juce::Colour(0xff303030));
+    interpolationBox_.setColour(juce::ComboBox::textColourId,
+                                juce::Colours::white);
+    interpolationBox_.setColour(juce::ComboBox::outlineColourId,
+                                juce::Colour(0xff505050));
+    interpolationBox_.setTooltip("Delay read interpolation");
+    addAndMakeVisible(interpolationBox_);
+
     algorithmLabel_.setText("Mode", juce::dontSendNotification);
     algorithmLabel_.setJustificationType(juce::Justification::centredLeft);
     algorithmLabel_.setColour(juce::Label::textColourId,
@@ -116,6 +130,9 @@ public:
     algorithmAttachment_ = std::make_unique<
         juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
         apvts_, prefix + "algorithm", algorithmBox_);
+    interpolationAttachment_ = std::make_unique<
+        juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        apvts_, prefix + "interpolation", interpolationBox_);
 
     // =========================================
     // Filter Controls (Hi-Cut, Lo-Cut)
@@ -450,6 +467,8 @@ public:
     // Algorithm selector (left half)
     auto algoArea = row3.removeFromLeft(row3.getWidth() / 2);
     algorithmLabel_.setBounds(algoArea.removeFromLeft(40));
+    interpolationBox_.setBounds(
+        algoArea.removeFromRight(algoArea.getWidth() / 2).reduced(2, 3));
     algorithmBox_.setBounds(algoArea.reduced(2, 3));
 
     // LFO Waveform selector + Phase Invert + Ping-Pong (right half)
@@ -522,6 +541,7 @@ private:
     levelSlider_.setAlpha(alpha);
     panSlider_.setAlpha(alpha);
     algorithmBox_.setAlpha(alpha);
+    interpolationBox_.setAlpha(alpha);
     soloButton_.setAlpha(alpha);
     muteButton_.setAlpha(alpha);
 
@@ -586,6 +606,7 @@ private:
   juce::Label timeLabel_, feedbackLabel_, levelLabel_, panLabel_;
   juce::ComboBox algorithmBox_;
   juce::Label algorithmLabel_;
+  juce::ComboBox interpolationBox_;
 
   // Filter controls
   ExpressionSlider hiCutSlider_, loCutSlider_;
@@ -614,6 +635,8 @@ private:
       enableAttachment_;
   std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment>
       algorithmAttachment_;
+  std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment>
+      interpolationAttachment_;
 
   // Filter attachments
   std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>
@@ -179,6 +179,13 @@ public:
     bandCountLabel_.setFont(juce::FontOptions(12.0f));
     addAndMakeVisible(bandCountLabel_);
 
+    // Adaptive quality status (CPU governor level, reason in tooltip)
+    qualityLabel_.setJustificationType(juce::Justification::centredLeft);
+    qualityLabel_.setColour(juce::Label::textColourId,
+                            juce::Colours::white.withAlpha(0.6f));
+    qualityLabel_.setFont(juce::FontOptions(12.0f));
+    addAndMakeVisible(qualityLabel_);
+
     // Routing preset buttons
     parallelButton_.setButtonText("Parallel");
     parallelButton_.onClick = [this] {
@@ -295,6 +302,7 @@ public:
 
     // Band Count Label next to tabs
     bandCountLabel_.setBounds(headerRow.removeFromLeft(80).reduced(5, 12));
+    qualityLabel_.setBounds(headerRow.removeFromLeft(110).reduced(5, 12));
 
     // Preset buttons (visible only in routing view)
     // Preset buttons (visible only in routing view)
@@ -451,6 +459,7 @@ private:
 
     for (const auto& conn : uiConnections) {
       routingGraph_.connect(conn.sourceId, conn.destId);
+      routingGraph_.setConnectionGain(conn.sourceId, conn.destId, conn.gain);
     }
 
     // Also sync the active bands from UI to processor
@@ -471,6 +480,7 @@ private:
 
     for (const auto& conn : procConnections) {
       uiRouting.connect(conn.sourceId, conn.destId);
+      uiRouting.setConnectionGain(conn.sourceId, conn.destId, conn.gain);
     }
 
     // Also sync the active bands
@@ -531,6 +541,7 @@ private:
   juce::TextButton undoButton_;
   juce::TextButton redoButton_;
   juce::Label bandCountLabel_;
+  juce::Label qualityLabel_;
   RoutingUndoManager undoManager_;
   bool showRoutingView_ = false;
 
@@ -551,6 +562,52 @@ public:
     }
   }
 
+  /**
+   * @brief Show the CPU governor state
+   * @param level uds::QualityLevel as int
+   * @param reason uds::QualityReason as int
+   * @param load Smoothed processBlock load (fraction of the block budget)
+   */
+  void updateQualityStatus(int level, int reason, float load, bool idle) {
+    static const char* const levelNames[] = {"Full", "HQ interp off",
+                                             "Linear interp", "Slow LFOs",
+                                             "Sleeping bands"};
+    juce::String reasonText;
+    switch (reason) {
+    case 1:
+      reasonText = "Quality reduced: processing is over its CPU budget";
+      break;
+    case 2:
+      reasonText = "CPU headroom is back; restoring quality shortly";
+      break;
+    case 3:
+      reasonText = "Adaptive quality is off";
+      break;
+    default:
+      reasonText = "Full quality";
+      break;
+    }
+
+    if (idle) {
+      qualityLabel_.setText("Idle", juce::dontSendNotification);
+      qualityLabel_.setTooltip(
+          "Input and delay tails are silent; processing is skipped");
+      qualityLabel_.setColour(juce::Label::textColourId,
+                              juce::Colours::white.withAlpha(0.4f));
+      return;
+    }
+
+    const int index = juce::jlimit(0, 4, level);
+    qualityLabel_.setText(juce::String(levelNames[index]) + " " +
+                              juce::String(juce::roundToInt(load * 100.0f)) +
+                              "%",
+                          juce::dontSendNotification);
+    qualityLabel_.setTooltip(reasonText);
+    qualityLabel_.setColour(juce::Label::textColourId,
+                            index > 0 ? juce::Colour(0xfff9c74f)
+                                      : juce::Colours::white.withAlpha(0.6f));
+  }
+
   // Update band panel visibility based on active bands in routing graph
   void updateBandPanelVisibility() {
     const auto& routingGraph = nodeEditor_.getRoutingGraph();
@@ -93,10 +93,14 @@ struct DragCable {
 
 /**
  * @brief A connection in the routing graph
+ *
+ * Identified by its endpoints; gain scales the signal carried over it
+ * (negative = polarity inverted).
  */
 struct Connection {
   int sourceId;
   int destId;
+  float gain = 1.0f;
 
   bool operator==(const Connection& other) const {
     return sourceId == other.sourceId && destId == other.destId;
@@ -1,23 +1,36 @@
 #define CATCH_CONFIG_MAIN
 #include <array>
+#include <atomic>
 #include <cmath>
 #include <iomanip>
 #include <iostream>
 #include <limits>
+#include <thread>
 #include <vector>
 
 #include <catch2/catch_all.hpp>
 
 
 // Include headers under test
+#include "../Source/Core/CpuGovernor.h"
 #include "../Source/Core/DelayAlgorithm.h"
 #include "../Source/Core/DelayBandNode.h"
+#include "../Source/Core/DelayMatrix.h"
+#include "../Source/Core/DelayMemory.h"
+#include "../Source/Core/FanInMix.h"
 #include "../Source/Core/FilterSection.h"
+#include "../Source/Core/InputAnalysis.h"
 #include "../Source/Core/GenerativeModulator.h"
 #include "../Source/Core/LFOModulator.h"
 #include "../Source/Core/ModulationEngine.h"
+#include "../Source/Core/Oversampling.h"
+#include "../Source/Core/PeakScan.h"
 #include "../Source/Core/RoutingGraph.h"
+#include "../Source/Core/RoutingPlan.h"
 #include "../Source/Core/SafetyLimiter.h"
+#include "../Source/Core/SimdDispatch.h"
+#include "../Source/Core/TailLength.h"
+#include "../Source/Core/WorkerPool.h"
 
 // ============================================================================
 // Test Utilities
@@ -45,7 +58,7 @@ inline float calculateRMS(const float* buffer, int numSamples) {
 // ============================================================================
 
 TEST_CASE("SafetyLimiter prevents clipping", "[safety]") {
-  uds::SafetyLimiter limiter;
+  uds::SafetyLimiter<float> limiter;
   limiter.prepare(44100.0);
 
   SECTION("Normal signals pass through") {
@@ -95,7 +108,7 @@ TEST_CASE("SafetyLimiter prevents clipping", "[safety]") {
 // ============================================================================
 
 TEST_CASE("FilterSection processes audio", "[dsp][filters]") {
-  uds::FilterSection filter;
+  uds::FilterSection<float> filter;
   filter.prepare(44100.0);
 
   SECTION("Passthrough at extreme frequencies") {
@@ -281,7 +294,7 @@ TEST_CASE("Delay algorithms process samples", "[dsp][algorithms]") {
   const double sampleRate = 44100.0;
 
   SECTION("Digital delay passes through unchanged") {
-    uds::DigitalDelay digital;
+    uds::DigitalDelay<float> digital;
     digital.prepare(sampleRate);
 
     float input = 0.5f;
@@ -292,7 +305,7 @@ TEST_CASE("Delay algorithms process samples", "[dsp][algorithms]") {
   }
 
   SECTION("Analog delay adds saturation") {
-    uds::AnalogDelay analog;
+    uds::AnalogDelay<float> analog;
     analog.prepare(sampleRate);
 
     // Process multiple samples to let filter settle
@@ -308,7 +321,7 @@ TEST_CASE("Delay algorithms process samples", "[dsp][algorithms]") {
   }
 
   SECTION("Tape delay adds character") {
-    uds::TapeDelay tape;
+    uds::TapeDelay<float> tape;
     tape.prepare(sampleRate);
 
     // Process multiple samples
@@ -324,7 +337,7 @@ TEST_CASE("Delay algorithms process samples", "[dsp][algorithms]") {
   }
 
   SECTION("LoFi delay quantizes signal") {
-    uds::LoFiDelay lofi;
+    uds::LoFiDelay<float> lofi;
     lofi.prepare(sampleRate);
 
     // Process with decimation (need multiple samples)
@@ -338,10 +351,10 @@ TEST_CASE("Delay algorithms process samples", "[dsp][algorithms]") {
   }
 
   SECTION("Algorithm types are correct") {
-    uds::DigitalDelay digital;
-    uds::AnalogDelay analog;
-    uds::TapeDelay tape;
-    uds::LoFiDelay lofi;
+    uds::DigitalDelay<float> digital;
+    uds::AnalogDelay<float> analog;
+    uds::TapeDelay<float> tape;
+    uds::LoFiDelay<float> lofi;
 
     REQUIRE(digital.getType() == uds::DelayAlgorithmType::Digital);
     REQUIRE(analog.getType() == uds::DelayAlgorithmType::Analog);
@@ -350,10 +363,14 @@ TEST_CASE("Delay algorithms process samples", "[dsp][algorithms]") {
   }
 
   SECTION("Factory creates correct types") {
-    auto digital = uds::createDelayAlgorithm(uds::DelayAlgorithmType::Digital);
-    auto analog = uds::createDelayAlgorithm(uds::DelayAlgorithmType::Analog);
-    auto tape = uds::createDelayAlgorithm(uds::DelayAlgorithmType::Tape);
-    auto lofi = uds::createDelayAlgorithm(uds::DelayAlgorithmType::LoFi);
+    auto digital =
+        uds::createDelayAlgorithm<float>(uds::DelayAlgorithmType::Digital);
+    auto analog =
+        uds::createDelayAlgorithm<float>(uds::DelayAlgorithmType::Analog);
+    auto tape =
+        uds::createDelayAlgorithm<float>(uds::DelayAlgorithmType::Tape);
+    auto lofi =
+        uds::createDelayAlgorithm<float>(uds::DelayAlgorithmType::LoFi);
 
     REQUIRE(digital->getType() == uds::DelayAlgorithmType::Digital);
     REQUIRE(analog->getType() == uds::DelayAlgorithmType::Analog);
@@ -363,10 +380,10 @@ TEST_CASE("Delay algorithms process samples", "[dsp][algorithms]") {
 
   SECTION("Algorithms stay bounded") {
     auto algorithms = {
-        uds::createDelayAlgorithm(uds::DelayAlgorithmType::Digital),
-        uds::createDelayAlgorithm(uds::DelayAlgorithmType::Analog),
-        uds::createDelayAlgorithm(uds::DelayAlgorithmType::Tape),
-        uds::createDelayAlgorithm(uds::DelayAlgorithmType::LoFi)};
+        uds::createDelayAlgorithm<float>(uds::DelayAlgorithmType::Digital),
+        uds::createDelayAlgorithm<float>(uds::DelayAlgorithmType::Analog),
+        uds::createDelayAlgorithm<float>(uds::DelayAlgorithmType::Tape),
+        uds::createDelayAlgorithm<float>(uds::DelayAlgorithmType::LoFi)};
 
     for (auto& algo : algorithms) {
       algo->prepare(sampleRate);
@@ -696,7 +713,7 @@ TEST_CASE("Phase inversion", "[dsp]") {
 // ============================================================================
 
 TEST_CASE("SafetyLimiter edge cases", "[safety][boundary]") {
-  uds::SafetyLimiter limiter;
+  uds::SafetyLimiter<float> limiter;
   limiter.prepare(44100.0);
 
   SECTION("Handles NaN input without crash or propagation") {
@@ -746,7 +763,7 @@ TEST_CASE("SafetyLimiter edge cases", "[safety][boundary]") {
 }
 
 TEST_CASE("FilterSection boundary conditions", "[filters][boundary]") {
-  uds::FilterSection filter;
+  uds::FilterSection<float> filter;
   filter.prepare(44100.0);
 
   SECTION("Extreme hi-cut frequency is clamped to Nyquist") {
@@ -888,7 +905,7 @@ TEST_CASE("DelayAlgorithm correctness", "[algorithms][boundary]") {
   const double sampleRate = 44100.0;
 
   SECTION("Digital algorithm is truly transparent") {
-    uds::DigitalDelay digital;
+    uds::DigitalDelay<float> digital;
     digital.prepare(sampleRate);
 
     // Process 1000 random values - all should be unchanged
@@ -900,7 +917,7 @@ TEST_CASE("DelayAlgorithm correctness", "[algorithms][boundary]") {
   }
 
   SECTION("Analog algorithm adds measurable saturation") {
-    uds::AnalogDelay analog;
+    uds::AnalogDelay<float> analog;
     analog.prepare(sampleRate);
     analog.reset();
 
@@ -917,7 +934,7 @@ TEST_CASE("DelayAlgorithm correctness", "[algorithms][boundary]") {
   }
 
   SECTION("LoFi algorithm introduces quantization") {
-    uds::LoFiDelay lofi;
+    uds::LoFiDelay<float> lofi;
     lofi.prepare(sampleRate);
 
     // Fine gradients should be quantized to same values
@@ -939,6 +956,1566 @@ TEST_CASE("DelayAlgorithm correctness", "[algorithms][boundary]") {
     // Quantization means these should round to same value (or very close)
     REQUIRE(std::abs(out1 - out2) < 0.01f);
   }
+
+  SECTION("Channels keep independent state") {
+    for (auto type : {uds::DelayAlgorithmType::Analog,
+                      uds::DelayAlgorithmType::Tape}) {
+      auto stereo = uds::createDelayAlgorithm<float>(type);
+      auto mono = uds::createDelayAlgorithm<float>(type);
+      stereo->prepare(sampleRate);
+      mono->prepare(sampleRate);
+
+      // Left carries a sine, right stays silent: the right lane must stay
+      // at zero and the left lane must match a mono instance exactly
+      for (int i = 0; i < 2000; ++i) {
+        const float x = 0.5f * std::sin(0.05f * static_cast<float>(i));
+        std::array<float, 2> frame{x, 0.0f};
+        stereo->processFrame(frame.data(), 2);
+        REQUIRE(frame[0] == mono->processSample(x));
+        REQUIRE(frame[1] == 0.0f);
+      }
+    }
+  }
+}
+
+TEST_CASE("Analog BBD model", "[algorithms][bbd]") {
+  const double sampleRate = 48000.0;
+
+  // RMS of a sine after it has been through the round trip for a while
+  auto rmsThrough = [&](uds::AnalogDelay<float>& analog, double freqHz,
+                        float amplitude) {
+    const double w = 2.0 * 3.14159265358979323846 * freqHz / sampleRate;
+    double sum = 0.0;
+    int count = 0;
+    for (int i = 0; i < 24000; ++i) {
+      const float y = analog.processSample(
+          amplitude * static_cast<float>(std::sin(w * i)));
+      if (i >= 12000) {
+        sum += static_cast<double>(y) * y;
+        ++count;
+      }
+    }
+    return std::sqrt(sum / count);
+  };
+
+  SECTION("Bandwidth follows the BBD clock") {
+    REQUIRE(uds::BBDClock::cutoffHz(40.0) > uds::BBDClock::cutoffHz(400.0));
+    REQUIRE(uds::BBDClock::cutoffHz(10000.0) ==
+            uds::BBDClock::kMinCutoffHz);
+    REQUIRE(uds::BBDClock::cutoffHz(1.0) == uds::BBDClock::kMaxCutoffHz);
+
+    uds::AnalogDelay<float> shortDelay, longDelay;
+    shortDelay.prepare(sampleRate);
+    longDelay.prepare(sampleRate);
+    shortDelay.setDelayTime(40.0);
+    longDelay.setDelayTime(400.0);
+
+    // 6 kHz sits inside the 40 ms bandwidth and far above the 400 ms one
+    const double shortRms = rmsThrough(shortDelay, 6000.0, 0.1f);
+    const double longRms = rmsThrough(longDelay, 6000.0, 0.1f);
+    REQUIRE(shortRms > 4.0 * longRms);
+  }
+
+  SECTION("Compander is transparent in steady state") {
+    uds::AnalogDelay<float> analog;
+    analog.prepare(sampleRate);
+    analog.setDelayTime(40.0);
+
+    // Quiet and moderate passband tones come back near unity gain
+    for (float amplitude : {0.05f, 0.2f}) {
+      analog.reset();
+      const double gain = rmsThrough(analog, 500.0, amplitude) /
+                          (amplitude / std::sqrt(2.0));
+      REQUIRE(gain > 0.7);
+      REQUIRE(gain < 1.3);
+    }
+  }
+
+  SECTION("Band forwards its delay time to the clock") {
+    uds::DelayBandNode<float> band;
+    band.prepare(sampleRate, 512);
+    uds::DelayBandParams params;
+    params.algorithm = uds::DelayAlgorithmType::Analog;
+    params.delayTimeMs = 600.0f;
+    band.setParams(params);
+
+    // Brightness of the echo train (difference energy over energy): a long
+    // delay must come back darker than a short one
+    auto echoBrightness = [&](float delayMs) {
+      params.delayTimeMs = delayMs;
+      params.feedback = 0.8f;
+      band.setParams(params);
+      band.reset();
+      juce::AudioBuffer<float> block(2, 512);
+      double energy = 0.0, diffEnergy = 0.0;
+      float previous = 0.0f;
+      const int firstProcessed = static_cast<int>(delayMs * 48.0f * 1.5f);
+      for (int b = 0; b < 40; ++b) {
+        block.clear();
+        if (b == 0) {
+          block.setSample(0, 0, 0.5f);
+          block.setSample(1, 0, 0.5f);
+        }
+        band.process(block, 1.0, nullptr, nullptr);
+        for (int i = 0; i < 512; ++i) {
+          // The dry click and first echo never pass the algorithm
+          const float y = b * 512 + i < firstProcessed ? 0.0f
+                                                       : block.getSample(0, i);
+          energy += static_cast<double>(y) * y;
+          diffEnergy += static_cast<double>(y - previous) * (y - previous);
+          previous = y;
+        }
+      }
+      return diffEnergy / energy;
+    };
+
+    REQUIRE(echoBrightness(20.0f) > 1.5 * echoBrightness(200.0f));
+  }
+}
+
+TEST_CASE("Shimmer pitch-shifts inside the loop", "[algorithms][shimmer]") {
+  const double sampleRate = 48000.0;
+
+  SECTION("Octave up doubles the frequency") {
+    uds::ShimmerDelay<float> shimmer;
+    shimmer.prepare(sampleRate);
+    REQUIRE(shimmer.getType() == uds::DelayAlgorithmType::Shimmer);
+
+    // Count rising zero crossings of the output of a 500 Hz tone
+    const double w = 2.0 * 3.14159265358979323846 * 500.0 / sampleRate;
+    float previous = 0.0f;
+    int crossings = 0;
+    for (int i = 0; i < 48000; ++i) {
+      const float y = shimmer.processSample(
+          0.5f * static_cast<float>(std::sin(w * i)));
+      if (i >= 24000 && previous < 0.0f && y >= 0.0f)
+        ++crossings;
+      previous = y;
+    }
+    // Half a second at 1 kHz
+    REQUIRE(crossings > 475);
+    REQUIRE(crossings < 525);
+  }
+
+  SECTION("Latency is half a grain at any pitch") {
+    uds::ShimmerDelay<float> shimmer;
+    shimmer.prepare(sampleRate);
+    const double expected = 0.5 * uds::PitchShifter<float>::kGrainSeconds *
+                            sampleRate;
+    REQUIRE(std::abs(shimmer.getLatencySamples() - expected) < 1.0);
+    shimmer.setPitchSemitones(-7.0);
+    REQUIRE(std::abs(shimmer.getLatencySamples() - expected) < 1.0);
+  }
+
+  SECTION("Band keeps the loop period despite the shifter latency") {
+    uds::DelayBandNode<float> band;
+    band.prepare(sampleRate, 512);
+    uds::DelayBandParams params;
+    params.algorithm = uds::DelayAlgorithmType::Shimmer;
+    params.pitchSemitones = 0.0f; // Pure delay: echoes stay impulses
+    params.delayTimeMs = 100.0f;
+    params.feedback = 0.5f;
+    params.hiCutHz = 20000.0f;
+    params.loCutHz = 20.0f;
+    band.setParams(params);
+
+    std::vector<float> out;
+    juce::AudioBuffer<float> block(2, 512);
+    for (int b = 0; b < 30; ++b) {
+      block.clear();
+      if (b == 0) {
+        block.setSample(0, 0, 1.0f);
+        block.setSample(1, 0, 1.0f);
+      }
+      band.process(block, 1.0, nullptr, nullptr);
+      for (int i = 0; i < 512; ++i)
+        out.push_back(block.getSample(0, i));
+    }
+
+    // Loudest sample in a window around the nth echo
+    auto peakNear = [&](int centre) {
+      int best = centre - 200;
+      for (int i = centre - 200; i <= centre + 200; ++i)
+        if (std::abs(out[static_cast<size_t>(i)]) >
+            std::abs(out[static_cast<size_t>(best)]))
+          best = i;
+      return best;
+    };
+    REQUIRE(std::abs(peakNear(4800) - 4800) <= 1);
+    REQUIRE(std::abs(peakNear(9600) - 9600) <= 1);
+    REQUIRE(std::abs(peakNear(14400) - 14400) <= 2);
+  }
+}
+
+TEST_CASE("Offline quality: oversampling and worker pool", "[dsp][offline]") {
+  const double sampleRate = 48000.0;
+
+  SECTION("2x round trip is a pure delay in the passband") {
+    uds::Oversampler2x<double> oversampler;
+    oversampler.prepare();
+    constexpr int latency = uds::Oversampler2x<double>::kLatency;
+
+    const double w = 2.0 * 3.14159265358979323846 * 1000.0 / sampleRate;
+    double maxError = 0.0;
+    for (int i = 0; i < 4800; ++i) {
+      const double in[2] = {std::sin(w * i), -std::sin(w * i)};
+      double first[2], second[2], out[2];
+      oversampler.upsample(in, first, second, 2);
+      oversampler.downsample(first, second, out, 2);
+      if (i >= 2 * latency) {
+        const double expected = std::sin(w * (i - latency));
+        maxError = std::max(maxError, std::abs(out[0] - expected));
+        maxError = std::max(maxError, std::abs(out[1] + expected));
+      }
+    }
+    REQUIRE(maxError < 0.01);
+  }
+
+  SECTION("Oversampled band keeps the echo timing and level") {
+    // Impulse (burst = false) or a 10 ms 500 Hz burst into a Tape band
+    auto render = [&](bool oversample, bool burst) {
+      uds::DelayBandNode<float> band;
+      band.prepare(sampleRate, 512);
+      band.setOversampling(oversample);
+      uds::DelayBandParams params;
+      params.algorithm = uds::DelayAlgorithmType::Tape;
+      params.delayTimeMs = 100.0f;
+      params.feedback = 0.5f;
+      // Nearly open filters, kept running (the range ends switch them
+      // off): they settle the smeared second echo whose peak is compared
+      params.hiCutHz = 19999.0f;
+      params.loCutHz = 21.0f;
+      band.setParams(params);
+      REQUIRE(band.isOversampling() == oversample);
+
+      std::vector<float> out;
+      juce::AudioBuffer<float> block(2, 512);
+      for (int b = 0; b < 20; ++b) {
+        block.clear();
+        for (int i = 0; b == 0 && i < (burst ? 480 : 1); ++i) {
+          const float x =
+              burst ? 0.3f * static_cast<float>(std::sin(
+                                 2.0 * 3.14159265358979323846 * 500.0 * i /
+                                 sampleRate))
+                    : 0.5f;
+          block.setSample(0, i, x);
+          block.setSample(1, i, x);
+        }
+        band.process(block, 1.0, nullptr, nullptr);
+        for (int i = 0; i < 512; ++i)
+          out.push_back(block.getSample(0, i));
+      }
+      return out;
+    };
+
+    auto peakNear = [](const std::vector<float>& out, int centre) {
+      int best = centre - 200;
+      for (int i = centre - 200; i <= centre + 200; ++i)
+        if (std::abs(out[static_cast<size_t>(i)]) >
+            std::abs(out[static_cast<size_t>(best)]))
+          best = i;
+      return best;
+    };
+    const auto liveImpulse = render(false, false);
+    const auto offlineImpulse = render(true, false);
+    for (int echo : {4800, 9600})
+      REQUIRE(std::abs(peakNear(offlineImpulse, echo) -
+                       peakNear(liveImpulse, echo)) <= 1);
+
+    auto energyFrom = [](const std::vector<float>& out, int start) {
+      double sum = 0.0;
+      for (int i = start; i < start + 600; ++i)
+        sum += out[static_cast<size_t>(i)] * out[static_cast<size_t>(i)];
+      return sum;
+    };
+    const auto liveBurst = render(false, true);
+    const auto offlineBurst = render(true, true);
+    for (int echo : {4800, 9600}) {
+      const double ratio =
+          energyFrom(offlineBurst, echo) / energyFrom(liveBurst, echo);
+      // Same tape character within 3 dB
+      REQUIRE(ratio > 0.5);
+      REQUIRE(ratio < 2.0);
+    }
+  }
+
+  SECTION("Worker pool runs every task exactly once") {
+    uds::WorkerPool pool;
+    pool.start(3);
+    REQUIRE(pool.getNumWorkers() == 3);
+
+    std::array<std::atomic<int>, 12> hits{};
+    auto task = [&](int i) { hits[static_cast<size_t>(i)].fetch_add(1); };
+    for (int round = 0; round < 200; ++round)
+      pool.run(12, task);
+    for (auto& hit : hits)
+      REQUIRE(hit.load() == 200);
+
+    pool.stop();
+    REQUIRE(pool.getNumWorkers() == 0);
+    pool.run(12, task); // Falls back to the caller
+    REQUIRE(hits[0].load() == 201);
+  }
+}
+
+TEST_CASE("Double-precision processing path", "[dsp][precision]") {
+  constexpr double sampleRate = 44100.0;
+  constexpr int blockSize = 512;
+
+  uds::DelayBandParams params;
+  params.delayTimeMs = 5.0f; // 220.5 samples: exercises interpolation
+  params.feedback = 0.7f;
+  params.algorithm = uds::DelayAlgorithmType::Analog;
+
+  uds::DelayBandNode<float> bandF;
+  uds::DelayBandNode<double> bandD;
+  bandF.prepare(sampleRate, blockSize);
+  bandD.prepare(sampleRate, blockSize);
+  bandF.setParams(params);
+  bandD.setParams(params);
+
+  SECTION("Double band tracks the float band") {
+    juce::AudioBuffer<float> bufF(2, blockSize);
+    juce::AudioBuffer<double> bufD(2, blockSize);
+    bufF.clear();
+    bufD.clear();
+    bufF.setSample(0, 0, 0.5f);
+    bufF.setSample(1, 0, 0.5f);
+    bufD.setSample(0, 0, 0.5);
+    bufD.setSample(1, 0, 0.5);
+
+    float maxDiff = 0.0f;
+    float energy = 0.0f;
+    for (int block = 0; block < 4; ++block) {
+      bandF.process(bufF, 1.0f);
+      bandD.process(bufD, 1.0);
+      for (int i = 0; i < blockSize; ++i) {
+        float f = bufF.getSample(0, i);
+        double d = bufD.getSample(0, i);
+        maxDiff = std::max(maxDiff, static_cast<float>(std::abs(f - d)));
+        energy += f * f;
+      }
+      bufF.clear();
+      bufD.clear();
+    }
+
+    REQUIRE(energy > 0.0f);  // Echoes present
+    REQUIRE(maxDiff < 1e-4f); // Same algorithm, only precision differs
+  }
+
+  SECTION("Double filter and limiter instantiate and stay bounded") {
+    uds::FilterSection<double> filter;
+    filter.prepare(sampleRate);
+    filter.setHiCutFrequency(5000.0f);
+    filter.setLoCutFrequency(100.0f);
+
+    uds::SafetyLimiter<double> limiter;
+    limiter.prepare(sampleRate);
+
+    std::vector<double> left(blockSize), right(blockSize);
+    for (int i = 0; i < blockSize; ++i) {
+      left[static_cast<size_t>(i)] = 4.0 * std::sin(0.05 * i);
+      right[static_cast<size_t>(i)] = left[static_cast<size_t>(i)];
+      filter.processSample(left[static_cast<size_t>(i)],
+                           right[static_cast<size_t>(i)]);
+    }
+    limiter.process(left.data(), right.data(), blockSize);
+
+    for (int i = 0; i < blockSize; ++i) {
+      REQUIRE(std::abs(left[static_cast<size_t>(i)]) <= 1.0);
+      REQUIRE(std::isfinite(right[static_cast<size_t>(i)]));
+    }
+  }
+}
+
+TEST_CASE("Multichannel delay bands", "[dsp][multichannel]") {
+  constexpr double sampleRate = 48000.0;
+  constexpr int delaySamples = 240; // 5ms
+  constexpr int blockSize = 1200;
+
+  uds::DelayBandParams params;
+  params.delayTimeMs = 5.0f;
+  params.feedback = 0.0f;
+  params.loCutHz = 20.0f;
+  params.hiCutHz = 20000.0f;
+
+  auto peakAround = [](const juce::AudioBuffer<float>& buf, int ch,
+                       int centre) {
+    float peak = 0.0f;
+    for (int i = centre - 4; i <= centre + 4; ++i)
+      peak = std::max(peak, std::abs(buf.getSample(ch, i)));
+    return peak;
+  };
+
+  SECTION("8-channel band keeps channels independent") {
+    uds::DelayBandNode<float> band;
+    band.prepare(sampleRate, blockSize, 8);
+    band.setParams(params);
+    REQUIRE(band.getNumChannels() == 8);
+
+    juce::AudioBuffer<float> buf(8, blockSize);
+    buf.clear();
+    buf.setSample(5, 0, 1.0f);
+    band.process(buf, 1.0f);
+
+    // Channel 5 (right side by default) echoes with the right pan gain
+    const float expected = uds::panGainForSide(uds::ChannelSide::Right, 0.0f);
+    REQUIRE(std::abs(buf.getSample(5, delaySamples) - expected) < 1e-4f);
+    for (int ch = 0; ch < 8; ++ch) {
+      if (ch != 5)
+        REQUIRE(peakAround(buf, ch, delaySamples) == 0.0f);
+    }
+  }
+
+  SECTION("Channel mask passes unrouted channels dry") {
+    uds::DelayBandNode<float> band;
+    band.prepare(sampleRate, blockSize, 4);
+    params.channelMask = 0x3u; // front pair only
+    band.setParams(params);
+
+    juce::AudioBuffer<float> buf(4, blockSize);
+    buf.clear();
+    buf.setSample(0, 0, 1.0f);
+    buf.setSample(3, 0, 1.0f);
+    band.process(buf, 1.0f);
+
+    REQUIRE(peakAround(buf, 0, delaySamples) > 0.5f); // routed: echoes
+    REQUIRE(buf.getSample(3, 0) == 1.0f);             // unrouted: dry
+    REQUIRE(peakAround(buf, 3, delaySamples) == 0.0f);
+  }
+
+  SECTION("Ping-pong rotates feedback across routed channels") {
+    uds::DelayBandNode<float> band;
+    band.prepare(sampleRate, blockSize, 4);
+    params.feedback = 0.8f;
+    params.pingPong = true;
+    band.setParams(params);
+
+    juce::AudioBuffer<float> buf(4, blockSize);
+    buf.clear();
+    buf.setSample(0, 0, 1.0f);
+    band.process(buf, 1.0f);
+
+    // Repeat n lands on channel (n - 1) % 4
+    REQUIRE(peakAround(buf, 0, delaySamples) > 0.1f);
+    REQUIRE(peakAround(buf, 1, 2 * delaySamples) > 0.1f);
+    REQUIRE(peakAround(buf, 2, 3 * delaySamples) > 0.1f);
+    REQUIRE(peakAround(buf, 3, 4 * delaySamples) > 0.1f);
+    REQUIRE(peakAround(buf, 2, 2 * delaySamples) == 0.0f);
+  }
+
+  SECTION("Centre channels take the mean pan gain") {
+    const float l = uds::panGainForSide(uds::ChannelSide::Left, 0.5f);
+    const float r = uds::panGainForSide(uds::ChannelSide::Right, 0.5f);
+    const float c = uds::panGainForSide(uds::ChannelSide::Centre, 0.5f);
+    REQUIRE(std::abs(c - 0.5f * (l + r)) < 1e-6f);
+    REQUIRE(uds::defaultChannelSide(0, 1) == uds::ChannelSide::Centre);
+  }
+
+  SECTION("Limiter links N channels and stays bounded") {
+    uds::SafetyLimiter<float> limiter;
+    limiter.prepare(sampleRate);
+
+    juce::AudioBuffer<float> buf(6, 512);
+    for (int ch = 0; ch < 6; ++ch)
+      for (int i = 0; i < 512; ++i)
+        buf.setSample(ch, i, (ch + 1) * 0.8f * std::sin(0.05f * i));
+    limiter.process(buf.getArrayOfWritePointers(), 6, 512);
+
+    for (int ch = 0; ch < 6; ++ch) {
+      for (int i = 0; i < 512; ++i) {
+        REQUIRE(std::isfinite(buf.getSample(ch, i)));
+        REQUIRE(std::abs(buf.getSample(ch, i)) <= 1.0f);
+      }
+    }
+  }
+}
+
+TEST_CASE("Multi-tap delay band", "[dsp][multitap]") {
+  constexpr double sampleRate = 48000.0;
+  constexpr int blockSize = 1024;
+
+  uds::DelayBandParams params;
+  params.delayTimeMs = 5.0f; // 240 samples: feedback loop time
+  params.feedback = 0.5f;
+  params.loCutHz = 20.0f;
+  params.hiCutHz = 20000.0f;
+
+  SECTION("Tap reads the shared line at its own time and level") {
+    uds::DelayBandNode<float> band;
+    band.prepare(sampleRate, blockSize);
+    band.setParams(params);
+
+    uds::DelayTapParams tap;
+    tap.delayTimeMs = 3.0f; // 144 samples
+    tap.level = 0.5f;
+    band.setTaps(&tap, 1);
+    REQUIRE(band.getNumTaps() == 1);
+
+    juce::AudioBuffer<float> buf(2, blockSize);
+    buf.clear();
+    buf.setSample(0, 0, 1.0f);
+    band.process(buf, 1.0f);
+
+    const float panL = uds::panGainForSide(uds::ChannelSide::Left, 0.0f);
+    REQUIRE(std::abs(buf.getSample(0, 144) - 0.5f * panL) < 1e-3f);
+    REQUIRE(std::abs(buf.getSample(0, 240) - panL) < 1e-3f);
+    // Tap also hears the recirculating feedback: 144 + 240
+    REQUIRE(std::abs(buf.getSample(0, 384)) > 0.05f);
+  }
+
+  SECTION("Tap at the band's own time doubles the main head") {
+    uds::DelayBandNode<float> single, tapped;
+    single.prepare(sampleRate, blockSize);
+    tapped.prepare(sampleRate, blockSize);
+    single.setParams(params);
+    tapped.setParams(params);
+
+    uds::DelayTapParams tap;
+    tap.delayTimeMs = params.delayTimeMs;
+    tapped.setTaps(&tap, 1);
+
+    juce::AudioBuffer<float> a(2, blockSize), b(2, blockSize);
+    a.clear();
+    b.clear();
+    a.setSample(0, 0, 1.0f);
+    b.setSample(0, 0, 1.0f);
+    single.process(a, 1.0f);
+    tapped.process(b, 1.0f);
+
+    for (int i = 1; i < blockSize; ++i)
+      REQUIRE(std::abs(b.getSample(0, i) - 2.0f * a.getSample(0, i)) < 1e-5f);
+  }
+
+  SECTION("Clearing taps restores the single-head band") {
+    uds::DelayBandNode<float> band;
+    band.prepare(sampleRate, blockSize);
+    band.setParams(params);
+
+    uds::DelayTapParams tap;
+    band.setTaps(&tap, 1);
+    band.setTaps(nullptr, 0);
+    REQUIRE(band.getNumTaps() == 0);
+  }
+}
+
+TEST_CASE("Interpolation tiers", "[dsp][interpolation]") {
+  constexpr double sampleRate = 48000.0;
+  constexpr int blockSize = 2048;
+  const float panL = uds::panGainForSide(uds::ChannelSide::Left, 0.0f);
+
+  const std::array<uds::InterpolationType, 6> tiers{
+      uds::InterpolationType::None,      uds::InterpolationType::Linear,
+      uds::InterpolationType::Hermite,   uds::InterpolationType::Lagrange6,
+      uds::InterpolationType::Allpass,   uds::InterpolationType::Sinc};
+
+  uds::DelayBandParams params;
+  params.feedback = 0.0f;
+
+  // Peak error of the wet signal against an ideal delayed sine
+  auto sineError = [&](uds::InterpolationType tier, float delayMs,
+                       double freq) {
+    uds::DelayBandNode<double> band;
+    band.prepare(sampleRate, blockSize);
+    auto p = params;
+    p.delayTimeMs = delayMs;
+    p.interpolation = tier;
+    band.setParams(p);
+
+    const double w = 2.0 * 3.14159265358979 * freq / sampleRate;
+    juce::AudioBuffer<double> buf(2, blockSize);
+    for (int i = 0; i < blockSize; ++i) {
+      buf.setSample(0, i, std::sin(w * i));
+      buf.setSample(1, i, 0.0);
+    }
+    band.process(buf, 1.0);
+
+    const double delay = delayMs * 0.001 * sampleRate;
+    double maxError = 0.0;
+    for (int i = blockSize / 2; i < blockSize; ++i) {
+      const double wet = (buf.getSample(0, i) - std::sin(w * i)) / panL;
+      maxError = std::max(maxError, std::abs(wet - std::sin(w * (i - delay))));
+    }
+    return maxError;
+  };
+
+  SECTION("Integer delays are exact for every tier") {
+    for (auto tier : tiers) {
+      uds::DelayBandNode<float> band;
+      band.prepare(sampleRate, blockSize);
+      auto p = params;
+      p.delayTimeMs = 5.0f; // 240 samples
+      p.interpolation = tier;
+      band.setParams(p);
+
+      juce::AudioBuffer<float> buf(2, blockSize);
+      buf.clear();
+      buf.setSample(0, 0, 1.0f);
+      band.process(buf, 1.0f);
+
+      for (int i = 1; i < 480; ++i) {
+        const float expected = i == 240 ? panL : 0.0f;
+        REQUIRE(std::abs(buf.getSample(0, i) - expected) < 1e-5f);
+      }
+    }
+  }
+
+  SECTION("Fractional delays track an ideal delay") {
+    // 240.48 samples: worst case for the rounding and polynomial tiers
+    const float delayMs = 5.01f;
+    REQUIRE(sineError(uds::InterpolationType::None, delayMs, 500.0) > 0.01);
+    for (size_t t = 1; t < tiers.size(); ++t)
+      REQUIRE(sineError(tiers[t], delayMs, 500.0) < 2e-3);
+  }
+
+  SECTION("Higher tiers are more accurate at high frequencies") {
+    const float delayMs = 5.01f;
+    const double linear =
+        sineError(uds::InterpolationType::Linear, delayMs, 8000.0);
+    const double hermite =
+        sineError(uds::InterpolationType::Hermite, delayMs, 8000.0);
+    const double lagrange =
+        sineError(uds::InterpolationType::Lagrange6, delayMs, 8000.0);
+    const double sinc =
+        sineError(uds::InterpolationType::Sinc, delayMs, 8000.0);
+
+    REQUIRE(hermite < linear);
+    REQUIRE(lagrange < hermite);
+    REQUIRE(sinc < lagrange);
+  }
+}
+
+TEST_CASE("Specialized band loops match the full loop", "[dsp][stages]") {
+  using Band = uds::DelayBandNode<float>;
+  constexpr double sampleRate = 48000.0;
+  constexpr int blockSize = 512;
+
+  SECTION("Filters at the range ends are off") {
+    uds::FilterSection<float> filter;
+    filter.prepare(sampleRate);
+    filter.setHiCutFrequency(20000.0f);
+    filter.setLoCutFrequency(20.0f);
+    REQUIRE_FALSE(filter.isActive());
+    for (int i = 0; i < 64; ++i) {
+      float left = std::sin(0.7f * static_cast<float>(i)), right = 0.25f;
+      const float inLeft = left;
+      filter.processSample(left, right);
+      REQUIRE(left == inLeft);
+      REQUIRE(right == 0.25f);
+    }
+    filter.setLoCutFrequency(21.0f);
+    REQUIRE(filter.isActive());
+    filter.setLoCutFrequency(20.0f);
+    filter.setHiCutFrequency(19999.0f);
+    REQUIRE(filter.isActive());
+  }
+
+  // Runs a band over a burst and its tail, with the given stages forced
+  // on; returns both channels of every block and the stages last run
+  auto render = [&](const uds::DelayBandParams& params, int numTaps,
+                    bool modulated, uint32_t forced, uint32_t& stages) {
+    Band band;
+    band.prepare(sampleRate, blockSize);
+    band.setParams(params);
+    std::array<uds::DelayTapParams, 2> taps{};
+    taps[0].delayTimeMs = 7.0f;
+    taps[1].delayTimeMs = 13.0f;
+    taps[1].phaseInvert = true;
+    band.setTaps(taps.data(), numTaps);
+    band.setForcedStages(forced);
+
+    std::vector<float> mod(blockSize), out;
+    juce::AudioBuffer<float> block(2, blockSize);
+    for (int b = 0; b < 8; ++b) {
+      for (int i = 0; i < blockSize; ++i) {
+        const float t = static_cast<float>(b * blockSize + i);
+        const float x = b < 2 ? 0.3f * std::sin(0.05f * t) : 0.0f;
+        block.setSample(0, i, x);
+        block.setSample(1, i, -0.5f * x);
+        mod[static_cast<size_t>(i)] = 0.2f * std::sin(0.002f * t);
+      }
+      band.process(block, 1.0f, modulated ? mod.data() : nullptr, nullptr);
+      for (int ch = 0; ch < 2; ++ch)
+        for (int i = 0; i < blockSize; ++i)
+          out.push_back(block.getSample(ch, i));
+    }
+    stages = band.getActiveStages();
+    return out;
+  };
+
+  uds::DelayBandParams plain;
+  plain.delayTimeMs = 11.0f;
+  plain.feedback = 0.6f;
+  plain.hiCutHz = 20000.0f;
+  plain.loCutHz = 20.0f;
+
+  struct Case {
+    const char* name;
+    uds::DelayBandParams params;
+    int numTaps;
+    bool modulated;
+    uint32_t expected;
+  };
+  std::vector<Case> cases;
+  cases.push_back({"Plain Digital", plain, 0, false, 0u});
+  auto tape = plain;
+  tape.algorithm = uds::DelayAlgorithmType::Tape;
+  tape.hiCutHz = 6000.0f;
+  tape.pingPong = true;
+  cases.push_back({"Tape, filtered, ping-pong", tape, 0, false,
+                   Band::kAlgorithm | Band::kFilter | Band::kPingPong});
+  auto shimmer = plain;
+  shimmer.algorithm = uds::DelayAlgorithmType::Shimmer;
+  shimmer.pitchSemitones = 7.0f;
+  shimmer.phaseInvert = true;
+  cases.push_back({"Shimmer (loop latency)", shimmer, 0, true,
+                   Band::kModulation | Band::kAlgorithm});
+  auto swell = plain;
+  swell.attackTimeMs = 30.0f;
+  swell.interpolation = uds::InterpolationType::Allpass;
+  cases.push_back({"Multi-tap swell, Allpass reads", swell, 2, true,
+                   Band::kModulation | Band::kTaps | Band::kAttack});
+
+  for (const auto& c : cases) {
+    SECTION(c.name) {
+      uint32_t stages = 0, fullStages = 0;
+      const auto specialized =
+          render(c.params, c.numTaps, c.modulated, 0u, stages);
+      REQUIRE(stages == c.expected);
+
+      // Every stage the band does not need, run anyway, is neutral
+      // (kAttack only with the band's own attack)
+      const uint32_t forced = Band::kAllStages & ~Band::kAttack;
+      const auto full =
+          render(c.params, c.numTaps, c.modulated, forced, fullStages);
+      REQUIRE(fullStages == (forced | c.expected));
+
+      float peak = 0.0f, maxError = 0.0f;
+      for (size_t i = 0; i < full.size(); ++i) {
+        peak = std::max(peak, std::abs(full[i]));
+        maxError = std::max(maxError, std::abs(specialized[i] - full[i]));
+      }
+      REQUIRE(peak > 0.1f);
+      REQUIRE(maxError == 0.0f);
+    }
+  }
+}
+
+TEST_CASE("Bands share one analysis of their input", "[dsp][analysis]") {
+  constexpr double sampleRate = 48000.0;
+
+  SECTION("Peak, envelope and onsets") {
+    uds::InputAnalysis<float> analysis;
+    analysis.prepare(sampleRate, 64);
+    juce::AudioBuffer<float> buffer(2, 64);
+    buffer.clear();
+    for (int i = 16; i < 64; ++i) {
+      buffer.setSample(0, i, 0.5f * std::sin(0.3f * static_cast<float>(i)));
+      buffer.setSample(1, i, -0.25f);
+    }
+    analysis.process(buffer, 2, 64);
+    REQUIRE(analysis.getLength() == 64);
+    int onsets = 0;
+    for (int i = 0; i < 64; ++i) {
+      const float expected = std::max(std::abs(buffer.getSample(0, i)),
+                                      std::abs(buffer.getSample(1, i)));
+      REQUIRE(analysis.getPeak()[i] == expected);
+      onsets += analysis.getOnsets()[i];
+    }
+    REQUIRE(onsets == 1);
+    REQUIRE(analysis.getOnsets()[16] == 1);
+    REQUIRE(analysis.getEnvelope()[15] == 0.0f);
+    REQUIRE(analysis.getEnvelope()[63] > 0.2f);
+
+    // Still above the threshold in the next tile: no new onset; then
+    // silence releases slowly
+    for (int i = 0; i < 64; ++i)
+      for (int ch = 0; ch < 2; ++ch)
+        buffer.setSample(ch, i, i < 32 ? 0.25f : 0.0f);
+    analysis.process(buffer, 2, 64);
+    for (int i = 0; i < 64; ++i)
+      REQUIRE(analysis.getOnsets()[i] == 0);
+    REQUIRE(analysis.getEnvelope()[63] > 0.2f);
+    REQUIRE(analysis.getEnvelope()[63] < analysis.getEnvelope()[32]);
+  }
+
+  SECTION("A band given its input peak matches one measuring it") {
+    for (const bool allRouted : {true, false}) {
+      uds::DelayBandParams params;
+      params.algorithm = uds::DelayAlgorithmType::Analog;
+      params.delayTimeMs = 3.0f;
+      params.feedback = 0.5f;
+      params.attackTimeMs = 20.0f;
+      params.lfoDepth = 0.0f;
+      if (!allRouted)
+        params.channelMask = 1;
+      uds::DelayBandNode<float> measured, given;
+      uds::InputAnalysis<float> analysis;
+      for (auto* band : {&measured, &given}) {
+        band->prepare(sampleRate, 128, 2);
+        band->setParams(params);
+      }
+      analysis.prepare(sampleRate, 128);
+
+      float peak = 0.0f, maxError = 0.0f;
+      juce::AudioBuffer<float> a(2, 128), b(2, 128);
+      for (int block = 0; block < 16; ++block) {
+        for (int i = 0; i < 128; ++i) {
+          const float t = static_cast<float>(block * 128 + i);
+          const float x = block % 5 < 2 ? 0.3f * std::sin(0.05f * t) : 0.0f;
+          a.setSample(0, i, x);
+          a.setSample(1, i, 1.3f * x); // Louder than the routed left
+        }
+        b.makeCopyOf(a);
+        analysis.process(b, 2, 128);
+        measured.process(a, 1.0f);
+        given.process(b, 1.0f, nullptr, nullptr, nullptr,
+                      analysis.getPeak());
+        for (int ch = 0; ch < 2; ++ch)
+          for (int i = 0; i < 128; ++i) {
+            peak = std::max(peak, std::abs(a.getSample(ch, i)));
+            maxError = std::max(
+                maxError, std::abs(a.getSample(ch, i) - b.getSample(ch, i)));
+          }
+      }
+      REQUIRE(peak > 0.1f);
+      REQUIRE(maxError == 0.0f);
+    }
+  }
+
+  SECTION("The matrix analyses each input signal once per tile") {
+    constexpr int in = static_cast<int>(uds::NodeId::Input);
+    constexpr int out = static_cast<int>(uds::NodeId::Output);
+    constexpr int blockSize = 256;
+
+    // Bands 1-8 in parallel from the input, bands 9 and 10 sharing the sum
+    // of 1 and 2, band 11 behind a gain (measures its own input)
+    uds::RoutingGraph routing;
+    routing.clearAllConnections();
+    for (int b = 1; b <= 8; ++b) {
+      routing.connect(in, b);
+      routing.connect(b, out);
+    }
+    for (int b = 9; b <= 10; ++b) {
+      routing.connect(1, b);
+      routing.connect(2, b);
+      routing.connect(b, out);
+    }
+    routing.connect(in, 11);
+    routing.setConnectionGain(in, 11, 0.5f);
+    routing.connect(11, out);
+
+    auto run = [&](bool share, bool offline, int* analysed) {
+      uds::DelayMatrix<float> matrix;
+      matrix.prepare(sampleRate, blockSize, 2);
+      matrix.setOfflineQuality(offline);
+      matrix.setShareInputAnalysis(share);
+      for (int b = 0; b < 12; ++b) {
+        uds::DelayBandParams p;
+        p.algorithm = uds::DelayAlgorithmType::Digital;
+        p.delayTimeMs = 2.0f + static_cast<float>(b);
+        p.feedback = 0.2f;
+        p.level = 0.3f;
+        p.lfoDepth = 0.0f;
+        p.attackTimeMs = 5.0f + 10.0f * static_cast<float>(b);
+        matrix.setBandParams(b, p);
+      }
+      std::vector<float> result;
+      juce::AudioBuffer<float> buffer(2, blockSize);
+      for (int block = 0; block < 8; ++block) {
+        for (int i = 0; i < blockSize; ++i) {
+          const float t = static_cast<float>(block * blockSize + i);
+          const float x = block % 3 == 0 ? 0.3f * std::sin(0.02f * t) : 0.0f;
+          buffer.setSample(0, i, x);
+          buffer.setSample(1, i, -x);
+        }
+        matrix.processWithRouting(buffer, 1.0f, routing, 0.0f);
+        for (int ch = 0; ch < 2; ++ch)
+          for (int i = 0; i < blockSize; ++i)
+            result.push_back(buffer.getSample(ch, i));
+      }
+      *analysed = matrix.getAnalysedInputs();
+      if (share) {
+        REQUIRE(matrix.getInputAnalysis(0) == matrix.getInputAnalysis(7));
+        REQUIRE(matrix.getInputAnalysis(8) == matrix.getInputAnalysis(9));
+        REQUIRE(matrix.getInputAnalysis(0) != matrix.getInputAnalysis(8));
+      }
+      REQUIRE(matrix.getInputAnalysis(10) == nullptr);
+      return result;
+    };
+
+    for (const bool offline : {false, true}) {
+      int sharedCount = 0, ownCount = 0;
+      const auto shared = run(true, offline, &sharedCount);
+      const auto own = run(false, offline, &ownCount);
+      REQUIRE(sharedCount == 2); // The input and the (1 + 2) sum
+      REQUIRE(ownCount == 0);
+      float peak = 0.0f, maxError = 0.0f;
+      for (size_t i = 0; i < own.size(); ++i) {
+        peak = std::max(peak, std::abs(own[i]));
+        maxError = std::max(maxError, std::abs(shared[i] - own[i]));
+      }
+      REQUIRE(peak > 0.05f);
+      REQUIRE(maxError == 0.0f);
+    }
+  }
+}
+
+TEST_CASE("CpuGovernor adapts quality to load", "[governor]") {
+  constexpr double sampleRate = 48000.0;
+  constexpr int blockSize = 480; // 10ms budget per block
+  constexpr double budget = blockSize / sampleRate;
+
+  uds::CpuGovernor governor;
+  governor.prepare(sampleRate);
+
+  auto run = [&](double load, double seconds) {
+    const int blocks = static_cast<int>(seconds / budget);
+    for (int b = 0; b < blocks; ++b)
+      governor.update(load * budget, blockSize);
+  };
+
+  SECTION("Starts at full quality") {
+    REQUIRE(governor.getLevel() == uds::QualityLevel::Full);
+    REQUIRE(governor.getReason() == uds::QualityReason::Nominal);
+    run(0.1, 1.0);
+    REQUIRE(governor.getLevel() == uds::QualityLevel::Full);
+    REQUIRE(std::abs(governor.getLoad() - 0.1f) < 0.01f);
+  }
+
+  SECTION("Overload steps down one level per settle period") {
+    run(0.9, 0.3);
+    REQUIRE(governor.getLevel() == uds::QualityLevel::CappedInterpolation);
+    REQUIRE(governor.getReason() == uds::QualityReason::Overload);
+
+    run(0.9, 2.0);
+    REQUIRE(governor.getLevel() == uds::QualityLevel::SleepQuietBands);
+    REQUIRE(governor.getModulationControlStride() ==
+            uds::CpuGovernor::kModulationControlStride);
+    REQUIRE(governor.shouldSleepQuietBands());
+  }
+
+  SECTION("Quality returns only after the hold time (hysteresis)") {
+    run(0.9, 0.3);
+    REQUIRE(governor.getLevel() == uds::QualityLevel::CappedInterpolation);
+
+    // Between the thresholds: hold the reduced level
+    run(0.35, 5.0);
+    REQUIRE(governor.getLevel() == uds::QualityLevel::CappedInterpolation);
+
+    // Below the step-up threshold, but not for long enough yet
+    run(0.1, 1.0);
+    REQUIRE(governor.getLevel() == uds::QualityLevel::CappedInterpolation);
+    REQUIRE(governor.getReason() == uds::QualityReason::Recovering);
+
+    run(0.1, 1.5);
+    REQUIRE(governor.getLevel() == uds::QualityLevel::Full);
+    REQUIRE(governor.getReason() == uds::QualityReason::Nominal);
+  }
+
+  SECTION("Interpolation is capped per level") {
+    using uds::InterpolationType;
+    REQUIRE(governor.limitInterpolation(InterpolationType::Sinc) ==
+            InterpolationType::Sinc);
+    run(0.9, 0.3);
+    REQUIRE(governor.limitInterpolation(InterpolationType::Sinc) ==
+            InterpolationType::Hermite);
+    REQUIRE(governor.limitInterpolation(InterpolationType::Linear) ==
+            InterpolationType::Linear);
+    run(0.9, 0.3);
+    REQUIRE(governor.limitInterpolation(InterpolationType::Hermite) ==
+            InterpolationType::Linear);
+    REQUIRE(governor.limitInterpolation(InterpolationType::None) ==
+            InterpolationType::None);
+  }
+
+  SECTION("Disabled governor stays at full quality") {
+    governor.setEnabled(false);
+    run(2.0, 3.0);
+    REQUIRE(governor.getLevel() == uds::QualityLevel::Full);
+    REQUIRE(governor.getReason() == uds::QualityReason::Disabled);
+  }
+
+  SECTION("Scoped measurement feeds the governor") {
+    { uds::CpuGovernor::ScopedMeasurement measurement(governor, blockSize); }
+    REQUIRE(governor.getLoad() >= 0.0f);
+    REQUIRE(governor.getLoad() < 1.0f);
+  }
+
+  SECTION("Bands report idle once the line has drained") {
+    uds::DelayBandNode<float> band;
+    band.prepare(sampleRate, blockSize);
+    uds::DelayBandParams params;
+    params.delayTimeMs = 5.0f;
+    params.feedback = 0.0f;
+    band.setParams(params);
+    REQUIRE(band.isIdle());
+
+    juce::AudioBuffer<float> buf(2, blockSize);
+    buf.clear();
+    buf.setSample(0, 0, 1.0f);
+    band.process(buf, 1.0f);
+    // The impulse is still reachable by the modulated read head
+    REQUIRE_FALSE(band.isIdle());
+
+    for (int b = 0; b < 10; ++b) {
+      buf.clear();
+      band.process(buf, 1.0f);
+    }
+    REQUIRE(band.isIdle());
+  }
+}
+
+TEST_CASE("Incremental band prepare", "[dsp][prepare]") {
+  constexpr int blockSize = 512;
+  const float panL = uds::panGainForSide(uds::ChannelSide::Left, 0.0f);
+
+  uds::DelayBandNode<float> band;
+  band.prepare(48000.0, blockSize);
+  uds::DelayBandParams params;
+  params.delayTimeMs = 20.0f; // 960 samples: lands in the second block
+  params.feedback = 0.0f;
+  band.setParams(params);
+  const size_t bytesAt48k = band.getAllocatedBytes();
+
+  // Impulse in the first block; returns the echo peak of the next two
+  auto echoAfterPrepare = [&](double rate) {
+    juce::AudioBuffer<float> buf(2, blockSize);
+    buf.clear();
+    buf.setSample(0, 0, 1.0f);
+    band.process(buf, 1.0f);
+    band.prepare(rate, blockSize);
+    float peak = 0.0f;
+    for (int b = 0; b < 2; ++b) {
+      buf.clear();
+      band.process(buf, 1.0f);
+      peak = std::max(peak, buf.getMagnitude(0, 0, blockSize));
+    }
+    return peak;
+  };
+
+  SECTION("Unchanged re-prepare keeps the line and its contents") {
+    REQUIRE(std::abs(echoAfterPrepare(48000.0) - panL) < 1e-4f);
+    REQUIRE(band.getAllocatedBytes() == bytesAt48k);
+  }
+
+  SECTION("Rate change clears the line but reuses the allocation") {
+    REQUIRE(echoAfterPrepare(44100.0) < 1e-6f);
+    REQUIRE(band.getAllocatedBytes() == bytesAt48k);
+
+    // Returning to the original rate still fits
+    band.prepare(48000.0, blockSize);
+    REQUIRE(band.getAllocatedBytes() == bytesAt48k);
+  }
+
+  SECTION("Only a rate increase grows the line") {
+    // At the host rate: a reduced-rate band keeps a 48 kHz line at 96 kHz
+    band.setRateReduction(false);
+    band.prepare(96000.0, blockSize);
+    REQUIRE(band.getAllocatedBytes() > bytesAt48k);
+  }
+}
+
+TEST_CASE("Bands run at a reduced rate at high host rates",
+          "[dsp][multirate]") {
+  SECTION("Halfband stages round-trip with a fixed delay") {
+    // Decimate and interpolate through 1-3 stages in uneven chunks; a
+    // low tone comes back at unity gain, delayed by every stage's filters
+    for (int stages = 1; stages <= 3; ++stages) {
+      std::array<uds::HalfbandDecimator<double>, 3> down;
+      std::array<uds::HalfbandInterpolator<double>, 3> up;
+      for (int s = 0; s < stages; ++s) {
+        down[static_cast<size_t>(s)].prepare(1, 64 >> s);
+        up[static_cast<size_t>(s)].prepare(1, 64 >> (s + 1));
+      }
+      constexpr int total = 1 << 14;
+      constexpr double cycle = 1.0 / 512.0;
+      const double twoPi = 2.0 * 3.14159265358979323846;
+      std::vector<double> x(total), y;
+      for (int n = 0; n < total; ++n)
+        x[static_cast<size_t>(n)] = std::sin(twoPi * cycle * n);
+
+      std::array<std::vector<double>, 2> scratch{std::vector<double>(64),
+                                                 std::vector<double>(64)};
+      std::vector<double> host(64);
+      int pending = 0;
+      for (int start = 0, chunk = 1; start < total;
+           start += chunk, chunk = chunk % 58 + 7) {
+        chunk = std::min(chunk, total - start);
+        const double* in = x.data() + start;
+        int count = chunk;
+        for (int s = 0; s < stages; ++s) {
+          double* out = scratch[static_cast<size_t>(s & 1)].data();
+          count = down[static_cast<size_t>(s)].process(&in, &out, count, 1);
+          in = out;
+        }
+        std::vector<double> low(in, in + count);
+        const double* src = low.data();
+        for (int s = stages - 1; s >= 0; --s) {
+          double* out =
+              s == 0 ? host.data() : scratch[static_cast<size_t>(s & 1)].data();
+          up[static_cast<size_t>(s)].process(&src, &out, count, 1);
+          count *= 2;
+          src = out;
+        }
+        y.insert(y.end(), host.begin(), host.begin() + count);
+        pending += chunk - count;
+      }
+      REQUIRE(pending >= 0);
+      REQUIRE(pending < (1 << stages));
+
+      // Phase and level of the tone over the second half
+      double c = 0.0, si = 0.0;
+      for (int n = total / 2; n < static_cast<int>(y.size()); ++n) {
+        c += y[static_cast<size_t>(n)] * std::cos(twoPi * cycle * n);
+        si += y[static_cast<size_t>(n)] * std::sin(twoPi * cycle * n);
+      }
+      const int factor = 1 << stages;
+      const double expected =
+          (uds::HalfbandDecimator<double>::kDelay +
+           uds::HalfbandInterpolator<double>::kDelay) *
+          (factor - 1);
+      const double delay = std::atan2(-c, si) / (twoPi * cycle);
+      const double level =
+          2.0 * std::hypot(c, si) / (static_cast<int>(y.size()) - total / 2);
+      REQUIRE(std::abs(delay - expected) < 1e-3);
+      REQUIRE(std::abs(level - 1.0) < 1e-3);
+    }
+  }
+
+  SECTION("The factor follows the host rate") {
+    uds::DelayBandNode<float> band;
+    const std::array<std::pair<double, int>, 6> rates{
+        {{44100.0, 1}, {48000.0, 1}, {88200.0, 2}, {96000.0, 2},
+         {192000.0, 4}, {384000.0, 8}}};
+    for (const auto& [rate, factor] : rates) {
+      band.prepare(rate, 256, 2);
+      REQUIRE(band.getRateFactor() == factor);
+    }
+    band.setRateReduction(false);
+    REQUIRE(band.getRateFactor() == 1);
+    band.setRateReduction(true);
+    REQUIRE(band.getRateFactor() == 8);
+    band.setOversampling(true); // Offline quality runs at the host rate
+    REQUIRE(band.getRateFactor() == 1);
+  }
+
+  SECTION("Line memory follows the internal rate") {
+    uds::DelayBandNode<float> full, reduced;
+    full.setRateReduction(false);
+    full.prepare(192000.0, 256, 2);
+    reduced.prepare(192000.0, 256, 2);
+    REQUIRE(reduced.getAllocatedBytes() * 3 < full.getAllocatedBytes());
+  }
+
+  SECTION("Echoes match the host-rate band") {
+    // A smooth 1 kHz burst through a Digital feedback band with the
+    // filters off, in uneven host blocks, with and without a (constant)
+    // LFO offset on the read head
+    for (const double rate : {96000.0, 192000.0, 384000.0}) {
+      for (const bool modulated : {false, true}) {
+        uds::DelayBandParams params;
+        params.algorithm = uds::DelayAlgorithmType::Digital;
+        params.delayTimeMs = 10.0f;
+        params.feedback = 0.5f;
+        params.hiCutHz = 20000.0f;
+        params.loCutHz = 20.0f;
+        params.lfoDepth = 0.0f;
+        uds::DelayBandNode<float> full, reduced;
+        full.setRateReduction(false);
+        for (auto* band : {&full, &reduced}) {
+          band->prepare(rate, 256, 2);
+          band->setParams(params);
+        }
+        REQUIRE(reduced.getRateFactor() > 1);
+
+        const int total = static_cast<int>(0.045 * rate);
+        const int burst = static_cast<int>(0.004 * rate);
+        std::vector<float> mod(256, 0.2f); // +5 ms
+        juce::AudioBuffer<float> a(2, 256), b(2, 256);
+        float peak = 0.0f, maxError = 0.0f;
+        for (int start = 0, block = 97; start < total; start += block) {
+          block = std::min(block, total - start);
+          a.setSize(2, block, false, false, true);
+          for (int i = 0; i < block; ++i) {
+            const int n = start + i;
+            float x = 0.0f;
+            if (n < burst) {
+              const double t = static_cast<double>(n) / rate;
+              const double window =
+                  std::sin(3.14159265358979 * n / burst);
+              x = static_cast<float>(0.5 * window * window *
+                                     std::sin(2.0 * 3.14159265358979 *
+                                              1000.0 * t));
+            }
+            a.setSample(0, i, x);
+            a.setSample(1, i, -0.5f * x);
+          }
+          b.makeCopyOf(a);
+          full.process(a, 1.0f, modulated ? mod.data() : nullptr);
+          reduced.process(b, 1.0f, modulated ? mod.data() : nullptr);
+          for (int ch = 0; ch < 2; ++ch)
+            for (int i = 0; i < block; ++i) {
+              peak = std::max(peak, std::abs(a.getSample(ch, i)));
+              maxError = std::max(maxError, std::abs(a.getSample(ch, i) -
+                                                     b.getSample(ch, i)));
+            }
+        }
+        INFO("rate " << rate << " modulated " << modulated << " error "
+                     << maxError);
+        REQUIRE(peak > 0.2f);
+        REQUIRE(maxError < 2e-4f);
+      }
+    }
+  }
+}
+
+TEST_CASE("Every SIMD tier computes the same results", "[dsp][simd]") {
+  // Forces each tier this machine can run and compares every dispatched
+  // kernel, and a band and limiter built on them, with the SSE2 build
+  struct ClearForcedTier {
+    ~ClearForcedTier() { uds::SimdDispatch::clearForcedTier(); }
+  } clearOnExit;
+
+  const auto supported = uds::SimdDispatch::getSupportedTier();
+  REQUIRE(uds::SimdDispatch::getTier() == supported);
+  if (supported != uds::SimdTier::Avx512)
+    REQUIRE_FALSE(uds::SimdDispatch::forceTier(uds::SimdTier::Avx512));
+  REQUIRE(uds::SimdDispatch::getTier() == supported);
+
+  auto runKernels = [] {
+    constexpr int length = 83; // Not a multiple of any vector width
+    std::array<std::vector<float>, 3> x;
+    for (size_t ch = 0; ch < x.size(); ++ch) {
+      x[ch].resize(length + 16);
+      for (int i = 0; i < length + 16; ++i)
+        x[ch][static_cast<size_t>(i)] =
+            std::sin(0.37f * static_cast<float>(i) * (ch + 1.0f));
+    }
+    x[1][40] = std::numeric_limits<float>::quiet_NaN();
+    const std::array<const float*, 3> channels{
+        {x[0].data() + 16, x[1].data() + 16, x[2].data() + 16}};
+    const std::array<float, 3> gains{{0.5f, -1.25f, 2.0f}};
+    const std::array<float, 16> taps{{0.3f, -0.1f, 0.05f, 0.2f, -0.4f, 0.6f,
+                                      0.01f, -0.02f, 0.7f, 0.1f, -0.3f,
+                                      0.25f, 0.15f, -0.05f, 0.5f, 0.9f}};
+
+    std::vector<float> out(3 * length, 1.0f);
+    uds::FanInMix<float>::run(out.data(), channels.data(), gains.data(), 3,
+                              length);
+    uds::FirAccumulate<float>::run(out.data() + length, channels[0],
+                                   taps.data(), 16, length);
+    uds::PeakScan<float>::run(out.data() + 2 * length, channels.data(), 3,
+                              length);
+
+    std::array<double, length> peak{};
+    std::array<std::vector<double>, 2> wide;
+    for (size_t ch = 0; ch < 2; ++ch)
+      wide[ch].assign(x[ch].begin() + 16, x[ch].end());
+    const std::array<const double*, 2> wideChannels{
+        {wide[0].data(), wide[1].data()}};
+    uds::PeakScan<double>::run(peak.data(), wideChannels.data(), 2, length);
+    for (const double p : peak)
+      out.push_back(static_cast<float>(p));
+
+    // A reduced-rate band (halfband resamplers) into the limiter
+    uds::DelayBandNode<float> band;
+    band.prepare(192000.0, 256, 2);
+    uds::DelayBandParams params;
+    params.delayTimeMs = 2.0f;
+    params.feedback = 0.6f;
+    params.lfoDepth = 0.0f;
+    band.setParams(params);
+    uds::SafetyLimiter<float> limiter;
+    limiter.prepare(192000.0);
+    juce::AudioBuffer<float> buffer(2, 200);
+    for (int block = 0; block < 8; ++block) {
+      for (int ch = 0; ch < 2; ++ch)
+        for (int i = 0; i < 200; ++i)
+          buffer.setSample(ch, i,
+                           1.5f * std::sin(0.05f * (block * 200 + i) +
+                                           static_cast<float>(ch)));
+      band.process(buffer, 1.0f);
+      limiter.process(buffer.getWritePointer(0), buffer.getWritePointer(1),
+                      200);
+      for (int ch = 0; ch < 2; ++ch)
+        for (int i = 0; i < 200; ++i)
+          out.push_back(buffer.getSample(ch, i));
+    }
+    return out;
+  };
+
+  REQUIRE(uds::SimdDispatch::forceTier(uds::SimdTier::Sse2));
+  const auto reference = runKernels();
+  REQUIRE_FALSE(std::isnan(reference[2 * 83 + 24])); // Peak skips the NaN
+
+  for (const auto tier : {uds::SimdTier::Avx2, uds::SimdTier::Avx512}) {
+    if (!uds::SimdDispatch::forceTier(tier))
+      continue; // Not available on this machine
+    REQUIRE(uds::SimdDispatch::getTier() == tier);
+    const auto result = runKernels();
+    REQUIRE(result.size() == reference.size());
+    // Fused multiply-adds round differently (the limiter's gain tracking
+    // carries that into about 2e-5 here); anything more is a bug
+    int mismatches = 0;
+    for (size_t i = 0; i < result.size(); ++i) {
+      const bool same = std::isnan(reference[i])
+                            ? std::isnan(result[i])
+                            : std::abs(result[i] - reference[i]) <= 1.0e-4f;
+      mismatches += same ? 0 : 1;
+    }
+    INFO(uds::SimdDispatch::getTierName(tier));
+    REQUIRE(mismatches == 0);
+  }
+
+  uds::SimdDispatch::clearForcedTier();
+  REQUIRE(uds::SimdDispatch::getTier() == supported);
+}
+
+TEST_CASE("Delay line reset clears the written span", "[dsp][prepare]") {
+  // 1 kHz keeps the 10.5s line short enough to wrap in a test
+  constexpr double sampleRate = 1000.0;
+  constexpr int blockSize = 256;
+
+  uds::DelayBandNode<float> band;
+  band.prepare(sampleRate, blockSize);
+  uds::DelayBandParams params;
+  params.delayTimeMs = 100.0f;
+  params.feedback = 0.5f;
+  band.setParams(params);
+
+  juce::AudioBuffer<float> buf(2, blockSize);
+  auto runLoud = [&](int numBlocks) {
+    for (int b = 0; b < numBlocks; ++b) {
+      for (int i = 0; i < blockSize; ++i) {
+        buf.setSample(0, i, 0.5f);
+        buf.setSample(1, i, -0.5f);
+      }
+      band.process(buf, 1.0f);
+    }
+  };
+  // Peak output over a full line length of silence
+  auto silentPeak = [&]() {
+    float peak = 0.0f;
+    for (int b = 0; b < 11000 / blockSize; ++b) {
+      buf.clear();
+      band.process(buf, 1.0f);
+      peak = std::max(peak, buf.getMagnitude(0, blockSize));
+    }
+    return peak;
+  };
+
+  SECTION("Partly written line") {
+    runLoud(2);
+    band.reset();
+    REQUIRE(silentPeak() == 0.0f);
+  }
+
+  SECTION("Line written past its end (wrapped)") {
+    runLoud(60);
+    band.reset();
+    REQUIRE(silentPeak() == 0.0f);
+  }
+
+  SECTION("Rate change clears in the old layout") {
+    runLoud(60);
+    band.prepare(sampleRate * 0.5, blockSize, 1);
+    band.prepare(sampleRate, blockSize, 2);
+    REQUIRE(silentPeak() == 0.0f);
+  }
+}
+
+TEST_CASE("DelayMemory provides pre-faulted zeroed lines", "[dsp][memory]") {
+  constexpr size_t numElements = 1 << 20; // 4 MB of float
+
+  SECTION("Allocation is zeroed and pre-faulted") {
+    uds::DelayMemory<float> memory;
+    REQUIRE(memory.allocate(numElements));
+    REQUIRE(memory.size() == numElements);
+    REQUIRE(memory.getStatus().bytes == numElements * sizeof(float));
+    REQUIRE(memory.getStatus().prefaulted);
+    for (size_t i = 0; i < numElements; i += 997)
+      REQUIRE(memory.data()[i] == 0.0f);
+  }
+
+  SECTION("Only growth reallocates") {
+    uds::DelayMemory<float> memory;
+    memory.allocate(numElements);
+    memory.data()[5] = 1.0f;
+    REQUIRE_FALSE(memory.allocate(numElements / 2));
+    REQUIRE(memory.data()[5] == 1.0f);
+    REQUIRE(memory.allocate(numElements * 2));
+    REQUIRE(memory.data()[5] == 0.0f);
+  }
+
+  SECTION("Lock outcome is reported either way") {
+    uds::DelayMemoryOptions options;
+    options.lock = true;
+    uds::DelayMemory<float> memory;
+    memory.allocate(numElements, options);
+    const auto& status = memory.getStatus();
+    REQUIRE(status.locked != status.lockFailed);
+
+    memory.release();
+    REQUIRE(memory.empty());
+    REQUIRE_FALSE(memory.getStatus().locked);
+  }
+
+  SECTION("Bands report their line's status") {
+    uds::DelayBandNode<float> band;
+    band.prepare(48000.0, 512);
+    REQUIRE(band.getMemoryStatus().prefaulted);
+    REQUIRE(band.getMemoryStatus().bytes == band.getAllocatedBytes());
+
+    uds::DelayMemoryStatus total;
+    total += band.getMemoryStatus();
+    total += band.getMemoryStatus();
+    REQUIRE(total.bytes == 2 * band.getAllocatedBytes());
+    REQUIRE(total.prefaulted);
+  }
+
+  SECTION("Locking is opt-in and can be switched after prepare") {
+    uds::DelayMatrix<float> matrix;
+    matrix.prepare(48000.0, 512, 2);
+    auto status = matrix.getMemoryStatus();
+    REQUIRE(status.prefaulted);
+    REQUIRE_FALSE(status.locked);
+    REQUIRE_FALSE(status.lockFailed);
+
+    uds::DelayMemoryOptions options;
+    options.lock = true;
+    matrix.setMemoryOptions(options);
+    status = matrix.getMemoryStatus();
+    REQUIRE(status.prefaulted);
+    REQUIRE((status.locked || status.lockFailed));
+
+    matrix.setMemoryOptions(uds::DelayMemoryOptions{});
+    status = matrix.getMemoryStatus();
+    REQUIRE_FALSE(status.locked);
+    REQUIRE_FALSE(status.lockFailed);
+  }
+
+  SECTION("Locking can be switched with a shared arena attached") {
+    auto arena = uds::DelayArena::acquire();
+    uds::DelayMemoryOptions options;
+    options.arena = arena;
+    uds::DelayMatrix<float> matrix;
+    matrix.setMemoryOptions(options);
+    matrix.prepare(48000.0, 512, 2);
+    REQUIRE_FALSE(matrix.getMemoryStatus().locked);
+    REQUIRE_FALSE(matrix.getMemoryStatus().lockFailed);
+
+    // The unlocked blocks just handed back must not be reused
+    options.lock = true;
+    matrix.setMemoryOptions(options);
+    auto status = matrix.getMemoryStatus();
+    REQUIRE(status.bytes > 0);
+    REQUIRE((status.locked || status.lockFailed));
+
+    options.lock = false;
+    matrix.setMemoryOptions(options);
+    status = matrix.getMemoryStatus();
+    REQUIRE(status.bytes > 0);
+    REQUIRE_FALSE(status.locked);
+    REQUIRE_FALSE(status.lockFailed);
+
+    matrix.release();
+    arena->trim();
+  }
+}
+
+TEST_CASE("DelayArena shares delay-line blocks", "[dsp][memory]") {
+  constexpr size_t blockBytes = size_t(1) << 20;
+  auto arena = uds::DelayArena::acquire();
+  REQUIRE(uds::DelayArena::acquire() == arena);
+  arena->setSpareLimit(uds::DelayArena::kDefaultSpareLimit);
+  arena->trim();
+  uds::DelayMemoryOptions options;
+
+  SECTION("Returned blocks are zeroed and reused") {
+    void* first = nullptr;
+    {
+      auto block = arena->checkout(blockBytes, options);
+      REQUIRE(block);
+      first = block->data();
+      static_cast<float*>(first)[10] = 1.0f;
+      REQUIRE(arena->getStats().inUseBytes == blockBytes);
+      REQUIRE(arena->getStats().numLeases == 1);
+    }
+    REQUIRE(arena->getStats().inUseBytes == 0);
+    REQUIRE(arena->getStats().spareBytes == blockBytes);
+
+    auto again = arena->checkout(blockBytes, options);
+    REQUIRE(again->data() == first);
+    REQUIRE(static_cast<float*>(again->data())[10] == 0.0f);
+    REQUIRE(arena->getStats().spareBytes == 0);
+  }
+
+  SECTION("Spares beyond the limit go back to the OS") {
+    arena->setSpareLimit(0);
+    { auto block = arena->checkout(blockBytes, options); }
+    REQUIRE(arena->getStats().spareBytes == 0);
+    REQUIRE(arena->getStats().inUseBytes == 0);
+  }
+
+  SECTION("Bands detach and re-attach their line") {
+    options.arena = arena;
+    uds::DelayBandNode<float> band;
+    band.setMemoryOptions(options);
+    band.prepare(48000.0, 512);
+    const size_t lineBytes = band.getAllocatedBytes();
+    REQUIRE(arena->getStats().inUseBytes == lineBytes);
+
+    band.setLineResident(false);
+    REQUIRE_FALSE(band.isLineResident());
+    REQUIRE(arena->getStats().inUseBytes == 0);
+
+    // Detached: audio passes through untouched
+    juce::AudioBuffer<float> buf(2, 512);
+    buf.clear();
+    buf.setSample(0, 0, 1.0f);
+    band.process(buf, 1.0f);
+    REQUIRE(buf.getSample(0, 0) == 1.0f);
+    REQUIRE(buf.getMagnitude(0, 1, 511) == 0.0f);
+
+    // Stays detached across an unchanged or changed re-prepare
+    band.prepare(44100.0, 512);
+    REQUIRE_FALSE(band.isLineResident());
+
+    band.setLineResident(true);
+    REQUIRE(band.isLineResident());
+    REQUIRE(arena->getStats().inUseBytes == band.getAllocatedBytes());
+  }
+
+  SECTION("Resetting a band while its line detaches is safe") {
+    options.arena = arena;
+    uds::DelayBandNode<float> band;
+    band.setMemoryOptions(options);
+    band.prepare(48000.0, 512);
+
+    juce::AudioBuffer<float> buf(2, 512);
+    std::atomic<bool> done{false};
+    std::thread toggler([&] {
+      for (int i = 0; i < 200; ++i)
+        band.setLineResident(i % 2 != 0);
+      done.store(true);
+    });
+    // reset() clears what was written, racing the detach on the other
+    // thread; the line lock keeps it off a block already handed back
+    while (!done.load()) {
+      buf.clear();
+      buf.setSample(0, 0, 1.0f);
+      band.process(buf, 1.0f);
+      band.reset();
+      (void)band.isPureDelay();
+    }
+    toggler.join();
+    REQUIRE(band.isLineResident());
+    REQUIRE(arena->getStats().inUseBytes == band.getAllocatedBytes());
+  }
+
+  arena->setSpareLimit(uds::DelayArena::kDefaultSpareLimit);
+  arena->trim();
 }
 
 TEST_CASE("RoutingGraph integrity", "[routing][boundary]") {
@@ -1007,6 +2584,1228 @@ TEST_CASE("RoutingGraph integrity", "[routing][boundary]") {
 
     REQUIRE(b2FeedsOutput == false);
   }
+
+  SECTION("Feedback loops are scheduled as one component") {
+    graph.clearAllConnections();
+
+    // Input -> B1 <-> B2 -> Output
+    graph.connect(0, 1);
+    graph.connect(1, 2);
+    graph.connect(2, 1);
+    graph.connect(2, 13);
+
+    // Nodes in the loop are no longer dropped from the order
+    auto order = graph.getProcessingOrder();
+    REQUIRE(order == std::vector<int>{0, 1, 2, 13});
+
+    const auto& components = graph.getComponents();
+    REQUIRE(components.size() == 3);
+    REQUIRE_FALSE(components[0].cyclic);
+    REQUIRE(components[1].cyclic);
+    REQUIRE(components[1].nodes == std::vector<int>{1, 2});
+    REQUIRE_FALSE(components[2].cyclic);
+
+    // The edge back to the loop entry carries the delayed feedback
+    REQUIRE(graph.isFeedbackEdge(2, 1));
+    REQUIRE_FALSE(graph.isFeedbackEdge(1, 2));
+    REQUIRE_FALSE(graph.isFeedbackEdge(2, 13));
+  }
+
+  SECTION("Loop entry follows the external input") {
+    graph.clearAllConnections();
+
+    // Input enters the B1 -> B2 -> B3 -> B1 loop at B3
+    graph.connect(0, 3);
+    graph.connect(1, 2);
+    graph.connect(2, 3);
+    graph.connect(3, 1);
+    graph.connect(2, 13);
+
+    const auto& components = graph.getComponents();
+    REQUIRE(components.size() == 3);
+    REQUIRE(components[1].nodes == std::vector<int>{3, 1, 2});
+    REQUIRE(graph.isFeedbackEdge(2, 3));
+    REQUIRE_FALSE(graph.isFeedbackEdge(3, 1));
+  }
+
+  SECTION("Acyclic routing has no feedback edges") {
+    graph.setSeriesRouting();
+
+    for (const auto& component : graph.getComponents())
+      REQUIRE_FALSE(component.cyclic);
+    REQUIRE_FALSE(graph.isFeedbackEdge(1, 2));
+  }
+}
+
+TEST_CASE("Tail length follows bands, feedback and routing",
+          "[routing][tail]") {
+  constexpr int in = static_cast<int>(uds::NodeId::Input);
+  constexpr int out = static_cast<int>(uds::NodeId::Output);
+  std::array<uds::DelayBandParams, 12> bands{};
+  for (auto& band : bands) {
+    band.delayTimeMs = 500.0f;
+    band.feedback = 0.5f;
+    band.level = 1.0f;
+  }
+  // 15 echoes reach -80 dB at 50% feedback
+  const double single = 15 * 0.5;
+
+  uds::RoutingGraph graph;
+  graph.clearAllConnections();
+
+  SECTION("Dry routing has no tail") {
+    graph.connect(in, out);
+    REQUIRE(uds::TailLength::matrixSeconds(bands, graph) == 0.0);
+  }
+
+  SECTION("One band rings until its echoes fall below the floor") {
+    graph.connect(in, 1);
+    graph.connect(1, out);
+    REQUIRE(std::abs(uds::TailLength::matrixSeconds(bands, graph) - single) <
+            1.0e-9);
+
+    bands[0].feedback = 0.0f;
+    REQUIRE(std::abs(uds::TailLength::matrixSeconds(bands, graph) - 0.5) <
+            1.0e-9);
+
+    bands[0].enabled = false;
+    REQUIRE(uds::TailLength::matrixSeconds(bands, graph) == 0.0);
+  }
+
+  SECTION("Series bands add, parallel bands take the longest") {
+    graph.connect(in, 1);
+    graph.connect(1, 2);
+    graph.connect(2, out);
+    graph.connect(in, 3);
+    graph.connect(3, out);
+    REQUIRE(std::abs(uds::TailLength::matrixSeconds(bands, graph) -
+                     2.0 * single) < 1.0e-9);
+
+    bands[2].delayTimeMs = 4000.0f;
+    REQUIRE(std::abs(uds::TailLength::matrixSeconds(bands, graph) -
+                     15 * 4.0) < 1.0e-9);
+  }
+
+  SECTION("Unreachable bands do not count") {
+    graph.connect(in, out);
+    graph.connect(1, out);
+    REQUIRE(uds::TailLength::matrixSeconds(bands, graph) == 0.0);
+  }
+
+  SECTION("Self-sustaining feedback is infinite") {
+    graph.connect(in, 1);
+    graph.connect(1, out);
+    bands[0].feedback = 1.0f;
+    REQUIRE(std::isinf(uds::TailLength::matrixSeconds(bands, graph)));
+  }
+
+  SECTION("Band loops decay only when the loop gain is below one") {
+    graph.connect(in, 1);
+    graph.connect(1, 2);
+    graph.connect(2, 1);
+    graph.connect(2, out);
+    REQUIRE(graph.hasCycles());
+    REQUIRE(graph.isFeedbackEdge(2, 1));
+    // Echoes sum to up to level / (1 - feedback) = 2; band 1 also passes
+    // its input on (3), band 2 feeds back only its echoes (2)
+    REQUIRE(std::isinf(uds::TailLength::matrixSeconds(bands, graph)));
+
+    bands[0].level = 0.2f;
+    bands[1].level = 0.2f; // Loop gain 1.4 * 0.4 = 0.56
+    const double tail = uds::TailLength::matrixSeconds(bands, graph);
+    REQUIRE(std::isfinite(tail));
+    REQUIRE(tail > 2.0 * single);
+
+    // Connection gains count towards the loop gain, in either polarity
+    graph.setConnectionGain(2, 1, -2.0f); // Loop gain 1.12
+    REQUIRE(std::isinf(uds::TailLength::matrixSeconds(bands, graph)));
+    graph.setConnectionGain(2, 1, 0.5f);
+    REQUIRE(uds::TailLength::matrixSeconds(bands, graph) < tail);
+  }
+
+  SECTION("A loop through a muted band still rings") {
+    graph.connect(in, 1);
+    graph.connect(1, 2);
+    graph.connect(2, 1);
+    graph.connect(2, out);
+    bands[0].level = 0.0f; // Passes band 2's echoes straight back
+    bands[1].level = 0.9f;
+    bands[1].feedback = 0.3f;
+    bands[1].delayTimeMs = 80.0f;
+
+    // The echoes stay above -80 dB for about 5.5 s, far more than one
+    // trip round the loop
+    for (int b = 0; b < 12; ++b)
+      bands[static_cast<size_t>(b)].enabled = b < 2;
+    REQUIRE(uds::TailLength::matrixSeconds(bands, graph) > 5.5);
+
+    // So the matrix is not skipped while they ring
+    constexpr int blockSize = 480;
+    uds::DelayMatrix<float> matrix;
+    matrix.prepare(48000.0, blockSize, 2);
+    for (int b = 0; b < 12; ++b)
+      matrix.setBandParams(b, bands[static_cast<size_t>(b)]);
+    juce::AudioBuffer<float> block(2, blockSize);
+    float late = 0.0f;
+    for (int n = 0; n < 300; ++n) {
+      block.clear();
+      if (n == 0) {
+        block.setSample(0, 0, 0.5f);
+        block.setSample(1, 0, 0.5f);
+      }
+      matrix.processWithRouting(block, 1.0f, graph, 0.0f);
+      if (n >= 200) // 2 to 3 s
+        late = std::max(late, block.getMagnitude(0, blockSize));
+    }
+    REQUIRE(matrix.getTailLengthSeconds() > 5.5);
+    REQUIRE(late > 1.0e-4f);
+  }
+
+  SECTION("Zero-gain connections carry no tail") {
+    graph.connect(in, 1);
+    graph.connect(1, out);
+    graph.connect(in, out);
+    graph.setConnectionGain(in, 1, 0.0f);
+    REQUIRE(uds::TailLength::matrixSeconds(bands, graph) == 0.0);
+  }
+}
+
+TEST_CASE("Silent matrix skips processing until input returns",
+          "[routing][tail]") {
+  constexpr double sampleRate = 48000.0;
+  constexpr int blockSize = 480;
+  uds::DelayMatrix<float> matrix;
+  matrix.prepare(sampleRate, blockSize, 2);
+  uds::DelayBandParams params;
+  params.delayTimeMs = 50.0f;
+  params.feedback = 0.2f;
+  params.lfoDepth = 0.0f;
+  for (int b = 0; b < uds::DelayMatrix<float>::MAX_BANDS; ++b) {
+    params.enabled = b == 0;
+    matrix.setBandParams(b, params);
+  }
+
+  uds::RoutingGraph graph;
+  graph.clearAllConnections();
+  graph.connect(static_cast<int>(uds::NodeId::Input), 1);
+  graph.connect(1, static_cast<int>(uds::NodeId::Output));
+
+  juce::AudioBuffer<float> block(2, blockSize);
+  auto run = [&](bool impulse) {
+    block.clear();
+    if (impulse) {
+      block.setSample(0, 0, 0.5f);
+      block.setSample(1, 0, 0.5f);
+    }
+    matrix.processWithRouting(block, 1.0f, graph, 0.0f);
+    return block.getMagnitude(0, blockSize);
+  };
+
+  run(true);
+  REQUIRE_FALSE(matrix.isSilent());
+  // 50 ms echoes at 20% feedback are below -90 dB within a second
+  int blocks = 0;
+  while (!matrix.isSilent() && blocks < 200) {
+    run(false);
+    ++blocks;
+  }
+  REQUIRE(matrix.isSilent());
+  REQUIRE(blocks < 150);
+  REQUIRE(matrix.getTailLengthSeconds() < 1.0);
+
+  REQUIRE(run(false) == 0.0f);
+  REQUIRE(matrix.isSilent());
+
+  // A new note wakes the matrix and its echo arrives on time
+  run(true);
+  REQUIRE_FALSE(matrix.isSilent());
+  for (int b = 1; b < 5; ++b)
+    run(false);
+  REQUIRE(run(false) > 0.1f); // Block 5 starts at the 50 ms echo
+}
+
+TEST_CASE("Mono engine matches the stereo engine at half the memory",
+          "[routing][mono]") {
+  constexpr double sampleRate = 48000.0;
+  constexpr int blockSize = 256;
+  uds::DelayMatrix<float> mono, stereo;
+  mono.prepare(sampleRate, blockSize, 1);
+  stereo.prepare(sampleRate, blockSize, 2);
+  REQUIRE(mono.getNumChannels() == 1);
+
+  uds::DelayBandParams params;
+  params.delayTimeMs = 30.0f;
+  params.feedback = 0.6f;
+  params.algorithm = uds::DelayAlgorithmType::Tape;
+  params.lfoDepth = 0.0f;
+  for (int b = 0; b < uds::DelayMatrix<float>::MAX_BANDS; ++b) {
+    params.enabled = b < 2;
+    mono.setBandParams(b, params);
+    stereo.setBandParams(b, params);
+  }
+  uds::RoutingGraph graph;
+  graph.clearAllConnections();
+  graph.connect(static_cast<int>(uds::NodeId::Input), 1);
+  graph.connect(1, 2);
+  graph.connect(2, static_cast<int>(uds::NodeId::Output));
+
+  const auto monoBytes = mono.getMemoryStatus().bytes;
+  const auto stereoBytes = stereo.getMemoryStatus().bytes;
+  REQUIRE(monoBytes > 0);
+  REQUIRE(monoBytes * 3 < stereoBytes * 2); // Lines are most of it
+
+  juce::AudioBuffer<float> monoBlock(1, blockSize), stereoBlock(2, blockSize);
+  float maxError = 0.0f;
+  for (int b = 0; b < 40; ++b) {
+    for (int i = 0; i < blockSize; ++i) {
+      const float x =
+          b < 4 ? 0.4f * std::sin(0.05f * static_cast<float>(b * blockSize + i))
+                : 0.0f;
+      monoBlock.setSample(0, i, x);
+      stereoBlock.setSample(0, i, x);
+      stereoBlock.setSample(1, i, x);
+    }
+    mono.processWithRouting(monoBlock, 0.8f, graph);
+    stereo.processWithRouting(stereoBlock, 0.8f, graph);
+    for (int i = 0; i < blockSize; ++i)
+      maxError = std::max(maxError, std::abs(monoBlock.getSample(0, i) -
+                                             stereoBlock.getSample(0, i)));
+  }
+  // Centre and left pan gains agree at pan 0 to rounding
+  REQUIRE(maxError < 1.0e-5f);
+}
+
+TEST_CASE("Tiled matrix is independent of the host block size",
+          "[routing][tiles]") {
+  constexpr double sampleRate = 48000.0;
+  constexpr int preparedBlock = 256;
+  constexpr int hostBlock = 4096; // Larger than prepared
+  uds::DelayMatrix<float> large, small;
+  large.prepare(sampleRate, preparedBlock, 2);
+  small.prepare(sampleRate, preparedBlock, 2);
+
+  uds::DelayBandParams params;
+  params.feedback = 0.4f;
+  params.lfoDepth = 0.0f;
+  for (int b = 0; b < uds::DelayMatrix<float>::MAX_BANDS; ++b) {
+    params.enabled = b < 3;
+    params.delayTimeMs = 10.0f + 7.0f * static_cast<float>(b);
+    large.setBandParams(b, params);
+    small.setBandParams(b, params);
+  }
+  // A series chain plus a feedback loop between bands 2 and 3
+  uds::RoutingGraph graph;
+  graph.clearAllConnections();
+  graph.connect(static_cast<int>(uds::NodeId::Input), 1);
+  graph.connect(1, 2);
+  graph.connect(2, 3);
+  graph.connect(3, 2);
+  graph.connect(3, static_cast<int>(uds::NodeId::Output));
+  graph.connect(1, static_cast<int>(uds::NodeId::Output));
+
+  juce::AudioBuffer<float> input(2, hostBlock * 3);
+  for (int i = 0; i < input.getNumSamples(); ++i) {
+    const float x = i < hostBlock
+                        ? 0.4f * std::sin(0.03f * static_cast<float>(i))
+                        : 0.0f;
+    input.setSample(0, i, x);
+    input.setSample(1, i, -x);
+  }
+
+  float maxError = 0.0f;
+  float peak = 0.0f;
+  juce::AudioBuffer<float> bigBlock(2, hostBlock), smallBlock(2, preparedBlock);
+  for (int block = 0; block < 3; ++block) {
+    const int offset = block * hostBlock;
+    for (int ch = 0; ch < 2; ++ch)
+      bigBlock.copyFrom(ch, 0, input, ch, offset, hostBlock);
+    large.processWithRouting(bigBlock, 0.7f, graph);
+
+    for (int sub = 0; sub < hostBlock; sub += preparedBlock) {
+      for (int ch = 0; ch < 2; ++ch)
+        smallBlock.copyFrom(ch, 0, input, ch, offset + sub, preparedBlock);
+      small.processWithRouting(smallBlock, 0.7f, graph);
+      for (int ch = 0; ch < 2; ++ch)
+        for (int i = 0; i < preparedBlock; ++i) {
+          const float expected = smallBlock.getSample(ch, i);
+          peak = std::max(peak, std::abs(expected));
+          maxError = std::max(
+              maxError, std::abs(bigBlock.getSample(ch, sub + i) - expected));
+        }
+    }
+  }
+  REQUIRE(peak > 0.1f);
+  REQUIRE(maxError < 1.0e-6f);
+}
+
+// Run the same bands and graph with the given plan passes and with none
+// (the graph as drawn); returns the largest output difference. peak gets
+// the largest reference sample, so callers can check the test is not
+// comparing silence. Comparison stops once the optimized matrix has gone
+// silent: bands it dropped no longer keep it awake, so it is skipped
+// (output = input) while the reference still adds the limiter's residue.
+inline float planPassError(
+    const std::array<uds::DelayBandParams, 12>& bands,
+    const uds::RoutingGraph& graph, uint32_t passes, float& peak,
+    uds::DelayMatrix<float>* inspect = nullptr, bool offline = false) {
+  constexpr double sampleRate = 48000.0;
+  constexpr int blockSize = 256;
+  uds::DelayMatrix<float> optimized, reference;
+  for (auto* matrix : {&optimized, &reference}) {
+    matrix->prepare(sampleRate, blockSize, 2);
+    matrix->setOfflineQuality(offline);
+    for (int b = 0; b < 12; ++b)
+      matrix->setBandParams(b, bands[static_cast<size_t>(b)]);
+  }
+  optimized.setPlanPasses(passes);
+  reference.setPlanPasses(0);
+
+  juce::AudioBuffer<float> a(2, blockSize), b(2, blockSize);
+  float maxError = 0.0f;
+  peak = 0.0f;
+  for (int block = 0; block < 40; ++block) {
+    for (int i = 0; i < blockSize; ++i) {
+      const float t = static_cast<float>(block * blockSize + i);
+      const float x = block < 6 ? 0.4f * std::sin(0.021f * t) : 0.0f;
+      a.setSample(0, i, x);
+      a.setSample(1, i, 0.5f * x);
+    }
+    b.makeCopyOf(a);
+    if (optimized.isSilent())
+      break;
+    optimized.processWithRouting(a, 0.8f, graph);
+    reference.processWithRouting(b, 0.8f, graph);
+    for (int ch = 0; ch < 2; ++ch)
+      for (int i = 0; i < blockSize; ++i) {
+        peak = std::max(peak, std::abs(b.getSample(ch, i)));
+        maxError = std::max(maxError,
+                            std::abs(a.getSample(ch, i) - b.getSample(ch, i)));
+      }
+  }
+  if (inspect != nullptr) {
+    inspect->prepare(sampleRate, blockSize, 2);
+    for (int bnd = 0; bnd < 12; ++bnd)
+      inspect->setBandParams(bnd, bands[static_cast<size_t>(bnd)]);
+    inspect->setPlanPasses(passes);
+    for (int i = 0; i < blockSize; ++i)
+      for (int ch = 0; ch < 2; ++ch)
+        a.setSample(ch, i, 0.1f); // Not silent, so the plan is compiled
+    inspect->processWithRouting(a, 0.8f, graph);
+  }
+  return maxError;
+}
+
+TEST_CASE("Routing plan passes match the graph as drawn",
+          "[routing][plan]") {
+  using Plan = uds::RoutingPlan;
+  using Role = Plan::Role;
+  constexpr int in = static_cast<int>(uds::NodeId::Input);
+  constexpr int out = static_cast<int>(uds::NodeId::Output);
+
+  // Bands that no pass can simplify unless a section says otherwise
+  std::array<uds::DelayBandParams, 12> bands{};
+  for (int b = 0; b < 12; ++b) {
+    auto& p = bands[static_cast<size_t>(b)];
+    p.delayTimeMs = 11.0f + 4.0f * static_cast<float>(b);
+    p.feedback = 0.4f;
+    p.lfoDepth = 0.0f;
+    p.algorithm = uds::DelayAlgorithmType::Tape;
+  }
+  uds::RoutingGraph graph;
+  graph.clearAllConnections();
+  uds::DelayMatrix<float> inspect;
+  float peak = 0.0f;
+
+  SECTION("Constant zero: muted and disabled bands") {
+    graph.connect(in, 1);
+    graph.connect(1, out);
+    graph.connect(in, 2); // Disabled wire fed by the input
+    graph.connect(2, 3);  // Muted wire
+    graph.connect(3, out);
+    graph.connect(4, 5); // Disabled band with no inputs feeds a muted one
+    graph.connect(5, out);
+    graph.connect(in, 6); // Loop closed through a disabled band
+    graph.connect(6, 7);
+    graph.connect(7, 6);
+    graph.connect(7, out);
+    bands[1].enabled = false;
+    bands[2].level = 0.0f;
+    bands[3].enabled = false;
+    bands[4].level = 0.0f;
+    bands[6].enabled = false;
+
+    const float error =
+        planPassError(bands, graph, Plan::kConstantZero, peak, &inspect);
+    REQUIRE(peak > 0.1f);
+    REQUIRE(error < 1.0e-7f);
+    const auto& plan = inspect.getPlan();
+    REQUIRE(plan.getRole(1) == Role::Band);
+    REQUIRE(plan.getRole(2) == Role::Wire);
+    REQUIRE(plan.getRole(3) == Role::Wire);
+    REQUIRE(plan.getRole(4) == Role::Skip);
+    REQUIRE(plan.getRole(5) == Role::Skip);
+    REQUIRE(plan.getRole(6) == Role::Band);
+    REQUIRE(plan.getRole(7) == Role::Wire);
+    REQUIRE(plan.getNumInputs(6) == 1); // The wire's feedback edge is gone
+  }
+
+  SECTION("Dead bands") {
+    graph.connect(in, 1);
+    graph.connect(1, out);
+    graph.connect(in, 2); // Loop that never reaches the output
+    graph.connect(2, 3);
+    graph.connect(3, 2);
+    graph.connect(1, 4); // Branch into nowhere
+
+    const float error =
+        planPassError(bands, graph, Plan::kDeadBands, peak, &inspect);
+    REQUIRE(peak > 0.1f);
+    REQUIRE(error < 1.0e-7f);
+    const auto& plan = inspect.getPlan();
+    REQUIRE(plan.getRole(1) == Role::Band);
+    REQUIRE(plan.getRole(2) == Role::Skip);
+    REQUIRE(plan.getRole(3) == Role::Skip);
+    REQUIRE(plan.getRole(4) == Role::Skip);
+  }
+
+  SECTION("Fused pure-delay chains") {
+    // Four feedback-free Digital bands in series: the first three fuse
+    // (kMaxFused), the fourth runs on its own
+    graph.connect(in, 1);
+    for (int node = 1; node < 4; ++node)
+      graph.connect(node, node + 1);
+    graph.connect(4, out);
+    graph.connect(in, out);
+    const std::array<float, 4> times{{10.0f, 15.0f, 20.0f, 5.0f}};
+    for (int b = 0; b < 4; ++b) {
+      auto& p = bands[static_cast<size_t>(b)];
+      p.algorithm = uds::DelayAlgorithmType::Digital;
+      p.feedback = 0.0f;
+      p.delayTimeMs = times[static_cast<size_t>(b)];
+      p.level = 0.9f - 0.15f * static_cast<float>(b);
+      p.pan = b == 1 ? 0.4f : -0.2f;
+    }
+    bands[2].phaseInvert = true;
+    bands[1].channelMask = 1u; // Left only
+
+    const float error =
+        planPassError(bands, graph, Plan::kFuseDelays, peak, &inspect);
+    REQUIRE(peak > 0.1f);
+    REQUIRE(error < 1.0e-6f);
+    const auto& plan = inspect.getPlan();
+    REQUIRE(plan.getRole(1) == Role::Skip);
+    REQUIRE(plan.getRole(2) == Role::Skip);
+    REQUIRE(plan.getRole(3) == Role::Fused);
+    REQUIRE(plan.getChainLength(3) == 3);
+    REQUIRE(plan.getChainBand(3, 0) == 1);
+    REQUIRE(plan.getRole(4) == Role::Band);
+    REQUIRE(plan.ownsLine(1));
+    REQUIRE_FALSE(plan.ownsLine(2));
+
+    // Feedback on the second band breaks the chain: the first runs alone,
+    // the third and fourth fuse
+    bands[1].feedback = 0.3f;
+    REQUIRE(planPassError(bands, graph, Plan::kFuseDelays, peak, &inspect) <
+            1.0e-6f);
+    REQUIRE(inspect.getPlan().getRole(1) == Role::Band);
+    REQUIRE(inspect.getPlan().getRole(2) == Role::Band);
+    REQUIRE(inspect.getPlan().getRole(4) == Role::Fused);
+    REQUIRE(inspect.getPlan().getChainBand(4, 0) == 3);
+  }
+
+  SECTION("Shared fan-in sums") {
+    graph.connect(in, 1);
+    graph.connect(in, 2);
+    for (int dest : {3, 4, 5}) {
+      graph.connect(1, dest);
+      graph.connect(2, dest);
+      graph.connect(dest, out);
+    }
+
+    const float error =
+        planPassError(bands, graph, Plan::kShareFanIn, peak, &inspect);
+    REQUIRE(peak > 0.1f);
+    REQUIRE(error < 1.0e-6f);
+    const auto& plan = inspect.getPlan();
+    REQUIRE(plan.getFanInGroup(3) >= 0);
+    REQUIRE(plan.getFanInGroup(4) == plan.getFanInGroup(3));
+    REQUIRE(plan.getFanInGroup(5) == plan.getFanInGroup(3));
+    REQUIRE(plan.getFanInGroup(1) < 0);
+    REQUIRE(plan.getNumFanInGroups() == 1);
+  }
+
+  SECTION("All passes together, live and offline") {
+    graph.connect(in, 1);
+    graph.connect(1, 2);
+    graph.connect(2, out);
+    graph.connect(in, 3);
+    graph.connect(in, 4);
+    graph.connect(3, 5);
+    graph.connect(4, 5);
+    graph.connect(3, 6);
+    graph.connect(4, 6);
+    graph.connect(5, out);
+    graph.connect(6, out);
+    graph.connect(6, 7); // Dead
+    graph.connect(in, 8); // Muted
+    graph.connect(8, out);
+    for (int b : {0, 1}) {
+      bands[static_cast<size_t>(b)].algorithm =
+          uds::DelayAlgorithmType::Digital;
+      bands[static_cast<size_t>(b)].feedback = 0.0f;
+    }
+    bands[7].level = 0.0f;
+
+    for (const bool offline : {false, true}) {
+      const float error = planPassError(bands, graph, Plan::kAllPasses, peak,
+                                        nullptr, offline);
+      REQUIRE(peak > 0.1f);
+      REQUIRE(error < 1.0e-6f);
+    }
+  }
+
+  SECTION("A muted band records while muted and plays it when unmuted") {
+    graph.connect(in, 1);
+    graph.connect(1, out);
+    graph.connect(in, 2);
+    graph.connect(2, out);
+    bands[0].delayTimeMs = 40.0f;
+    bands[0].feedback = 0.6f;
+    bands[0].level = 0.0f;
+
+    constexpr int blockSize = 256;
+    uds::DelayMatrix<float> optimized, reference;
+    for (auto* matrix : {&optimized, &reference}) {
+      matrix->prepare(48000.0, blockSize, 2);
+      for (int b = 0; b < 12; ++b)
+        matrix->setBandParams(b, bands[static_cast<size_t>(b)]);
+    }
+    optimized.setPlanPasses(Plan::kAllPasses);
+    reference.setPlanPasses(0);
+
+    // A burst while band 1 is muted, then its level automated back up
+    juce::AudioBuffer<float> a(2, blockSize), b(2, blockSize);
+    float maxError = 0.0f, unmutedPeak = 0.0f;
+    for (int block = 0; block < 60; ++block) {
+      if (block == 12) {
+        bands[0].level = 0.8f;
+        optimized.setBandParams(0, bands[0]);
+        reference.setBandParams(0, bands[0]);
+      }
+      for (int i = 0; i < blockSize; ++i) {
+        const float t = static_cast<float>(block * blockSize + i);
+        const float x = block < 6 ? 0.4f * std::sin(0.021f * t) : 0.0f;
+        a.setSample(0, i, x);
+        a.setSample(1, i, -0.5f * x);
+      }
+      b.makeCopyOf(a);
+      optimized.processWithRouting(a, 1.0f, graph, 0.0f);
+      reference.processWithRouting(b, 1.0f, graph, 0.0f);
+      for (int ch = 0; ch < 2; ++ch)
+        for (int i = 0; i < blockSize; ++i) {
+          if (block >= 12)
+            unmutedPeak = std::max(unmutedPeak, std::abs(b.getSample(ch, i)));
+          maxError = std::max(
+              maxError, std::abs(a.getSample(ch, i) - b.getSample(ch, i)));
+        }
+    }
+    REQUIRE(unmutedPeak > 0.02f); // The echoes built up while muted
+    REQUIRE(maxError < 1.0e-6f);
+  }
+
+  SECTION("A fused chain breaking mid-render keeps the echoes in flight") {
+    graph.connect(in, 1);
+    graph.connect(1, 2);
+    graph.connect(2, out);
+    for (int b = 0; b < 2; ++b) {
+      auto& p = bands[static_cast<size_t>(b)];
+      p.algorithm = uds::DelayAlgorithmType::Digital;
+      p.feedback = 0.0f;
+      p.delayTimeMs = b == 0 ? 100.0f : 200.0f;
+    }
+
+    constexpr int blockSize = 256;
+    uds::DelayMatrix<float> optimized, reference;
+    for (auto* matrix : {&optimized, &reference}) {
+      matrix->prepare(48000.0, blockSize, 2);
+      for (int b = 0; b < 12; ++b)
+        matrix->setBandParams(b, bands[static_cast<size_t>(b)]);
+    }
+    optimized.setPlanPasses(Plan::kAllPasses);
+    reference.setPlanPasses(0);
+
+    // Feedback on band 2 breaks the chain while its echo is in flight
+    juce::AudioBuffer<float> a(2, blockSize), b(2, blockSize);
+    float maxError = 0.0f, peak = 0.0f;
+    for (int block = 0; block < 90; ++block) {
+      if (block == 30) {
+        REQUIRE(optimized.getPlan().getRole(2) == Role::Fused);
+        bands[1].feedback = 0.3f;
+        optimized.setBandParams(1, bands[1]);
+        reference.setBandParams(1, bands[1]);
+      }
+      for (int i = 0; i < blockSize; ++i) {
+        const float t = static_cast<float>(block * blockSize + i);
+        const float x = block < 6 ? 0.4f * std::sin(0.021f * t) : 0.0f;
+        a.setSample(0, i, x);
+        a.setSample(1, i, -0.5f * x);
+      }
+      b.makeCopyOf(a);
+      optimized.processWithRouting(a, 1.0f, graph, 0.0f);
+      reference.processWithRouting(b, 1.0f, graph, 0.0f);
+      for (int ch = 0; ch < 2; ++ch)
+        for (int i = 0; i < blockSize; ++i) {
+          if (block >= 30)
+            peak = std::max(peak, std::abs(b.getSample(ch, i)));
+          maxError = std::max(
+              maxError, std::abs(a.getSample(ch, i) - b.getSample(ch, i)));
+        }
+    }
+    REQUIRE(optimized.getPlan().getRole(2) == Role::Band);
+    REQUIRE(peak > 0.1f); // The 200 ms echo and its repeats
+    REQUIRE(maxError < 1.0e-6f);
+  }
+
+  SECTION("A band coming back clears its line a slice per block") {
+    constexpr int blockSize = 480;
+    uds::DelayMatrix<float> matrix;
+    matrix.prepare(48000.0, blockSize, 2);
+    matrix.setRoutingFadeMs(0.0f);
+    for (int b = 0; b < 12; ++b) {
+      bands[static_cast<size_t>(b)].enabled = b == 0;
+      matrix.setBandParams(b, bands[static_cast<size_t>(b)]);
+    }
+    graph.connect(in, 1);
+    graph.connect(1, out);
+    uds::RoutingGraph dead;
+    dead.clearAllConnections();
+    dead.connect(in, 1); // Cannot reach the output
+
+    juce::AudioBuffer<float> block(2, blockSize);
+    auto run = [&](const uds::RoutingGraph& routing, float first) {
+      block.clear();
+      block.setSample(0, 0, first);
+      block.setSample(1, 0, first);
+      matrix.processWithRouting(block, 1.0f, routing, 0.0f);
+      return block.getMagnitude(0, blockSize);
+    };
+
+    // 4 s of signal, one block dead, then back: far more line than one
+    // block's budget, so the band passes audio through while it clears
+    for (int b = 0; b < 400; ++b)
+      run(graph, 0.5f);
+    run(dead, 0.5f);
+    REQUIRE(matrix.isBandParked(0));
+    run(graph, 0.25f);
+    REQUIRE(std::abs(block.getSample(0, 0) - 0.25f) < 1.0e-3f);
+    REQUIRE(matrix.isBandParked(0));
+    for (int b = 0; b < 10; ++b)
+      REQUIRE(run(graph, 0.0f) < 1.0e-3f); // Nothing replayed
+
+    // Clean by now: it rejoins with the next input and delays again
+    run(graph, 0.5f);
+    REQUIRE_FALSE(matrix.isBandParked(0));
+    REQUIRE(run(graph, 0.0f) > 0.1f);
+  }
+}
+
+// Wet output of a matrix (dry level 0) running the graph over a short
+// burst, all blocks appended
+inline std::vector<float> wetOutput(
+    const std::array<uds::DelayBandParams, 12>& bands,
+    const uds::RoutingGraph& graph, uint32_t passes) {
+  constexpr int blockSize = 256;
+  uds::DelayMatrix<float> matrix;
+  matrix.prepare(48000.0, blockSize, 2);
+  for (int b = 0; b < 12; ++b)
+    matrix.setBandParams(b, bands[static_cast<size_t>(b)]);
+  matrix.setPlanPasses(passes);
+
+  std::vector<float> result;
+  juce::AudioBuffer<float> buffer(2, blockSize);
+  for (int block = 0; block < 20; ++block) {
+    for (int i = 0; i < blockSize; ++i) {
+      const float t = static_cast<float>(block * blockSize + i);
+      const float x = block < 4 ? 0.2f * std::sin(0.017f * t) : 0.0f;
+      buffer.setSample(0, i, x);
+      buffer.setSample(1, i, -0.5f * x);
+    }
+    matrix.processWithRouting(buffer, 1.0f, graph, 0.0f);
+    for (int ch = 0; ch < 2; ++ch)
+      for (int i = 0; i < blockSize; ++i)
+        result.push_back(buffer.getSample(ch, i));
+  }
+  return result;
+}
+
+TEST_CASE("Connection gains scale and invert what they carry",
+          "[routing][gain]") {
+  constexpr int in = static_cast<int>(uds::NodeId::Input);
+  constexpr int out = static_cast<int>(uds::NodeId::Output);
+  using Plan = uds::RoutingPlan;
+
+  SECTION("Fan-in kernel matches a per-source sum") {
+    constexpr int length = 37; // Two chunks and a remainder
+    std::array<std::array<float, length>, 5> sources{};
+    for (size_t k = 0; k < sources.size(); ++k)
+      for (int i = 0; i < length; ++i)
+        sources[k][static_cast<size_t>(i)] =
+            std::sin(0.3f * static_cast<float>(i) + static_cast<float>(k));
+    const std::array<float, 5> gains{{1.0f, -0.5f, 2.0f, 0.25f, -1.0f}};
+    std::array<const float*, 5> pointers{};
+    for (size_t k = 0; k < sources.size(); ++k)
+      pointers[k] = sources[k].data();
+
+    for (int n = 0; n <= 5; ++n) {
+      std::array<float, length> dest{};
+      dest.fill(9.0f); // Overwritten, not accumulated
+      uds::FanInMix<float>::run(dest.data(), pointers.data(), gains.data(),
+                                n, length);
+      float maxError = 0.0f;
+      for (int i = 0; i < length; ++i) {
+        float expected = 0.0f;
+        for (int k = 0; k < n; ++k)
+          expected += gains[static_cast<size_t>(k)] *
+                      sources[static_cast<size_t>(k)][static_cast<size_t>(i)];
+        maxError = std::max(maxError,
+                            std::abs(dest[static_cast<size_t>(i)] - expected));
+      }
+      REQUIRE(maxError < 1.0e-6f);
+    }
+  }
+
+  SECTION("Graph stores, clamps and saves gains") {
+    uds::RoutingGraph graph;
+    graph.clearAllConnections();
+    graph.connect(in, 1);
+    graph.connect(1, out);
+    REQUIRE(graph.getConnectionGain(in, 1) == 1.0f);
+    REQUIRE(graph.setConnectionGain(1, out, -0.5f));
+    REQUIRE(graph.getConnectionGain(1, out) == -0.5f);
+    REQUIRE(graph.setConnectionGain(in, 1, 100.0f));
+    REQUIRE(graph.getConnectionGain(in, 1) ==
+            uds::RoutingGraph::kMaxConnectionGain);
+    REQUIRE_FALSE(graph.setConnectionGain(2, out, 0.5f));
+    REQUIRE(graph.getConnectionGain(2, out) == 0.0f);
+
+    graph.setConnectionGain(in, 1, 1.0f);
+    auto xml = graph.toXml();
+    uds::RoutingGraph restored;
+    restored.fromXml(xml.get());
+    REQUIRE(restored.getConnections().size() == 2);
+    REQUIRE(restored.getConnectionGain(in, 1) == 1.0f);
+    REQUIRE(std::abs(restored.getConnectionGain(1, out) + 0.5f) < 1.0e-6f);
+    for (auto* conn : xml->getChildWithTagNameIterator("Connection"))
+      REQUIRE(conn->hasAttribute("gain") ==
+              (conn->getIntAttribute("source") == 1));
+  }
+
+  // Linear bands, so connection gains multiply through
+  std::array<uds::DelayBandParams, 12> bands{};
+  for (int b = 0; b < 12; ++b) {
+    auto& p = bands[static_cast<size_t>(b)];
+    p.algorithm = uds::DelayAlgorithmType::Digital;
+    p.delayTimeMs = 9.0f + 3.0f * static_cast<float>(b);
+    p.feedback = 0.3f;
+    p.level = 0.5f; // Loops decay well inside the limiter's threshold
+    p.lfoDepth = 0.0f;
+  }
+  auto maxDifference = [](const std::vector<float>& a,
+                          const std::vector<float>& b, float scale) {
+    float peak = 0.0f, error = 0.0f;
+    for (size_t i = 0; i < a.size(); ++i) {
+      peak = std::max(peak, std::abs(b[i]));
+      error = std::max(error, std::abs(a[i] - scale * b[i]));
+    }
+    REQUIRE(peak > 0.05f);
+    return error;
+  };
+
+  SECTION("Inverted parallel paths cancel") {
+    bands[1] = bands[0];
+    uds::RoutingGraph graph;
+    graph.clearAllConnections();
+    graph.connect(in, 1);
+    graph.connect(in, 2);
+    graph.connect(1, out);
+    graph.connect(2, out);
+    const auto together = wetOutput(bands, graph, Plan::kAllPasses);
+    graph.setConnectionGain(2, out, -1.0f);
+    for (const uint32_t passes : {0u, Plan::kAllPasses}) {
+      const auto cancelled = wetOutput(bands, graph, passes);
+      REQUIRE(maxDifference(cancelled, together, 0.0f) < 1.0e-6f);
+    }
+  }
+
+  SECTION("Gains multiply along a path, loops included") {
+    uds::RoutingGraph unity;
+    unity.clearAllConnections();
+    unity.connect(in, 1);
+    unity.connect(1, 2);
+    unity.connect(2, 1); // Feedback loop
+    unity.connect(2, 3);
+    unity.connect(in, 3);
+    unity.connect(3, out);
+    uds::RoutingGraph scaled = unity;
+    scaled.setConnectionGain(in, 1, 0.5f);
+    scaled.setConnectionGain(in, 3, 0.5f);
+    scaled.setConnectionGain(3, out, -1.6f); // Within the limiter's slew
+
+    const auto reference = wetOutput(bands, unity, 0);
+    for (const uint32_t passes : {0u, Plan::kAllPasses})
+      REQUIRE(maxDifference(wetOutput(bands, scaled, passes), reference,
+                            -0.8f) < 1.0e-5f);
+  }
+
+  SECTION("A zero-gain feedback edge is no edge") {
+    uds::RoutingGraph open;
+    open.clearAllConnections();
+    open.connect(in, 1);
+    open.connect(1, 2);
+    open.connect(2, out);
+    uds::RoutingGraph closed = open;
+    closed.connect(2, 1);
+    closed.setConnectionGain(2, 1, 0.0f);
+
+    // Without the plan passes the edge is mixed in at gain 0
+    REQUIRE(maxDifference(wetOutput(bands, closed, 0),
+                          wetOutput(bands, open, 0), 1.0f) < 1.0e-6f);
+    closed.setConnectionGain(2, 1, -0.7f);
+    REQUIRE(maxDifference(wetOutput(bands, closed, 0),
+                          wetOutput(bands, open, 0), 1.0f) > 1.0e-3f);
+  }
+}
+
+// Wet output of a matrix (dry level 0) that runs `from` for kSwitchBlock
+// blocks of a steady tone and `to` after that, all blocks appended.
+// fading gets isRoutingFading() after each block.
+constexpr int kSwitchBlock = 4;
+inline std::vector<float> switchedOutput(
+    const std::array<uds::DelayBandParams, 12>& bands,
+    const uds::RoutingGraph& from, const uds::RoutingGraph& to, float fadeMs,
+    bool offline, std::vector<bool>* fading = nullptr) {
+  constexpr int blockSize = 256;
+  uds::DelayMatrix<float> matrix;
+  matrix.prepare(48000.0, blockSize, 2);
+  matrix.setOfflineQuality(offline);
+  for (int b = 0; b < 12; ++b)
+    matrix.setBandParams(b, bands[static_cast<size_t>(b)]);
+  matrix.setRoutingFadeMs(fadeMs);
+
+  std::vector<float> result;
+  juce::AudioBuffer<float> buffer(2, blockSize);
+  for (int block = 0; block < 12; ++block) {
+    for (int i = 0; i < blockSize; ++i) {
+      const float t = static_cast<float>(block * blockSize + i);
+      const float x = 0.2f * std::sin(0.013f * t);
+      buffer.setSample(0, i, x);
+      buffer.setSample(1, i, 0.5f * x);
+    }
+    matrix.processWithRouting(buffer, 1.0f, block < kSwitchBlock ? from : to,
+                              0.0f);
+    for (int ch = 0; ch < 2; ++ch)
+      for (int i = 0; i < blockSize; ++i)
+        result.push_back(buffer.getSample(ch, i));
+    if (fading != nullptr)
+      fading->push_back(matrix.isRoutingFading());
+  }
+  return result;
+}
+
+TEST_CASE("Routing changes crossfade between plans", "[routing][fade]") {
+  constexpr int in = static_cast<int>(uds::NodeId::Input);
+  constexpr int out = static_cast<int>(uds::NodeId::Output);
+  constexpr int blockSize = 256;
+  constexpr float fadeMs = 12.5f; // 600 samples: ends inside block 6
+  constexpr int fadeLength = 600;
+
+  SECTION("Fade time is clamped") {
+    uds::DelayMatrix<float> matrix;
+    REQUIRE(matrix.getRoutingFadeMs() ==
+            uds::DelayMatrix<float>::kDefaultRoutingFadeMs);
+    matrix.setRoutingFadeMs(1000.0f);
+    REQUIRE(matrix.getRoutingFadeMs() ==
+            uds::DelayMatrix<float>::kMaxRoutingFadeMs);
+    matrix.setRoutingFadeMs(-1.0f);
+    REQUIRE(matrix.getRoutingFadeMs() == 0.0f);
+  }
+
+  // Linear bands: a shared feedback loop (1, 2), a shared series chain
+  // (5 -> 6, fused by the plan) and one band swapped for another (3 -> 4)
+  std::array<uds::DelayBandParams, 12> bands{};
+  for (int b = 0; b < 12; ++b) {
+    auto& p = bands[static_cast<size_t>(b)];
+    p.algorithm = uds::DelayAlgorithmType::Digital;
+    p.delayTimeMs = 4.0f + 3.0f * static_cast<float>(b);
+    p.feedback = b == 4 || b == 5 ? 0.0f : 0.3f;
+    p.level = 0.4f;
+    p.lfoDepth = 0.0f;
+  }
+  uds::RoutingGraph before;
+  before.clearAllConnections();
+  before.connect(in, 1);
+  before.connect(1, 2);
+  before.connect(2, 1);
+  before.connect(2, out);
+  before.connect(in, 5);
+  before.connect(5, 6);
+  before.connect(6, out);
+  uds::RoutingGraph after = before;
+  before.connect(in, 3);
+  before.connect(3, out);
+  after.connect(in, 4);
+  after.connect(4, out);
+  after.setConnectionGain(2, out, -0.5f);
+
+  for (const bool offline : {false, true}) {
+    const auto kept = switchedOutput(bands, before, before, 0.0f, offline);
+    const auto instant = switchedOutput(bands, before, after, 0.0f, offline);
+    std::vector<bool> fading;
+    const auto faded =
+        switchedOutput(bands, before, after, fadeMs, offline, &fading);
+
+    SECTION(std::string("Output is the linear mix of both plans") +
+            (offline ? " (offline)" : "")) {
+      // The plans are mixed ahead of the limiter, whose 10 Hz DC blocker
+      // (y[n] = x[n] - x[n-1] + c y[n-1]) is undone to compare them.
+      // Exact only if the outgoing plan reuses the shared bands' echoes
+      // instead of running their lines a second time.
+      auto preLimiter = [&](const std::vector<float>& wet) {
+        const double c = 1.0 - 2.0 * 3.14159265359 * 10.0 / 48000.0;
+        std::vector<double> result(wet.size());
+        for (int ch = 0; ch < 2; ++ch) {
+          double x = 0.0, y = 0.0;
+          for (int block = 0; block < 12; ++block)
+            for (int i = 0; i < blockSize; ++i) {
+              const auto index =
+                  static_cast<size_t>((block * 2 + ch) * blockSize + i);
+              x += wet[index] - c * y;
+              y = wet[index];
+              result[index] = x;
+            }
+        }
+        return result;
+      };
+      const auto keptIn = preLimiter(kept);
+      const auto instantIn = preLimiter(instant);
+      const auto fadedIn = preLimiter(faded);
+
+      double maxError = 0.0;
+      for (int ch = 0; ch < 2; ++ch)
+        for (int block = 0; block < 12; ++block)
+          for (int i = 0; i < blockSize; ++i) {
+            const auto index =
+                static_cast<size_t>((block * 2 + ch) * blockSize + i);
+            const int pos = (block - kSwitchBlock) * blockSize + i + 1;
+            const double amount =
+                std::clamp(pos / static_cast<double>(fadeLength), 0.0, 1.0);
+            const double expected =
+                keptIn[index] + amount * (instantIn[index] - keptIn[index]);
+            maxError = std::max(maxError, std::abs(fadedIn[index] - expected));
+          }
+      REQUIRE(maxError < 1.0e-5);
+    }
+
+    SECTION(std::string("Fade ends after its length") +
+            (offline ? " (offline)" : "")) {
+      for (int block = 0; block < 12; ++block)
+        REQUIRE(fading[static_cast<size_t>(block)] ==
+                (block >= kSwitchBlock &&
+                 (block - kSwitchBlock + 1) * blockSize < fadeLength));
+    }
+
+    SECTION(std::string("No jump where an instant switch clicks") +
+            (offline ? " (offline)" : "")) {
+      // Largest sample-to-sample step (left channel) across the switch
+      auto jump = [&](const std::vector<float>& wet) {
+        const auto first = static_cast<size_t>(kSwitchBlock * 2 * blockSize);
+        float largest = std::abs(wet[first] - wet[first - blockSize - 1]);
+        for (size_t i = first + 1; i < first + blockSize; ++i)
+          largest = std::max(largest, std::abs(wet[i] - wet[i - 1]));
+        return largest;
+      };
+      REQUIRE(jump(instant) > 0.02f);
+      REQUIRE(jump(faded) < 0.25f * jump(instant));
+    }
+  }
+
+  SECTION("A second change mid-fade waits instead of cutting the fade") {
+    // before -> after at block 4, then -> third at block 5 while the first
+    // fade (600 samples) is under half way
+    uds::RoutingGraph third = after;
+    third.connect(in, 7);
+    third.connect(7, out);
+    third.setConnectionGain(6, out, -1.0f);
+
+    auto render = [&](float ms, std::vector<bool>* fading) {
+      uds::DelayMatrix<float> matrix;
+      matrix.prepare(48000.0, blockSize, 2);
+      for (int b = 0; b < 12; ++b)
+        matrix.setBandParams(b, bands[static_cast<size_t>(b)]);
+      matrix.setRoutingFadeMs(ms);
+      std::vector<float> left;
+      juce::AudioBuffer<float> buffer(2, blockSize);
+      for (int block = 0; block < 12; ++block) {
+        for (int i = 0; i < blockSize; ++i) {
+          const float t = static_cast<float>(block * blockSize + i);
+          const float x = 0.2f * std::sin(0.013f * t);
+          buffer.setSample(0, i, x);
+          buffer.setSample(1, i, 0.5f * x);
+        }
+        const auto& routing = block < kSwitchBlock       ? before
+                              : block == kSwitchBlock ? after
+                                                      : third;
+        matrix.processWithRouting(buffer, 1.0f, routing, 0.0f);
+        for (int i = 0; i < blockSize; ++i)
+          left.push_back(buffer.getSample(0, i));
+        if (fading != nullptr)
+          fading->push_back(matrix.isRoutingFading());
+      }
+      return left;
+    };
+    // Largest sample-to-sample step across the start of block 5
+    auto step = [&](const std::vector<float>& wet) {
+      const auto first = static_cast<size_t>((kSwitchBlock + 1) * blockSize);
+      float largest = 0.0f;
+      for (size_t i = first; i < first + 8; ++i)
+        largest = std::max(largest, std::abs(wet[i] - wet[i - 1]));
+      return largest;
+    };
+
+    std::vector<bool> fading;
+    const auto instant = render(0.0f, nullptr);
+    const auto faded = render(fadeMs, &fading);
+    REQUIRE(step(instant) > 0.02f);
+    REQUIRE(step(faded) < 0.1f * step(instant));
+
+    // The held change fades in once the first fade is done (block 6)
+    REQUIRE(fading[static_cast<size_t>(kSwitchBlock + 1)]);
+    REQUIRE(fading[static_cast<size_t>(kSwitchBlock + 3)]);
+  }
+}
+
+TEST_CASE("Bypass modes: spill and hard", "[routing][bypass]") {
+  constexpr double sampleRate = 48000.0;
+  constexpr int blockSize = 480;
+  uds::DelayMatrix<float> matrix;
+  matrix.prepare(sampleRate, blockSize, 2);
+  uds::DelayBandParams params;
+  params.delayTimeMs = 50.0f; // Echoes every 5 blocks
+  params.feedback = 0.5f;
+  params.lfoDepth = 0.0f;
+  for (int b = 0; b < uds::DelayMatrix<float>::MAX_BANDS; ++b) {
+    params.enabled = b == 0;
+    matrix.setBandParams(b, params);
+  }
+
+  uds::RoutingGraph graph;
+  graph.clearAllConnections();
+  graph.connect(static_cast<int>(uds::NodeId::Input), 1);
+  graph.connect(1, static_cast<int>(uds::NodeId::Output));
+
+  juce::AudioBuffer<float> block(2, blockSize);
+  auto fill = [&](float first) {
+    block.clear();
+    block.setSample(0, 0, first);
+    block.setSample(1, 0, first);
+  };
+
+  // One impulse through the running matrix
+  fill(0.5f);
+  matrix.processWithRouting(block, 1.0f, graph, 0.0f);
+
+  SECTION("Spill rings out old echoes, passes new input dry") {
+    // A second impulse while bypassed is passed through, not delayed
+    fill(0.25f);
+    matrix.processTails(block, 1.0f, graph);
+    // (plus the limiter's DC-blocker settling from the first impulse)
+    REQUIRE(std::abs(block.getSample(0, 0) - 0.25f) < 1.0e-3f);
+
+    // The first impulse's echo still arrives at 50 ms...
+    float echo = 0.0f;
+    for (int b = 2; b <= 5; ++b) {
+      fill(0.0f);
+      matrix.processTails(block, 1.0f, graph);
+      echo = block.getMagnitude(0, blockSize);
+    }
+    REQUIRE(echo > 0.1f);
+
+    // ...and once it has decayed, bypass costs nothing: nothing is written
+    int blocks = 0;
+    while (!matrix.isSilent() && blocks < 400) {
+      fill(0.0f);
+      matrix.processTails(block, 1.0f, graph);
+      ++blocks;
+    }
+    REQUIRE(matrix.isSilent());
+
+    // Nothing of the bypassed impulse was written to the line
+    for (int b = 0; b < 10; ++b) {
+      fill(0.0f);
+      matrix.processWithRouting(block, 1.0f, graph, 0.0f);
+      REQUIRE(block.getMagnitude(0, blockSize) == 0.0f);
+    }
+  }
+
+  SECTION("Hard bypass leaves the buffer alone and resumes clean") {
+    fill(0.25f);
+    matrix.processHardBypass();
+    REQUIRE(block.getSample(0, 0) == 0.25f);
+    REQUIRE(block.getMagnitude(0, blockSize) == 0.25f);
+
+    matrix.resumeFromHardBypass();
+    for (int b = 0; b < 12; ++b) {
+      fill(0.0f);
+      matrix.processWithRouting(block, 1.0f, graph, 0.0f);
+      REQUIRE(block.getMagnitude(0, blockSize) == 0.0f);
+    }
+
+    // And delays normally again
+    fill(0.5f);
+    matrix.processWithRouting(block, 1.0f, graph, 0.0f);
+    for (int b = 1; b < 5; ++b) {
+      fill(0.0f);
+      matrix.processWithRouting(block, 1.0f, graph, 0.0f);
+    }
+    fill(0.0f);
+    matrix.processWithRouting(block, 1.0f, graph, 0.0f);
+    REQUIRE(block.getMagnitude(0, blockSize) > 0.1f);
+  }
+
+  SECTION("A short hard bypass after a long run resumes in constant time") {
+    // 4 s of signal fills far more line than one bypass block clears
+    for (int b = 0; b < 400; ++b) {
+      fill(0.5f);
+      matrix.processWithRouting(block, 1.0f, graph, 0.0f);
+    }
+    matrix.processHardBypass();
+    matrix.resumeFromHardBypass();
+    REQUIRE(matrix.isBandParked(0));
+
+    // The band passes audio through while its line is cleared a slice per
+    // block (silent blocks too), never replaying what was there...
+    fill(0.25f);
+    matrix.processWithRouting(block, 1.0f, graph, 0.0f);
+    REQUIRE(std::abs(block.getSample(0, 0) - 0.25f) < 1.0e-3f);
+    REQUIRE(matrix.isBandParked(0));
+    for (int b = 0; b < 10; ++b) {
+      fill(0.0f);
+      matrix.processWithRouting(block, 1.0f, graph, 0.0f);
+      REQUIRE(block.getMagnitude(0, blockSize) < 1.0e-3f);
+    }
+
+    // ...then rejoins with the next input and delays normally
+    fill(0.5f);
+    matrix.processWithRouting(block, 1.0f, graph, 0.0f);
+    REQUIRE_FALSE(matrix.isBandParked(0));
+    for (int b = 1; b < 5; ++b) {
+      fill(0.0f);
+      matrix.processWithRouting(block, 1.0f, graph, 0.0f);
+    }
+    fill(0.0f);
+    matrix.processWithRouting(block, 1.0f, graph, 0.0f);
+    REQUIRE(block.getMagnitude(0, blockSize) > 0.1f);
+  }
 }
 
 TEST_CASE("Tempo sync calculations are precise", "[tempo][boundary]") {
@@ -1351,6 +4150,25 @@ TEST_CASE("ModulationEngine processes modulation", "[modulation][engine]") {
     }
   }
 
+  SECTION("Control-rate modulation tracks the per-sample signal") {
+    uds::ModulationEngine reduced;
+    reduced.prepare(44100.0, 512);
+    engine.setBandParams(0, uds::ModulationType::Sine, 2.0f, 1.0f);
+    reduced.setBandParams(0, uds::ModulationType::Sine, 2.0f, 1.0f);
+    reduced.setControlStride(16);
+    REQUIRE(reduced.getControlStride() == 16);
+
+    for (int block = 0; block < 8; ++block) {
+      engine.process(512);
+      reduced.process(512);
+      const float* full = engine.getLocalBuffer().getReadPointer(0);
+      const float* ramp = reduced.getLocalBuffer().getReadPointer(0);
+      // One stride of lag at most: 16 samples of a 2Hz sine
+      for (int i = 0; i < 512; ++i)
+        REQUIRE(std::abs(full[i] - ramp[i]) < 0.01f);
+    }
+  }
+
   SECTION("All 8 bands can have independent modulation") {
     // Set different params for each band
     for (int i = 0; i < 8; ++i) {
@@ -1469,7 +4287,7 @@ TEST_CASE("LFO Modulation produces measurable chorus effects",
   }
 
   SECTION("DelayBandNode applies modulation to delay time") {
-    uds::DelayBandNode band;
+    uds::DelayBandNode<float> band;
     band.prepare(SAMPLE_RATE, BLOCK_SIZE);
 
     // Create test signal - 1kHz sine wave
@@ -1690,7 +4508,7 @@ TEST_CASE("UD Stomp parameter scaling experiment", "[udstomP][scaling]") {
     std::cout << "\n--- FULL SIGNAL CHAIN MODULATION TEST ---" << std::endl;
     std::cout << "Processing actual audio through DelayBandNode\n" << std::endl;
 
-    uds::DelayBandNode band;
+    uds::DelayBandNode<float> band;
     band.prepare(SAMPLE_RATE, BLOCK_SIZE);
 
     // Test signal: 440 Hz sine (A4)